@@ -0,0 +1,293 @@
+#include "../src/assets.hpp"
+#include "../src/asset_pack.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_ASSET_DIR "/tmp/breakoutt_assets_test"
+#define TEST_ASSET_FILES 10
+#define TEST_PACK_PATH "/tmp/breakoutt_assets_test.pak"
+
+struct TestCaseAssets {
+public:
+    TestCaseAssets(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *AssetsFunctionName;
+    void (*TestAssetsFunction)(void);
+};
+
+TestCaseAssets::TestCaseAssets(const char *Name, void (*Fn)(void)):
+    AssetsFunctionName(Name), TestAssetsFunction(Fn) {}
+
+void TestCaseAssets::RunTestCase()
+{
+    TestAssetsFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", AssetsFunctionName);
+}
+
+static void TestAssetPath(char *path, uint32_t index)
+{
+    snprintf(path, ASSET_PATH_LENGTH, "%s/asset%u.txt", TEST_ASSET_DIR, index);
+}
+
+// NOTE: Every byte depends on the file and its offset so a wrong view shows up
+static void WriteTestAsset(uint32_t index, size_t size)
+{
+    char path[ASSET_PATH_LENGTH];
+    TestAssetPath(path, index);
+    FILE *file = fopen(path, "wb");
+    assert(file != nullptr);
+    for (size_t i = 0; i < size; ++i) fputc('a' + (int)((i + index) % 26), file);
+    fclose(file);
+}
+
+static bool CheckTestAsset(const Asset *asset, uint32_t index, size_t size)
+{
+    if (asset == nullptr || asset->view.size != size || asset->view.data[size] != '\0') return false;
+    for (size_t i = 0; i < size; ++i) {
+        if (asset->view.data[i] != 'a' + (int)((i + index) % 26)) return false;
+    }
+    return true;
+}
+
+static void RemoveTestAssets(void)
+{
+    // NOTE: Only what the tests write, never a recursive delete
+    char path[ASSET_PATH_LENGTH];
+    for (uint32_t i = 0; i < TEST_ASSET_FILES; ++i) {
+        TestAssetPath(path, i);
+        unlink(path);
+    }
+    rmdir(TEST_ASSET_DIR);
+}
+
+void TestAssetViews(void)
+{
+    RemoveTestAssets();
+    assert(mkdir(TEST_ASSET_DIR, 0755) == 0);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    // NOTE: Past the old 255 byte length limit, exactly one page (no slack for the terminator) and empty
+    WriteTestAsset(0, 300);
+    WriteTestAsset(1, page);
+    WriteTestAsset(2, 0);
+    WriteTestAsset(3, 3 * page + 17);
+
+    AssetLoader loader;
+    char path[ASSET_PATH_LENGTH];
+    const size_t sizes[4] = {300, page, 0, 3 * page + 17};
+    for (uint32_t i = 0; i < 4; ++i) {
+        TestAssetPath(path, i);
+        const Asset *asset = loader.Acquire(path);
+        assert(CheckTestAsset(asset, i, sizes[i]));
+        assert(strlen(asset->view.data) == sizes[i]);
+        loader.Release(asset);
+    }
+    assert(loader.entries.count == 0);
+    assert(loader.Acquire(TEST_ASSET_DIR "/missing.txt") == nullptr);
+    assert(loader.Acquire(TEST_ASSET_DIR) == nullptr);
+    RemoveTestAssets();
+}
+
+void TestAssetSharing(void)
+{
+    RemoveTestAssets();
+    assert(mkdir(TEST_ASSET_DIR, 0755) == 0);
+    WriteTestAsset(0, 1000);
+    char path[ASSET_PATH_LENGTH];
+    TestAssetPath(path, 0);
+
+    AssetLoader loader;
+    const Asset *first = loader.Acquire(path);
+    const Asset *second = loader.Acquire(path);
+    assert(first != nullptr && first == second && first->refs == 2);
+    assert(loader.maps == 1 && loader.shared == 1);
+
+    // NOTE: A file replaced on disk gets a new mapping, holders of the old one still read the old bytes
+    char temp[ASSET_PATH_LENGTH + 8];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE *file = fopen(temp, "wb");
+    assert(file != nullptr);
+    fputs("replaced", file);
+    fclose(file);
+    assert(rename(temp, path) == 0);
+    const Asset *replaced = loader.Acquire(path);
+    assert(replaced != nullptr && replaced != first);
+    assert(strcmp(replaced->view.data, "replaced") == 0);
+    assert(CheckTestAsset(first, 0, 1000));
+    assert(loader.entries.count == 2);
+
+    loader.Release(first);
+    assert(CheckTestAsset(second, 0, 1000));
+    loader.Release(second);
+    loader.Release(replaced);
+    assert(loader.entries.count == 0);
+    RemoveTestAssets();
+}
+
+void TestAssetPreload(void)
+{
+    RemoveTestAssets();
+    assert(mkdir(TEST_ASSET_DIR, 0755) == 0);
+    char paths[TEST_ASSET_FILES + 1][ASSET_PATH_LENGTH];
+    const char *path_list[TEST_ASSET_FILES + 1];
+    for (uint32_t i = 0; i < TEST_ASSET_FILES; ++i) {
+        WriteTestAsset(i, 5000 + i * 3000);
+        TestAssetPath(paths[i], i);
+        path_list[i] = paths[i];
+    }
+    snprintf(paths[TEST_ASSET_FILES], ASSET_PATH_LENGTH, "%s/missing.txt", TEST_ASSET_DIR);
+    path_list[TEST_ASSET_FILES] = paths[TEST_ASSET_FILES];
+
+    AssetLoader loader;
+    // NOTE: A missing file is skipped, the rest are mapped and pinned
+    assert(loader.Preload(path_list, TEST_ASSET_FILES + 1) == TEST_ASSET_FILES);
+    assert(loader.pinned.count == TEST_ASSET_FILES && loader.entries.count == TEST_ASSET_FILES);
+    assert(loader.maps == TEST_ASSET_FILES);
+
+    // NOTE: Loads after a preload share the pinned mappings
+    for (uint32_t i = 0; i < TEST_ASSET_FILES; ++i) {
+        const Asset *asset = loader.Acquire(paths[i]);
+        assert(CheckTestAsset(asset, i, 5000 + i * 3000));
+        loader.Release(asset);
+    }
+    assert(loader.maps == TEST_ASSET_FILES && loader.shared == TEST_ASSET_FILES);
+
+    // NOTE: Unpinning drops the last reference, a held asset outlives it
+    const Asset *held = loader.Acquire(paths[0]);
+    loader.Unpin();
+    assert(loader.pinned.count == 0 && loader.entries.count == 1);
+    assert(CheckTestAsset(held, 0, 5000));
+    loader.Release(held);
+    assert(loader.entries.count == 0);
+    RemoveTestAssets();
+}
+
+void TestAssetPackLookup(void)
+{
+    const char *names[3] = {"shader/a.vert", "./shader/b.frag", "levels/one.lvl"};
+    char big[5000];
+    memset(big, 'x', sizeof(big));
+    const AssetView contents[3] = {{"void main() {}", 14}, {"", 0}, {big, sizeof(big)}};
+    assert(WriteAssetPack(TEST_PACK_PATH, names, contents, 3));
+
+    AssetLoader loader;
+    const Asset *file = loader.Acquire(TEST_PACK_PATH);
+    assert(file != nullptr);
+    AssetPack pack;
+    assert(pack.Open(file->view.data, file->view.size, TEST_PACK_PATH));
+    assert(pack.asset_count == 3 && pack.slot_count >= 6);
+
+    AssetView view;
+    assert(pack.Find("shader/a.vert", &view) && view.size == 14 && strcmp(view.data, "void main() {}") == 0);
+    // NOTE: A leading "./" is dropped when packing and when looking up
+    assert(pack.Find("shader/b.frag", &view) && view.size == 0 && view.data[0] == '\0');
+    assert(pack.Find("./levels/one.lvl", &view) && view.size == sizeof(big) && view.data[sizeof(big)] == '\0');
+    assert(memcmp(view.data, big, sizeof(big)) == 0);
+    assert((uintptr_t)(view.data - file->view.data) % SOA_ALIGNMENT == 0);
+    assert(!pack.Find("shader/a.ver", &view) && !pack.Find("missing", &view));
+
+    // NOTE: Duplicate names are refused, a damaged index is caught on Open
+    const char *twice[2] = {"shader/a.vert", "./shader/a.vert"};
+    assert(!WriteAssetPack(TEST_PACK_PATH ".bad", twice, contents, 2));
+    char *copy = (char*)aligned_alloc(SOA_ALIGNMENT, (file->view.size + SOA_ALIGNMENT - 1) & ~(size_t)(SOA_ALIGNMENT - 1));
+    memcpy(copy, file->view.data, file->view.size);
+    const BlockFileBlock *blocks = blockfile_blocks(copy);
+    AssetPackEntry *slots = (AssetPackEntry*)(copy + blocks[0].offset);
+    for (uint32_t i = 0; i < blocks[0].count; ++i) {
+        if (slots[i].name_length != 0) slots[i].size = file->view.size;
+    }
+    AssetPack damaged;
+    assert(!damaged.Open(copy, file->view.size, "damaged"));
+    free(copy);
+
+    loader.Release(file);
+    unlink(TEST_PACK_PATH);
+}
+
+void TestAssetPackMount(void)
+{
+    RemoveTestAssets();
+    assert(mkdir(TEST_ASSET_DIR, 0755) == 0);
+    char loose[ASSET_PATH_LENGTH], level_path[ASSET_PATH_LENGTH];
+    TestAssetPath(loose, 0);
+    TestAssetPath(level_path, 1);
+    WriteTestAsset(0, 100);
+
+    // NOTE: A level built the usual way, then packed under a path that no longer exists on disk
+    Game source;
+    source.AddBrick(0.0f, 0.5f, 0.1f, 0.05f, 2, 1, 3);
+    source.AddBrick(0.2f, 0.5f, 0.1f, 0.05f, 1, 0, 1);
+    LevelInfo info = {2, 1, 2};
+    assert(SaveLevel(&source.bricks, &info, level_path));
+    AssetLoader reader;
+    const Asset *level_file = reader.Acquire(level_path);
+    assert(level_file != nullptr);
+    const char *names[2] = {loose, level_path};
+    const AssetView contents[2] = {{"packed", 6}, level_file->view};
+    assert(WriteAssetPack(TEST_PACK_PATH, names, contents, 2));
+    reader.Release(level_file);
+    unlink(level_path);
+
+    const Asset *file = reader.Acquire(TEST_PACK_PATH);
+    AssetPack pack;
+    assert(file != nullptr && pack.Open(file->view.data, file->view.size, TEST_PACK_PATH));
+    assets.Mount(&pack);
+
+    // NOTE: Packed assets win and cost no mapping
+    const Asset *asset = assets.Acquire(loose);
+    assert(asset != nullptr && strcmp(asset->view.data, "packed") == 0 && asset->mapping == nullptr);
+    assert(assets.Acquire(loose) == asset && assets.maps == 0 && assets.packed == 1);
+    assets.Release(asset);
+    assets.Release(asset);
+
+    // NOTE: The development override reads loose files that exist, and still falls back to the pack
+    assets.loose_first = true;
+    asset = assets.Acquire(loose);
+    assert(CheckTestAsset(asset, 0, 100) && asset->mapping != nullptr);
+    assets.Release(asset);
+    Game game;
+    LevelInfo loaded = {};
+    assert(LoadLevel(&game, level_path, &loaded));
+    assert(loaded.brick_count == 2 && game.bricks.count == 2 && game.bricks.hp[0] == 2 && game.bricks.color[0] == 3);
+    // NOTE: The copied level is private, breaking bricks leaves the pack alone
+    game.bricks.hp[0] = 0;
+    AssetView view;
+    assert(pack.Find(level_path, &view));
+    Game again;
+    assert(LoadLevel(&again, level_path, nullptr) && again.bricks.hp[0] == 2);
+
+    assets.loose_first = false;
+    assets.Mount(nullptr);
+    assert(assets.entries.count == 0);
+    reader.Release(file);
+    unlink(TEST_PACK_PATH);
+    RemoveTestAssets();
+}
+
+typedef ARRAY(TestCaseAssets) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseAssets);
+
+    array_append(TestCaseAssets, &Tests, TestCaseAssets("TestAssetViews", TestAssetViews));
+    array_append(TestCaseAssets, &Tests, TestCaseAssets("TestAssetSharing", TestAssetSharing));
+    array_append(TestCaseAssets, &Tests, TestCaseAssets("TestAssetPreload", TestAssetPreload));
+    array_append(TestCaseAssets, &Tests, TestCaseAssets("TestAssetPackLookup", TestAssetPackLookup));
+    array_append(TestCaseAssets, &Tests, TestCaseAssets("TestAssetPackMount", TestAssetPackMount));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
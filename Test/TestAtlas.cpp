@@ -0,0 +1,208 @@
+#include "../src/atlas.hpp"
+#include "../src/blockfile.hpp"
+#include "../src/random.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cstring>
+
+#define TEST_ATLAS_PATH "/tmp/breakoutt_atlas_test.atl"
+#define TEST_IMAGE_PATH "/tmp/breakoutt_atlas_test.pam"
+
+struct TestCaseAtlas {
+public:
+    TestCaseAtlas(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *AtlasFunctionName;
+    void (*TestAtlasFunction)(void);
+};
+
+TestCaseAtlas::TestCaseAtlas(const char *Name, void (*Fn)(void)):
+    AtlasFunctionName(Name), TestAtlasFunction(Fn) {}
+
+void TestCaseAtlas::RunTestCase()
+{
+    TestAtlasFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", AtlasFunctionName);
+}
+
+static uint32_t AtlasPixel(const Atlas *atlas, uint32_t x, uint32_t y)
+{
+    return atlas->pixels[(size_t)y * atlas->width + x];
+}
+
+// NOTE: Every texel of an image gets a value only it has, so misplaced blits show up
+static void MakeImages(AtlasImage *images, char (*names)[ATLAS_NAME_LENGTH], uint32_t count, uint64_t seed)
+{
+    Rng rng(seed);
+    for (uint32_t i = 0; i < count; ++i) {
+        images[i].width = 1 + rng.Below(40);
+        images[i].height = 1 + rng.Below(40);
+        images[i].pixels = (uint32_t*)malloc((size_t)images[i].width * images[i].height * sizeof(uint32_t));
+        for (uint32_t p = 0; p < images[i].width * images[i].height; ++p) images[i].pixels[p] = (i << 16) | p;
+        snprintf(names[i], ATLAS_NAME_LENGTH, "sprite%u", i);
+    }
+}
+
+void TestAtlasPacking(void)
+{
+    const uint32_t count = 60;
+    AtlasImage images[count];
+    char names[count][ATLAS_NAME_LENGTH];
+    const char *name_list[count];
+    MakeImages(images, names, count, 5);
+    for (uint32_t i = 0; i < count; ++i) name_list[i] = names[i];
+
+    Atlas atlas;
+    assert(BuildAtlas(&atlas, images, name_list, count, 4096));
+    assert(atlas.sprite_count == count + 1);
+    assert((atlas.width & (atlas.width - 1)) == 0 && atlas.width == atlas.height);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t found = atlas.Find(names[i]);
+        assert(found >= 0);
+        const AtlasSprite *sprite = &atlas.sprites[found];
+        assert(sprite->width == images[i].width && sprite->height == images[i].height);
+        assert(sprite->x >= ATLAS_PADDING && sprite->x + sprite->width + ATLAS_PADDING <= atlas.width);
+        assert(sprite->y >= ATLAS_PADDING && sprite->y + sprite->height + ATLAS_PADDING <= atlas.height);
+        assert(sprite->u0 * atlas.width == (float)sprite->x && sprite->v1 * atlas.height == (float)(sprite->y + sprite->height));
+        for (uint32_t y = 0; y < sprite->height; ++y) {
+            for (uint32_t x = 0; x < sprite->width; ++x) {
+                assert(AtlasPixel(&atlas, sprite->x + x, sprite->y + y) == images[i].pixels[y * sprite->width + x]);
+            }
+        }
+        // NOTE: Padding repeats the edge, corners included
+        assert(AtlasPixel(&atlas, sprite->x - 1, sprite->y - 1) == images[i].pixels[0]);
+        assert(AtlasPixel(&atlas, sprite->x + sprite->width, sprite->y) == images[i].pixels[sprite->width - 1]);
+
+        // NOTE: Padded rects never overlap
+        for (uint32_t k = 0; k < atlas.sprite_count; ++k) {
+            const AtlasSprite *other = &atlas.sprites[k];
+            if (other == sprite) continue;
+            bool apart = sprite->x + sprite->width + ATLAS_PADDING <= other->x - ATLAS_PADDING ||
+                         other->x + other->width + ATLAS_PADDING <= sprite->x - ATLAS_PADDING ||
+                         sprite->y + sprite->height + ATLAS_PADDING <= other->y - ATLAS_PADDING ||
+                         other->y + other->height + ATLAS_PADDING <= sprite->y - ATLAS_PADDING;
+            assert(apart);
+        }
+    }
+    assert(atlas.Find("missing") == -1);
+    for (uint32_t i = 0; i < count; ++i) FreeImage(&images[i]);
+}
+
+void TestAtlasWhiteSprite(void)
+{
+    Atlas atlas;
+    assert(BuildAtlas(&atlas, nullptr, nullptr, 0, 64));
+    assert(atlas.sprite_count == 1 && atlas.Find(ATLAS_WHITE) == 0);
+    const AtlasSprite *white = &atlas.sprites[0];
+    assert(white->width == 1 && white->height == 1);
+    assert(AtlasPixel(&atlas, white->x, white->y) == 0xFFFFFFFFu);
+}
+
+void TestAtlasLimits(void)
+{
+    AtlasImage big = {};
+    big.width = 100;
+    big.height = 20;
+    big.pixels = (uint32_t*)calloc(big.width * big.height, sizeof(uint32_t));
+    const char *name = "big";
+    Atlas atlas;
+    assert(!BuildAtlas(&atlas, &big, &name, 1, 64));
+    assert(BuildAtlas(&atlas, &big, &name, 1, 128));
+    assert(atlas.width == 128);
+
+    const char *long_name = "a_sprite_name_that_is_far_too_long";
+    assert(!BuildAtlas(&atlas, &big, &long_name, 1, 128));
+    FreeImage(&big);
+}
+
+void TestAtlasSaveLoad(void)
+{
+    AtlasImage images[ATLAS_SKIN_SPRITES];
+    for (uint32_t i = 0; i < ATLAS_SKIN_SPRITES; ++i) MakeSkinSprite(i, &images[i]);
+    Atlas packed;
+    assert(BuildAtlas(&packed, images, SkinSpriteNames, ATLAS_SKIN_SPRITES, 1024));
+    assert(SaveAtlas(&packed, TEST_ATLAS_PATH));
+
+    Atlas loaded;
+    assert(LoadAtlas(&loaded, TEST_ATLAS_PATH));
+    assert(loaded.mapping != nullptr);
+    assert(loaded.width == packed.width && loaded.height == packed.height && loaded.sprite_count == packed.sprite_count);
+    assert(memcmp(loaded.sprites, packed.sprites, packed.sprite_count * sizeof(AtlasSprite)) == 0);
+    assert(memcmp(loaded.pixels, packed.pixels, (size_t)packed.width * packed.height * sizeof(uint32_t)) == 0);
+    for (uint32_t i = 0; i < ATLAS_SKIN_SPRITES; ++i) assert(loaded.Find(SkinSpriteNames[i]) >= 0);
+
+    // NOTE: A sprite pointing outside the texture is rejected
+    FILE *file = fopen(TEST_ATLAS_PATH, "r+b");
+    assert(file != nullptr);
+    const BlockFileBlock *blocks = (const BlockFileBlock*)((const char*)loaded.mapping + ((const BlockFileHeader*)loaded.mapping)->header_size);
+    fseek(file, (long)(blocks[0].offset + offsetof(AtlasSprite, x)), SEEK_SET);
+    uint32_t outside = loaded.width;
+    fwrite(&outside, sizeof(outside), 1, file);
+    fclose(file);
+    Atlas corrupt;
+    assert(!LoadAtlas(&corrupt, TEST_ATLAS_PATH));
+
+    for (uint32_t i = 0; i < ATLAS_SKIN_SPRITES; ++i) FreeImage(&images[i]);
+    remove(TEST_ATLAS_PATH);
+}
+
+void TestAtlasLoadImage(void)
+{
+    FILE *file = fopen(TEST_IMAGE_PATH, "wb");
+    assert(file != nullptr);
+    fprintf(file, "P7\nWIDTH 2\nHEIGHT 2\nDEPTH 4\nMAXVAL 255\n# comment\nTUPLTYPE RGB_ALPHA\nENDHDR\n");
+    const uint8_t raster[16] = {255, 0, 0, 255, 0, 255, 0, 128, 0, 0, 255, 0, 1, 2, 3, 4};
+    fwrite(raster, 1, sizeof(raster), file);
+    fclose(file);
+
+    AtlasImage image = {};
+    assert(LoadImage(TEST_IMAGE_PATH, &image));
+    assert(image.width == 2 && image.height == 2);
+    assert(image.pixels[0] == 0xFF0000FFu && image.pixels[1] == 0x8000FF00u);
+    assert(image.pixels[2] == 0x00FF0000u && image.pixels[3] == 0x04030201u);
+    FreeImage(&image);
+
+    file = fopen(TEST_IMAGE_PATH, "wb");
+    fprintf(file, "P6\n3 1\n255\n");
+    const uint8_t rgb[9] = {10, 20, 30, 40, 50, 60, 70, 80, 90};
+    fwrite(rgb, 1, sizeof(rgb), file);
+    fclose(file);
+    assert(LoadImage(TEST_IMAGE_PATH, &image));
+    assert(image.width == 3 && image.height == 1 && image.pixels[2] == 0xFF5A5046u);
+    FreeImage(&image);
+
+    // NOTE: Truncated raster
+    file = fopen(TEST_IMAGE_PATH, "wb");
+    fprintf(file, "P6\n4 4\n255\n");
+    fwrite(rgb, 1, sizeof(rgb), file);
+    fclose(file);
+    assert(!LoadImage(TEST_IMAGE_PATH, &image));
+    remove(TEST_IMAGE_PATH);
+}
+
+typedef ARRAY(TestCaseAtlas) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseAtlas);
+
+    array_append(TestCaseAtlas, &Tests, TestCaseAtlas("TestAtlasPacking", TestAtlasPacking));
+    array_append(TestCaseAtlas, &Tests, TestCaseAtlas("TestAtlasWhiteSprite", TestAtlasWhiteSprite));
+    array_append(TestCaseAtlas, &Tests, TestCaseAtlas("TestAtlasLimits", TestAtlasLimits));
+    array_append(TestCaseAtlas, &Tests, TestCaseAtlas("TestAtlasSaveLoad", TestAtlasSaveLoad));
+    array_append(TestCaseAtlas, &Tests, TestCaseAtlas("TestAtlasLoadImage", TestAtlasLoadImage));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
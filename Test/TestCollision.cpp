@@ -0,0 +1,198 @@
+#include "../src/game.hpp"
+#include "../util/math_util.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+
+struct TestCaseCollision {
+public:
+    TestCaseCollision(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *CollisionFunctionName;
+    void (*TestCollisionFunction)(void);
+};
+
+TestCaseCollision::TestCaseCollision(const char *Name, void (*Fn)(void)):
+    CollisionFunctionName(Name), TestCollisionFunction(Fn) {}
+
+void TestCaseCollision::RunTestCase()
+{
+    TestCollisionFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", CollisionFunctionName);
+}
+
+static uint32_t test_seed = 0x12345678u;
+static float RandomFloat(float min, float max)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 17;
+    test_seed ^= test_seed << 5;
+    return min + (max - min) * ((test_seed >> 8) * (1.0f / 16777216.0f));
+}
+
+void TestCollisionFaceHit(void)
+{
+    Contact contact;
+    // NOTE: Ball at x = -1 moving +2 hits the face at x = 0 when its edge (r = 0.5) arrives, t = 0.25
+    assert(CircleVsAabb(-1.0f, 0.0f, 0.5f, 2.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f, &contact));
+    assert(almostEqual(contact.t, 0.25f));
+    assert(contact.nx == -1.0f && contact.ny == 0.0f);
+    assert(contact.depth == 0.0f);
+
+    // NOTE: Moving away never hits
+    assert(!CircleVsAabb(-1.0f, 0.0f, 0.5f, -2.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f, &contact));
+    // NOTE: Too short a step
+    assert(!CircleVsAabb(-1.0f, 0.0f, 0.5f, 0.4f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f, &contact));
+}
+
+void TestCollisionCorner(void)
+{
+    Contact contact;
+    // NOTE: Diagonal approach to the corner (0, 0) of the box [0,1]x[0,1]
+    float r = 0.1f;
+    float start = -1.0f;
+    assert(CircleVsAabb(start, start, r, 2.0f, 2.0f, 0.0f, 0.0f, 1.0f, 1.0f, &contact));
+    // NOTE: Contact when the center is r away from the corner along the diagonal
+    float expected = (-start - r / sqrtf(2.0f)) / 2.0f;
+    assert(almostEqual(contact.t, expected));
+    assert(almostEqual(contact.nx, -sqrtf(0.5f)) && almostEqual(contact.ny, -sqrtf(0.5f)));
+
+    // NOTE: Inside the grown box's corner but outside the rounded corner, passes by
+    // NOTE: The path x + y = -0.15 clears the corner by 0.106
+    assert(!CircleVsAabb(-0.3f, 0.15f, r, 0.45f, -0.45f, 0.0f, 0.0f, 1.0f, 1.0f, &contact));
+}
+
+void TestCollisionOverlap(void)
+{
+    Contact contact;
+    assert(CircleVsAabb(-0.05f, 0.5f, 0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, &contact));
+    assert(almostEqual(contact.depth, 0.05f));
+    assert(contact.nx == -1.0f && contact.ny == 0.0f);
+    assert(contact.t == 0.0f);
+
+    // NOTE: Center inside, pushed through the nearest face
+    assert(CircleVsAabb(0.5f, 0.9f, 0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, &contact));
+    assert(contact.nx == 0.0f && contact.ny == 1.0f);
+    assert(almostEqual(contact.depth, 0.2f));
+}
+
+void TestCollisionPackOrdering(void)
+{
+    AabbPack pack = {};
+    aabb_pack_push(&pack, 3.0f, -1.0f, 4.0f, 1.0f, 30);
+    aabb_pack_push(&pack, 1.0f, -1.0f, 2.0f, 1.0f, 10);
+    aabb_pack_push(&pack, 2.0f, -1.0f, 3.0f, 1.0f, 20);
+
+    Contact contact;
+    assert(CircleVsAabbs(0.0f, 0.0f, 0.1f, 5.0f, 0.0f, &pack, &contact));
+    assert(contact.id == 10 && contact.index == 1);
+
+    // NOTE: Overlaps beat swept hits, the deepest overlap wins
+    aabb_pack_push(&pack, -0.5f, -1.0f, -0.08f, 1.0f, 40);
+    aabb_pack_push(&pack, 0.05f, -1.0f, 0.5f, 1.0f, 50);
+    assert(CircleVsAabbs(0.0f, 0.0f, 0.1f, 5.0f, 0.0f, &pack, &contact));
+    assert(contact.id == 50);
+    assert(almostEqual(contact.depth, 0.05f));
+    aabb_pack_free(&pack);
+}
+
+static bool ContactsEqual(const Contact *a, const Contact *b)
+{
+    return a->index == b->index && a->id == b->id && a->t == b->t &&
+           a->nx == b->nx && a->ny == b->ny && a->depth == b->depth;
+}
+
+// NOTE: SIMD kernel and scalar reference must agree bit for bit on random inputs
+void TestCollisionSimdMatchesScalar(void)
+{
+    AabbPack pack = {};
+    uint32_t hits = 0;
+    for (uint32_t trial = 0; trial < 20000; ++trial) {
+        aabb_pack_clear(&pack);
+        uint32_t count = (uint32_t)RandomFloat(0.0f, 40.0f);
+        for (uint32_t i = 0; i < count; ++i) {
+            float x = RandomFloat(-1.0f, 1.0f);
+            float y = RandomFloat(-1.0f, 1.0f);
+            float w = RandomFloat(0.01f, 0.3f);
+            float h = RandomFloat(0.01f, 0.2f);
+            aabb_pack_push(&pack, x, y, x + w, y + h, i);
+        }
+        // NOTE: Duplicate boxes exercise the tie break
+        if (count > 5) aabb_pack_push(&pack, pack.min_x[2], pack.min_y[2], pack.max_x[2], pack.max_y[2], 99);
+
+        float cx = RandomFloat(-1.2f, 1.2f);
+        float cy = RandomFloat(-1.2f, 1.2f);
+        float r = RandomFloat(0.005f, 0.1f);
+        float dx = RandomFloat(-0.5f, 0.5f);
+        float dy = RandomFloat(-0.5f, 0.5f);
+        uint32_t mode = trial % 8;
+        if (mode == 1) dx = 0.0f;
+        if (mode == 2) dy = 0.0f;
+        if (mode == 3) dx = dy = 0.0f;
+
+        Contact simd = {}, scalar = {};
+        bool simd_hit = CircleVsAabbs(cx, cy, r, dx, dy, &pack, &simd);
+        bool scalar_hit = CircleVsAabbsScalar(cx, cy, r, dx, dy, &pack, &scalar);
+        assert(simd_hit == scalar_hit);
+        if (simd_hit) {
+            assert(ContactsEqual(&simd, &scalar));
+            assert(simd.t >= 0.0f && simd.t <= 1.0f);
+            assert(almostEqual(simd.nx * simd.nx + simd.ny * simd.ny, 1.0f));
+            hits++;
+        }
+    }
+    // NOTE: Make sure the property test is not vacuous
+    assert(hits > 5000);
+    aabb_pack_free(&pack);
+}
+
+void TestCollisionGameBreaksBrick(void)
+{
+    Game game;
+    game.AddBall(0.0f, 0.0f, 0.05f, 0.0f, 1.0f);
+    game.AddBrick(0.0f, 0.5f, 0.4f, 0.1f, 1, 0, 3);
+    game.AddBrick(0.5f, 0.5f, 0.4f, 0.1f, 2, 0, 3);
+
+    bool broke = false;
+    for (int i = 0; i < 60 && !broke; ++i) {
+        game.GameUpdate(nullptr);
+        broke = game.broken.count == 1;
+    }
+    assert(broke);
+    assert(game.broken.items[0] == 0);
+    assert(game.bricks.hp[0] == 0 && game.bricks.hp[1] == 2);
+    assert(game.score == 1);
+    assert(game.balls.vy[0] < 0.0f);
+
+    // NOTE: A destroyed brick no longer collides
+    game.balls.x[0] = 0.0f;
+    game.balls.y[0] = 0.5f;
+    game.GameUpdate(nullptr);
+    assert(game.broken.count == 0 && game.score == 1);
+}
+
+typedef ARRAY(TestCaseCollision) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseCollision);
+
+    array_append(TestCaseCollision, &Tests, TestCaseCollision("TestCollisionFaceHit", TestCollisionFaceHit));
+    array_append(TestCaseCollision, &Tests, TestCaseCollision("TestCollisionCorner", TestCollisionCorner));
+    array_append(TestCaseCollision, &Tests, TestCaseCollision("TestCollisionOverlap", TestCollisionOverlap));
+    array_append(TestCaseCollision, &Tests, TestCaseCollision("TestCollisionPackOrdering", TestCollisionPackOrdering));
+    array_append(TestCaseCollision, &Tests, TestCaseCollision("TestCollisionSimdMatchesScalar", TestCollisionSimdMatchesScalar));
+    array_append(TestCaseCollision, &Tests, TestCaseCollision("TestCollisionGameBreaksBrick", TestCollisionGameBreaksBrick));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
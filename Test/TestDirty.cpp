@@ -0,0 +1,157 @@
+#include "../src/dirty.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cstring>
+
+struct TestCaseDirty {
+public:
+    TestCaseDirty(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *DirtyFunctionName;
+    void (*TestDirtyFunction)(void);
+};
+
+TestCaseDirty::TestCaseDirty(const char *Name, void (*Fn)(void)):
+    DirtyFunctionName(Name), TestDirtyFunction(Fn) {}
+
+void TestCaseDirty::RunTestCase()
+{
+    TestDirtyFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", DirtyFunctionName);
+}
+
+static bool HasRange(const DirtyTracker *tracker, uint32_t first, uint32_t count)
+{
+    for (uint32_t i = 0; i < tracker->ranges.count; ++i) {
+        if (tracker->ranges.items[i].first == first && tracker->ranges.items[i].count == count) return true;
+    }
+    return false;
+}
+
+void TestDirtyResizeMarksAll(void)
+{
+    DirtyTracker tracker;
+    assert(!tracker.Dirty());
+    assert(tracker.Collect(0) == 0);
+
+    tracker.Resize(130);
+    assert(tracker.Dirty());
+    assert(tracker.Collect(0) == 1 && HasRange(&tracker, 0, 130));
+    assert(!tracker.Dirty());
+    assert(tracker.Collect(0) == 0);
+
+    // NOTE: Shrinking keeps no stale bits past the new end
+    tracker.Resize(70);
+    assert(tracker.Collect(0) == 1 && HasRange(&tracker, 0, 70));
+}
+
+void TestDirtyCoalesce(void)
+{
+    DirtyTracker tracker;
+    tracker.Resize(256);
+    tracker.Collect(0);
+
+    tracker.Mark(10);
+    tracker.Mark(11);
+    tracker.Mark(14);
+    tracker.Mark(63);
+    tracker.Mark(64);
+    tracker.Mark(200);
+    tracker.Mark(11); // NOTE: Marking twice is the same as once
+
+    assert(tracker.low == 10 && tracker.high == 200);
+    assert(tracker.Collect(0) == 4);
+    assert(HasRange(&tracker, 10, 2) && HasRange(&tracker, 14, 1));
+    assert(HasRange(&tracker, 63, 2) && HasRange(&tracker, 200, 1));
+
+    // NOTE: A gap of two clean slots is bridged only when max_gap allows it
+    tracker.Mark(10);
+    tracker.Mark(11);
+    tracker.Mark(14);
+    assert(tracker.Collect(1) == 2);
+    tracker.Mark(10);
+    tracker.Mark(11);
+    tracker.Mark(14);
+    assert(tracker.Collect(2) == 1 && HasRange(&tracker, 10, 5));
+}
+
+void TestDirtyMarkOrder(void)
+{
+    DirtyTracker tracker;
+    tracker.Resize(1000);
+    tracker.Collect(0);
+
+    // NOTE: Marks out of order still come back sorted
+    tracker.Mark(999);
+    tracker.Mark(0);
+    tracker.Mark(500);
+    assert(tracker.low == 0 && tracker.high == 999);
+    assert(tracker.Collect(0) == 3);
+    assert(tracker.ranges.items[0].first == 0);
+    assert(tracker.ranges.items[1].first == 500);
+    assert(tracker.ranges.items[2].first == 999);
+}
+
+// NOTE: Random marks against a plain bool per slot
+void TestDirtyRandom(void)
+{
+    const uint32_t count = 777;
+    DirtyTracker tracker;
+    tracker.Resize(count);
+    tracker.Collect(0);
+
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    bool marked[count];
+    for (uint32_t round = 0; round < 200; ++round) {
+        memset(marked, 0, sizeof(marked));
+        uint32_t marks = (uint32_t)(state % 40);
+        for (uint32_t m = 0; m < marks; ++m) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            uint32_t slot = (uint32_t)(state >> 33) % count;
+            marked[slot] = true;
+            tracker.Mark(slot);
+        }
+        uint32_t gap = round % 4;
+        tracker.Collect(gap);
+
+        bool covered[count];
+        memset(covered, 0, sizeof(covered));
+        uint32_t end = 0;
+        for (uint32_t r = 0; r < tracker.ranges.count; ++r) {
+            const DirtyRange *range = &tracker.ranges.items[r];
+            assert(range->count > 0 && range->first + range->count <= count);
+            // NOTE: Sorted, and split only where more than `gap` clean slots separate them
+            if (r > 0) assert(range->first > end + gap);
+            assert(marked[range->first] && marked[range->first + range->count - 1]);
+            for (uint32_t s = range->first; s < range->first + range->count; ++s) covered[s] = true;
+            end = range->first + range->count;
+        }
+        for (uint32_t s = 0; s < count; ++s) assert(!marked[s] || covered[s]);
+        assert(!tracker.Dirty());
+    }
+}
+
+typedef ARRAY(TestCaseDirty) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseDirty);
+
+    array_append(TestCaseDirty, &Tests, TestCaseDirty("TestDirtyResizeMarksAll", TestDirtyResizeMarksAll));
+    array_append(TestCaseDirty, &Tests, TestCaseDirty("TestDirtyCoalesce", TestDirtyCoalesce));
+    array_append(TestCaseDirty, &Tests, TestCaseDirty("TestDirtyMarkOrder", TestDirtyMarkOrder));
+    array_append(TestCaseDirty, &Tests, TestCaseDirty("TestDirtyRandom", TestDirtyRandom));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
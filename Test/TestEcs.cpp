@@ -0,0 +1,143 @@
+#include "../src/ecs.hpp"
+#include "../util/math_util.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+
+#define MOVING (COMPONENT_BIT(COMPONENT_TRANSFORM) | COMPONENT_BIT(COMPONENT_VELOCITY))
+#define BRICK  (COMPONENT_BIT(COMPONENT_TRANSFORM) | COMPONENT_BIT(COMPONENT_COLLIDER) | COMPONENT_BIT(COMPONENT_BRICK_HEALTH))
+
+struct TestCaseEcs {
+public:
+    TestCaseEcs(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *EcsFunctionName;
+    void (*TestEcsFunction)(void);
+};
+
+TestCaseEcs::TestCaseEcs(const char *Name, void (*Fn)(void)):
+    EcsFunctionName(Name), TestEcsFunction(Fn) {}
+
+void TestCaseEcs::RunTestCase()
+{
+    TestEcsFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", EcsFunctionName);
+}
+
+void TestEcsCreateGet(void)
+{
+    World world;
+    Entity e = world.Create(MOVING);
+    assert(world.Alive(e));
+    Transform *t = (Transform*)world.Get(e, COMPONENT_TRANSFORM);
+    assert(t != nullptr && t->x == 0.0f);
+    assert(world.Get(e, COMPONENT_COLLIDER) == nullptr);
+    t->x = 3.0f;
+    assert(((Transform*)world.Get(e, COMPONENT_TRANSFORM))->x == 3.0f);
+}
+
+void TestEcsDestroyKeepsOthers(void)
+{
+    World world;
+    Entity entities[100];
+    for (uint32_t i = 0; i < 100; ++i) {
+        entities[i] = world.Create(BRICK);
+        ((BrickHealth*)world.Get(entities[i], COMPONENT_BRICK_HEALTH))->hp = (uint8_t)i;
+    }
+    for (uint32_t i = 0; i < 100; i += 3) world.Destroy(entities[i]);
+
+    for (uint32_t i = 0; i < 100; ++i) {
+        if (i % 3 == 0) {
+            assert(!world.Alive(entities[i]));
+            assert(world.Get(entities[i], COMPONENT_BRICK_HEALTH) == nullptr);
+        } else {
+            assert(((BrickHealth*)world.Get(entities[i], COMPONENT_BRICK_HEALTH))->hp == i);
+        }
+    }
+
+    // NOTE: Recycled records get a new generation, stale handles stay dead
+    Entity recycled = world.Create(BRICK);
+    assert(ENTITY_INDEX(recycled) == ENTITY_INDEX(entities[99]));
+    assert(!world.Alive(entities[99]));
+    assert(world.alive_count == 67);
+}
+
+void TestEcsQueryMatchesSupersets(void)
+{
+    World world;
+    for (int i = 0; i < 10; ++i) world.Create(MOVING);
+    for (int i = 0; i < 5; ++i) world.Create(MOVING | COMPONENT_BIT(COMPONENT_RENDERABLE));
+    for (int i = 0; i < 20; ++i) world.Create(BRICK);
+
+    uint32_t seen = 0;
+    uint32_t chunks = 0;
+    Query query = world.Each(MOVING);
+    QueryChunk chunk;
+    while (query.Next(&chunk)) {
+        assert(chunk.columns[COMPONENT_TRANSFORM] && chunk.columns[COMPONENT_VELOCITY]);
+        assert(chunk.columns[COMPONENT_RENDERABLE] == nullptr);
+        seen += chunk.count;
+        chunks++;
+    }
+    assert(seen == 15 && chunks == 2);
+}
+
+void TestEcsSetComponents(void)
+{
+    World world;
+    Entity a = world.Create(MOVING);
+    Entity b = world.Create(MOVING);
+    ((Transform*)world.Get(a, COMPONENT_TRANSFORM))->y = 5.0f;
+    ((Transform*)world.Get(b, COMPONENT_TRANSFORM))->y = 7.0f;
+
+    world.SetComponents(a, MOVING | COMPONENT_BIT(COMPONENT_RENDERABLE));
+    assert(((Transform*)world.Get(a, COMPONENT_TRANSFORM))->y == 5.0f);
+    assert(world.Get(a, COMPONENT_RENDERABLE) != nullptr);
+    assert(((Transform*)world.Get(b, COMPONENT_TRANSFORM))->y == 7.0f);
+
+    world.SetComponents(a, COMPONENT_BIT(COMPONENT_TRANSFORM));
+    assert(world.Get(a, COMPONENT_VELOCITY) == nullptr);
+    assert(((Transform*)world.Get(a, COMPONENT_TRANSFORM))->y == 5.0f);
+}
+
+void TestEcsIntegrateSystem(void)
+{
+    World world;
+    Entity moving = world.Create(MOVING);
+    Entity still = world.Create(BRICK);
+    Velocity *v = (Velocity*)world.Get(moving, COMPONENT_VELOCITY);
+    v->x = 1.0f;
+    v->y = -2.0f;
+
+    for (int i = 0; i < 60; ++i) IntegrateSystem(&world, 1.0f / 60.0f);
+
+    Transform *t = (Transform*)world.Get(moving, COMPONENT_TRANSFORM);
+    assert(almostEqual(t->x, 1.0f));
+    assert(almostEqual(t->y, -2.0f));
+    assert(((Transform*)world.Get(still, COMPONENT_TRANSFORM))->x == 0.0f);
+}
+
+typedef ARRAY(TestCaseEcs) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseEcs);
+
+    array_append(TestCaseEcs, &Tests, TestCaseEcs("TestEcsCreateGet", TestEcsCreateGet));
+    array_append(TestCaseEcs, &Tests, TestCaseEcs("TestEcsDestroyKeepsOthers", TestEcsDestroyKeepsOthers));
+    array_append(TestCaseEcs, &Tests, TestCaseEcs("TestEcsQueryMatchesSupersets", TestEcsQueryMatchesSupersets));
+    array_append(TestCaseEcs, &Tests, TestCaseEcs("TestEcsSetComponents", TestEcsSetComponents));
+    array_append(TestCaseEcs, &Tests, TestCaseEcs("TestEcsIntegrateSystem", TestEcsIntegrateSystem));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include "../src/events.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cstring>
+
+struct TestCaseEvents {
+public:
+    TestCaseEvents(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *EventsFunctionName;
+    void (*TestEventsFunction)(void);
+};
+
+TestCaseEvents::TestCaseEvents(const char *Name, void (*Fn)(void)):
+    EventsFunctionName(Name), TestEventsFunction(Fn) {}
+
+void TestCaseEvents::RunTestCase()
+{
+    TestEventsFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", EventsFunctionName);
+}
+
+static uint32_t test_seed = 0x9e3779b9u;
+static float RandomFloat(float min, float max)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 17;
+    test_seed ^= test_seed << 5;
+    return min + (max - min) * ((test_seed >> 8) * (1.0f / 16777216.0f));
+}
+
+// NOTE: A grid of bricks in the upper half, `holes` out of every 8 left empty to make it sparse
+static void SetupGame(Game *game, uint32_t ball_count, uint32_t holes)
+{
+    game->AddPaddle(0.0f, -0.9f, 0.4f, 0.05f, 2.0f);
+    for (uint32_t row = 0; row < 8; ++row) {
+        for (uint32_t col = 0; col < 16; ++col) {
+            if ((row * 16 + col) % 8 < holes) continue;
+            game->AddBrick(-0.9375f + col * 0.125f, 0.2f + row * 0.08f, 0.12f, 0.07f,
+                           (uint8_t)(1 + (row + col) % 3), 0, (uint8_t)(row % LEVEL_MAX_COLORS));
+        }
+    }
+    for (uint32_t i = 0; i < ball_count; ++i) {
+        game->AddBall(RandomFloat(-0.8f, 0.8f), RandomFloat(-0.6f, 0.0f), RandomFloat(0.01f, 0.04f),
+                      RandomFloat(-1.5f, 1.5f), RandomFloat(-1.5f, 1.5f));
+    }
+}
+
+static void AssertSameState(const Game *a, const Game *b)
+{
+    assert(a->tick == b->tick);
+    assert(a->score == b->score);
+    assert(a->balls.count == b->balls.count);
+    uint32_t n = a->balls.count;
+    assert(memcmp(a->balls.x, b->balls.x, n * sizeof(float)) == 0);
+    assert(memcmp(a->balls.y, b->balls.y, n * sizeof(float)) == 0);
+    assert(memcmp(a->balls.vx, b->balls.vx, n * sizeof(float)) == 0);
+    assert(memcmp(a->balls.vy, b->balls.vy, n * sizeof(float)) == 0);
+    assert(a->bricks.count == b->bricks.count);
+    assert(memcmp(a->bricks.hp, b->bricks.hp, a->bricks.count) == 0);
+    assert(memcmp(a->paddles, b->paddles, sizeof(a->paddles)) == 0);
+    assert(a->broken.count == b->broken.count);
+    for (uint32_t i = 0; i < a->broken.count; ++i) assert(a->broken.items[i] == b->broken.items[i]);
+}
+
+static uint8_t RandomInput(uint64_t tick)
+{
+    // NOTE: Hold a direction for a while so the paddle actually travels
+    uint64_t phase = (tick / 37) % 3;
+    return phase == 0 ? INPUT_LEFT : phase == 1 ? INPUT_RIGHT : INPUT_NONE;
+}
+
+void TestEventsMatchFixedStep(void)
+{
+    Game fixed;
+    Game event;
+    uint32_t seed = test_seed;
+    SetupGame(&fixed, 64, 0);
+    test_seed = seed;
+    SetupGame(&event, 64, 0);
+
+    EventSim sim;
+    for (uint32_t t = 0; t < 4000; ++t) {
+        uint8_t inputs[MAX_PADDLES] = {RandomInput(t)};
+        fixed.GameUpdate(inputs);
+        sim.Update(&event, inputs);
+        AssertSameState(&fixed, &event);
+    }
+    // NOTE: Bricks actually broke, so the test covered dying obstacles
+    assert(fixed.score > 20);
+    assert(sim.events < sim.ball_ticks);
+}
+
+void TestEventsSparseSkipsWork(void)
+{
+    Game fixed;
+    Game event;
+    uint32_t seed = test_seed;
+    SetupGame(&fixed, 8, 7);
+    test_seed = seed;
+    SetupGame(&event, 8, 7);
+
+    EventSim sim;
+    for (uint32_t t = 0; t < 3000; ++t) {
+        fixed.GameUpdate(nullptr);
+        sim.Update(&event, nullptr);
+    }
+    AssertSameState(&fixed, &event);
+    // NOTE: Mostly empty space, the collision code should run for a small fraction of ball ticks
+    assert(sim.events * 5 < sim.ball_ticks);
+}
+
+void TestEventsInvalidate(void)
+{
+    Game fixed;
+    Game event;
+    uint32_t seed = test_seed;
+    SetupGame(&fixed, 16, 4);
+    test_seed = seed;
+    SetupGame(&event, 16, 4);
+
+    EventSim sim;
+    for (uint32_t t = 0; t < 500; ++t) {
+        fixed.GameUpdate(nullptr);
+        sim.Update(&event, nullptr);
+        if (t == 200) {
+            // NOTE: Teleport a ball next to a brick, the old prediction is stale
+            fixed.balls.x[3] = event.balls.x[3] = fixed.bricks.x[0];
+            fixed.balls.y[3] = event.balls.y[3] = fixed.bricks.y[0] - 0.1f;
+            fixed.balls.vy[3] = event.balls.vy[3] = 1.0f;
+            sim.Invalidate();
+        }
+        if (t == 300) {
+            // NOTE: New balls and bricks are picked up without an explicit Invalidate
+            fixed.AddBall(0.0f, 0.0f, 0.02f, 0.3f, 1.1f);
+            event.AddBall(0.0f, 0.0f, 0.02f, 0.3f, 1.1f);
+            fixed.AddBrick(0.0f, 0.1f, 0.1f, 0.05f, 1, 0, 0);
+            event.AddBrick(0.0f, 0.1f, 0.1f, 0.05f, 1, 0, 0);
+        }
+        AssertSameState(&fixed, &event);
+    }
+
+    // NOTE: Mixing in fixed steps changes the tick, which also invalidates
+    for (uint32_t t = 0; t < 300; ++t) {
+        fixed.GameUpdate(nullptr);
+        if (t % 50 == 0) event.GameUpdate(nullptr);
+        else sim.Update(&event, nullptr);
+        AssertSameState(&fixed, &event);
+    }
+}
+
+void TestEventsPredictionBounds(void)
+{
+    Game game;
+    game.AddBall(0.0f, 0.0f, 0.05f, 0.0f, 0.0f);
+    game.BeginTick(nullptr);
+    // NOTE: A resting ball in empty space sleeps for the whole horizon
+    assert(PredictImpact(&game, 0) == EVENT_HORIZON);
+
+    // NOTE: 0.5 units from the wall at 1.0 unit per second is about 28 ticks at 60 FPS
+    game.balls.vx[0] = 1.0f;
+    game.balls.x[0] = 0.45f;
+    uint32_t ticks = PredictImpact(&game, 0);
+    assert(ticks >= 1 && ticks <= (uint32_t)(0.5f * FPS));
+
+    // NOTE: Touching a wall is always due immediately
+    game.balls.x[0] = 0.96f;
+    assert(PredictImpact(&game, 0) == 1);
+}
+
+typedef ARRAY(TestCaseEvents) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseEvents);
+
+    array_append(TestCaseEvents, &Tests, TestCaseEvents("TestEventsMatchFixedStep", TestEventsMatchFixedStep));
+    array_append(TestCaseEvents, &Tests, TestCaseEvents("TestEventsSparseSkipsWork", TestEventsSparseSkipsWork));
+    array_append(TestCaseEvents, &Tests, TestCaseEvents("TestEventsInvalidate", TestEventsInvalidate));
+    array_append(TestCaseEvents, &Tests, TestCaseEvents("TestEventsPredictionBounds", TestEventsPredictionBounds));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
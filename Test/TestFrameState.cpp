@@ -0,0 +1,144 @@
+#include "../src/game.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cmath>
+
+struct TestCaseFrameState {
+public:
+    TestCaseFrameState(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *FrameStateFunctionName;
+    void (*TestFrameStateFunction)(void);
+};
+
+TestCaseFrameState::TestCaseFrameState(const char *Name, void (*Fn)(void)):
+    FrameStateFunctionName(Name), TestFrameStateFunction(Fn) {}
+
+void TestCaseFrameState::RunTestCase()
+{
+    TestFrameStateFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", FrameStateFunctionName);
+}
+
+static void SetupGame(Game *game)
+{
+    game->AddPaddle(-0.5f, -0.9f, 0.4f, 0.05f, 2.0f);
+    game->AddPaddle(0.5f, 0.9f, 0.4f, 0.05f, 2.0f);
+    game->AddBall(0.0f, 0.0f, 0.03f, 0.5f, 0.25f);
+    game->AddBall(-0.2f, 0.4f, 0.03f, -0.5f, 1.0f);
+}
+
+// NOTE: Moves every entity by a known step, like one tick would
+static void MoveGame(Game *game)
+{
+    for (uint32_t i = 0; i < game->balls.count; ++i) {
+        game->balls.x[i] += 0.1f;
+        game->balls.y[i] -= 0.2f;
+    }
+    for (uint32_t i = 0; i < game->paddle_count; ++i) game->paddles[i].x += 0.4f;
+}
+
+void TestFrameStateEndpoints(void)
+{
+    Game game;
+    SetupGame(&game);
+    FrameState previous;
+    previous.Capture(&game);
+    MoveGame(&game);
+
+    FrameState blended;
+    blended.Blend(&previous, &game, 0.0f);
+    assert(blended.ball_count == 2 && blended.paddle_count == 2);
+    for (uint32_t i = 0; i < blended.ball_count; ++i) {
+        assert(blended.ball_x[i] == previous.ball_x[i] && blended.ball_y[i] == previous.ball_y[i]);
+    }
+    for (uint32_t i = 0; i < blended.paddle_count; ++i) assert(blended.paddle_x[i] == previous.paddle_x[i]);
+
+    blended.Blend(&previous, &game, 1.0f);
+    for (uint32_t i = 0; i < blended.ball_count; ++i) {
+        assert(blended.ball_x[i] == game.balls.x[i] && blended.ball_y[i] == game.balls.y[i]);
+    }
+    for (uint32_t i = 0; i < blended.paddle_count; ++i) {
+        assert(blended.paddle_x[i] == game.paddles[i].x && blended.paddle_y[i] == game.paddles[i].y);
+    }
+}
+
+void TestFrameStateMidpoint(void)
+{
+    Game game;
+    SetupGame(&game);
+    FrameState previous;
+    previous.Capture(&game);
+    MoveGame(&game);
+
+    FrameState blended;
+    blended.Blend(&previous, &game, 0.5f);
+    for (uint32_t i = 0; i < blended.ball_count; ++i) {
+        assert(fabsf(blended.ball_x[i] - (previous.ball_x[i] + 0.05f)) < 1e-6f);
+        assert(fabsf(blended.ball_y[i] - (previous.ball_y[i] - 0.1f)) < 1e-6f);
+    }
+    for (uint32_t i = 0; i < blended.paddle_count; ++i) {
+        assert(fabsf(blended.paddle_x[i] - (previous.paddle_x[i] + 0.2f)) < 1e-6f);
+        assert(blended.paddle_y[i] == previous.paddle_y[i]);
+    }
+}
+
+void TestFrameStateBallAdded(void)
+{
+    Game game;
+    SetupGame(&game);
+    game.AddBall(0.7f, 0.7f, 0.03f, 0.0f, 0.0f);
+    // NOTE: The slot past the previous count holds a stale ball, blending it would pull the new one off its position
+    FrameState previous;
+    previous.Capture(&game);
+    previous.ball_x[2] = -0.9f;
+    previous.ball_y[2] = -0.9f;
+    previous.ball_count = 2;
+    MoveGame(&game);
+
+    FrameState blended;
+    blended.Blend(&previous, &game, 0.5f);
+    assert(blended.ball_count == 3);
+    assert(blended.ball_x[2] == game.balls.x[2] && blended.ball_y[2] == game.balls.y[2]);
+    assert(fabsf(blended.ball_x[0] - (previous.ball_x[0] + 0.05f)) < 1e-6f);
+}
+
+void TestFrameStateBallRemoved(void)
+{
+    Game game;
+    SetupGame(&game);
+    FrameState previous;
+    previous.Capture(&game);
+    MoveGame(&game);
+    game.balls.count = 1;
+
+    FrameState blended;
+    blended.Blend(&previous, &game, 0.5f);
+    assert(blended.ball_count == 1);
+    assert(fabsf(blended.ball_x[0] - (previous.ball_x[0] + 0.05f)) < 1e-6f);
+}
+
+typedef ARRAY(TestCaseFrameState) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseFrameState);
+
+    array_append(TestCaseFrameState, &Tests, TestCaseFrameState("TestFrameStateEndpoints", TestFrameStateEndpoints));
+    array_append(TestCaseFrameState, &Tests, TestCaseFrameState("TestFrameStateMidpoint", TestFrameStateMidpoint));
+    array_append(TestCaseFrameState, &Tests, TestCaseFrameState("TestFrameStateBallAdded", TestFrameStateBallAdded));
+    array_append(TestCaseFrameState, &Tests, TestCaseFrameState("TestFrameStateBallRemoved", TestFrameStateBallRemoved));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
@@ -0,0 +1,247 @@
+#include "../src/breakoutt.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+
+// NOTE: Runs on Mesa llvmpipe so build machines without a GPU cover the compute and draw shaders
+#define TEST_BALL_RADIUS 0.02f
+#define TEST_TARGET_SIZE 64
+
+struct TestCaseGpuBalls {
+public:
+    TestCaseGpuBalls(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *GpuBallsFunctionName;
+    void (*TestGpuBallsFunction)(void);
+};
+
+TestCaseGpuBalls::TestCaseGpuBalls(const char *Name, void (*Fn)(void)):
+    GpuBallsFunctionName(Name), TestGpuBallsFunction(Fn) {}
+
+void TestCaseGpuBalls::RunTestCase()
+{
+    TestGpuBallsFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", GpuBallsFunctionName);
+}
+
+// NOTE: Spawn sets the count, the positions are then overwritten with aimed balls
+static void PlaceBalls(GpuBalls *gpu, const GpuBall *balls, uint32_t count)
+{
+    Rng rng(1);
+    gpu->Spawn(count, &rng);
+    assert(gpu->count == count);
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, gpu->BallBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)count * sizeof(GpuBall), balls);
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+static void ReadBalls(const GpuBalls *gpu, GpuBall *balls)
+{
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, gpu->BallBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)gpu->count * sizeof(GpuBall), balls);
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+static int32_t ReadHp(const GpuBalls *gpu, uint32_t brick)
+{
+    int32_t hp = -1;
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, gpu->HpBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)brick * sizeof(int32_t), sizeof(int32_t), &hp);
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return hp;
+}
+
+void TestGpuBallsInit(void)
+{
+    GpuBalls gpu;
+    assert(gpu.Init(GPU_BALL_GROUP_SIZE + 1, TEST_BALL_RADIUS));
+    assert(gpu.ComputeProgramId != 0 && gpu.DrawProgramId != 0);
+    assert(gpu.BallBuffer != 0 && gpu.HpBuffer != 0 && gpu.brick_count == 0);
+    assert(glGetError() == GL_NO_ERROR);
+}
+
+void TestGpuBallsBounceOffBrick(void)
+{
+    // NOTE: No paddles, the brick sits straight above the ball
+    Game game;
+    game.AddBrick(0.0f, 0.5f, 0.4f, 0.1f, 2, 0, 0);
+    GpuBalls gpu;
+    assert(gpu.Init(4, TEST_BALL_RADIUS));
+    gpu.UploadBricks(&game.bricks);
+    assert(gpu.brick_count == 1 && ReadHp(&gpu, 0) == 2);
+
+    GpuBall ball = {0.0f, 0.2f, 0.0f, 1.0f};
+    PlaceBalls(&gpu, &ball, 1);
+    gpu.Step(&game, FPS / 2);
+    assert(glGetError() == GL_NO_ERROR);
+
+    GpuBall after;
+    ReadBalls(&gpu, &after);
+    assert(after.vy < 0.0f && "ball did not bounce off the brick");
+    assert(after.y + TEST_BALL_RADIUS <= 0.45f + 0.001f && "ball went into the brick");
+    assert(after.x == 0.0f);
+    assert(ReadHp(&gpu, 0) == 1);
+    // NOTE: The CPU bricks are never written back
+    assert(game.bricks.hp[0] == 2);
+    assert(gpu.dispatches == 1 && gpu.ticks == FPS / 2);
+}
+
+void TestGpuBallsHpIsShared(void)
+{
+    // NOTE: Three balls reach the brick in the same tick, it only has hit points for two of them
+    Game game;
+    game.AddBrick(0.0f, 0.5f, 0.4f, 0.1f, 2, 0, 0);
+    GpuBalls gpu;
+    assert(gpu.Init(4, TEST_BALL_RADIUS));
+    gpu.UploadBricks(&game.bricks);
+
+    GpuBall balls[3] = {
+        {-0.1f, 0.2f, 0.0f, 1.0f},
+        { 0.0f, 0.2f, 0.0f, 1.0f},
+        { 0.1f, 0.2f, 0.0f, 1.0f},
+    };
+    PlaceBalls(&gpu, balls, 3);
+    gpu.Step(&game, FPS / 2);
+
+    GpuBall after[3];
+    ReadBalls(&gpu, after);
+    uint32_t bounced = 0;
+    for (uint32_t i = 0; i < 3; ++i) {
+        if (after[i].vy < 0.0f) bounced++;
+    }
+    assert(bounced == 2);
+    assert(ReadHp(&gpu, 0) == 0);
+}
+
+void TestGpuBallsWalls(void)
+{
+    Game game;
+    GpuBalls gpu;
+    assert(gpu.Init(4, TEST_BALL_RADIUS));
+    gpu.UploadBricks(&game.bricks);
+
+    GpuBall ball = {0.9f, 0.0f, 1.0f, 0.0f};
+    PlaceBalls(&gpu, &ball, 1);
+    gpu.Step(&game, FPS / 4);
+
+    GpuBall after;
+    ReadBalls(&gpu, &after);
+    assert(after.vx < 0.0f);
+    assert(after.x + TEST_BALL_RADIUS <= 1.0f);
+}
+
+void TestGpuBallsResting(void)
+{
+    // NOTE: A ball with zero velocity has no leading edge, it must neither move nor touch the brick next to it
+    Game game;
+    game.AddBrick(0.0f, 0.5f, 0.4f, 0.1f, 1, 0, 0);
+    GpuBalls gpu;
+    assert(gpu.Init(4, TEST_BALL_RADIUS));
+    gpu.UploadBricks(&game.bricks);
+
+    GpuBall ball = {0.0f, 0.5f - 0.05f - TEST_BALL_RADIUS * 2.0f, 0.0f, 0.0f};
+    PlaceBalls(&gpu, &ball, 1);
+    gpu.Step(&game, FPS / 4);
+
+    GpuBall after;
+    ReadBalls(&gpu, &after);
+    assert(after.x == ball.x && after.y == ball.y);
+    assert(after.vx == 0.0f && after.vy == 0.0f);
+    assert(ReadHp(&gpu, 0) == 1);
+}
+
+void TestGpuBallsDraw(void)
+{
+    // NOTE: The point sprite pass reads the storage buffer by gl_VertexID, one ball in the middle must be drawn
+    GLuint texture = 0, framebuffer = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, TEST_TARGET_SIZE, TEST_TARGET_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+    glViewport(0, 0, TEST_TARGET_SIZE, TEST_TARGET_SIZE);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    GpuBalls gpu;
+    assert(gpu.Init(4, TEST_BALL_RADIUS));
+    GpuBall ball = {0.0f, 0.0f, 0.0f, 0.0f};
+    PlaceBalls(&gpu, &ball, 1);
+    gpu.Draw(1.0f, 8.0f);
+
+    uint8_t center[4] = {};
+    uint8_t corner[4] = {};
+    glReadPixels(TEST_TARGET_SIZE / 2, TEST_TARGET_SIZE / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, center);
+    glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, corner);
+    assert(glGetError() == GL_NO_ERROR);
+    // NOTE: A resting ball is drawn in the cold color (0.4, 0.7, 1.0)
+    assert(center[2] > 200 && center[1] > 100);
+    assert(corner[0] == 0 && corner[1] == 0 && corner[2] == 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &texture);
+}
+
+typedef ARRAY(TestCaseGpuBalls) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        fprintf(stderr, "SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_Window *window = SDL_CreateWindow("TestGpuBalls", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                          TEST_TARGET_SIZE, TEST_TARGET_SIZE, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (window == NULL) {
+        fprintf(stderr, "Window could not be created! SDL_Error: %s\n", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+    SDL_GLContext context = SDL_GL_CreateContext(window);
+    if (context == NULL) {
+        fprintf(stderr, "GL 4.3 context could not be created! SDL_Error: %s\n", SDL_GetError());
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+    // NOTE: Core profile entry points are only loaded with glewExperimental
+    glewExperimental = GL_TRUE;
+    if (GLEW_OK != glewInit()) {
+        fprintf(stderr, "Could not initialize GLEW!\n");
+        return 1;
+    }
+    // NOTE: glewInit can leave a GL_INVALID_ENUM behind on core contexts
+    while (glGetError() != GL_NO_ERROR) {}
+    printf("GL renderer %s\n", (const char*)glGetString(GL_RENDERER));
+
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseGpuBalls);
+
+    array_append(TestCaseGpuBalls, &Tests, TestCaseGpuBalls("TestGpuBallsInit", TestGpuBallsInit));
+    array_append(TestCaseGpuBalls, &Tests, TestCaseGpuBalls("TestGpuBallsBounceOffBrick", TestGpuBallsBounceOffBrick));
+    array_append(TestCaseGpuBalls, &Tests, TestCaseGpuBalls("TestGpuBallsHpIsShared", TestGpuBallsHpIsShared));
+    array_append(TestCaseGpuBalls, &Tests, TestCaseGpuBalls("TestGpuBallsWalls", TestGpuBallsWalls));
+    array_append(TestCaseGpuBalls, &Tests, TestCaseGpuBalls("TestGpuBallsResting", TestGpuBallsResting));
+    array_append(TestCaseGpuBalls, &Tests, TestCaseGpuBalls("TestGpuBallsDraw", TestGpuBallsDraw));
+
+    RunAllTestCases(&Tests);
+
+    SDL_GL_DeleteContext(context);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
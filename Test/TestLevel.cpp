@@ -0,0 +1,126 @@
+#include "../src/game.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+
+#define LEVEL_TEST_PATH "/tmp/breakoutt_test.lvl"
+
+struct TestCaseLevel {
+public:
+    TestCaseLevel(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *LevelFunctionName;
+    void (*TestLevelFunction)(void);
+};
+
+TestCaseLevel::TestCaseLevel(const char *Name, void (*Fn)(void)):
+    LevelFunctionName(Name), TestLevelFunction(Fn) {}
+
+void TestCaseLevel::RunTestCase()
+{
+    TestLevelFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", LevelFunctionName);
+}
+
+static void BuildGrid(Game *game, LevelInfo *info, uint32_t cols, uint32_t rows)
+{
+    for (uint32_t row = 0; row < rows; ++row) {
+        for (uint32_t col = 0; col < cols; ++col) {
+            game->AddBrick(-0.9f + col * 0.01f, 0.9f - row * 0.01f, 0.009f, 0.009f,
+                           (uint8_t)(1 + (row + col) % 3), (uint8_t)(col % LEVEL_MAX_TYPES),
+                           (uint8_t)(row % LEVEL_MAX_COLORS));
+        }
+    }
+    info->cols = cols;
+    info->rows = rows;
+    info->brick_count = game->bricks.count;
+}
+
+void TestLevelRoundTrip(void)
+{
+    Game source;
+    LevelInfo saved = {};
+    BuildGrid(&source, &saved, 250, 200);
+    assert(SaveLevel(&source.bricks, &saved, LEVEL_TEST_PATH));
+
+    Game game;
+    LevelInfo loaded = {};
+    assert(LoadLevel(&game, LEVEL_TEST_PATH, &loaded));
+    assert(loaded.cols == 250 && loaded.rows == 200 && loaded.brick_count == 50000);
+    assert(game.bricks.count == 50000);
+    assert(game.bricks.borrowed && game.level_mapping != nullptr);
+    assert(memcmp(game.bricks.x, source.bricks.x, 50000 * sizeof(float)) == 0);
+    assert(memcmp(game.bricks.hp, source.bricks.hp, 50000) == 0);
+    assert(memcmp(game.bricks.color, source.bricks.color, 50000) == 0);
+}
+
+void TestLevelKeepsBallsAndPaddles(void)
+{
+    Game source;
+    LevelInfo info = {};
+    BuildGrid(&source, &info, 10, 5);
+    assert(SaveLevel(&source.bricks, &info, LEVEL_TEST_PATH));
+
+    Game game;
+    game.AddBall(0.0f, 0.0f, 0.1f, 1.0f, 1.0f);
+    game.AddPaddle(0.0f, -0.9f, 0.4f, 0.05f, 2.0f);
+    game.AddBrick(0.0f, 0.0f, 1.0f, 1.0f, 1, 0, 0);
+    assert(LoadLevel(&game, LEVEL_TEST_PATH, nullptr));
+    assert(game.balls.count == 1 && game.paddle_count == 1);
+    assert(game.bricks.count == 50);
+
+    // NOTE: Loading a second level replaces the first mapping
+    assert(LoadLevel(&game, LEVEL_TEST_PATH, nullptr));
+    assert(game.bricks.count == 50);
+
+    // NOTE: Bricks are writable in place (copy-on-write mapping)
+    game.bricks.hp[0] = 0;
+    assert(game.bricks.hp[0] == 0);
+}
+
+void TestLevelRejectsBadColor(void)
+{
+    Game source;
+    source.AddBrick(0.0f, 0.0f, 0.1f, 0.1f, 1, 0, LEVEL_MAX_COLORS);
+    LevelInfo info = {1, 1, 1};
+    assert(SaveLevel(&source.bricks, &info, LEVEL_TEST_PATH));
+
+    Game game;
+    assert(!LoadLevel(&game, LEVEL_TEST_PATH, nullptr));
+    assert(game.bricks.count == 0);
+}
+
+void TestLevelRejectsSnapshot(void)
+{
+    Game source;
+    source.AddBall(0.0f, 0.0f, 0.1f, 1.0f, 1.0f);
+    assert(SaveSnapshot(&source, LEVEL_TEST_PATH));
+
+    Game game;
+    assert(!LoadLevel(&game, LEVEL_TEST_PATH, nullptr));
+}
+
+typedef ARRAY(TestCaseLevel) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseLevel);
+
+    array_append(TestCaseLevel, &Tests, TestCaseLevel("TestLevelRoundTrip", TestLevelRoundTrip));
+    array_append(TestCaseLevel, &Tests, TestCaseLevel("TestLevelKeepsBallsAndPaddles", TestLevelKeepsBallsAndPaddles));
+    array_append(TestCaseLevel, &Tests, TestCaseLevel("TestLevelRejectsBadColor", TestLevelRejectsBadColor));
+    array_append(TestCaseLevel, &Tests, TestCaseLevel("TestLevelRejectsSnapshot", TestLevelRejectsSnapshot));
+
+    RunAllTestCases(&Tests);
+    remove(LEVEL_TEST_PATH);
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include "../src/levelgen.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+#define TEST_LEVEL_PATH "/tmp/breakoutt_levelgen_test.lvl"
+
+struct TestCaseLevelGen {
+public:
+    TestCaseLevelGen(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *LevelGenFunctionName;
+    void (*TestLevelGenFunction)(void);
+};
+
+TestCaseLevelGen::TestCaseLevelGen(const char *Name, void (*Fn)(void)):
+    LevelGenFunctionName(Name), TestLevelGenFunction(Fn) {}
+
+void TestCaseLevelGen::RunTestCase()
+{
+    TestLevelGenFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", LevelGenFunctionName);
+}
+
+static bool SameBricks(const Bricks *a, const Bricks *b)
+{
+    if (a->count != b->count) return false;
+    Bricks va = *a, vb = *b;
+    SoAColumn ca[Bricks::column_count], cb[Bricks::column_count];
+    va.Columns(ca);
+    vb.Columns(cb);
+    for (uint32_t i = 0; i < Bricks::column_count; ++i) {
+        if (memcmp(*ca[i].data, *cb[i].data, (size_t)a->count * ca[i].elem_size) != 0) return false;
+    }
+    return true;
+}
+
+static double Milliseconds(const timespec *start, const timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) * 1e-6;
+}
+
+// NOTE: Chunks are claimed in whatever order the threads get to them, the level must not care
+void TestLevelGenThreadCountIndependent(void)
+{
+    for (uint64_t seed = 1; seed <= 6; ++seed) {
+        LevelGenConfig config = DefaultLevelGen(seed, 500, 400);
+        Game reference;
+        assert(GenerateLevel(&reference, &config, 1, nullptr));
+        assert(reference.bricks.count > 0);
+        const uint32_t thread_counts[] = {2, 3, 8, 0};
+        for (uint32_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); ++t) {
+            Game game;
+            assert(GenerateLevel(&game, &config, thread_counts[t], nullptr));
+            assert(SameBricks(&reference.bricks, &game.bricks));
+        }
+    }
+}
+
+void TestLevelGenSeeds(void)
+{
+    LevelGenConfig a = DefaultLevelGen(10, 14, 8);
+    LevelGenConfig b = DefaultLevelGen(11, 14, 8);
+    Game first, again, other;
+    LevelInfo info = {};
+    assert(GenerateLevel(&first, &a, 0, &info));
+    assert(GenerateLevel(&again, &a, 0, nullptr));
+    assert(GenerateLevel(&other, &b, 0, nullptr));
+    assert(SameBricks(&first.bricks, &again.bricks));
+    assert(!SameBricks(&first.bricks, &other.bricks));
+    assert(info.cols == 14 && info.rows == 8 && info.brick_count == first.bricks.count);
+}
+
+void TestLevelGenBricksValid(void)
+{
+    for (uint64_t seed = 0; seed < 32; ++seed) {
+        LevelGenConfig config = DefaultLevelGen(seed, 40, 20);
+        Game game;
+        assert(GenerateLevel(&game, &config, 4, nullptr));
+        const Bricks *bricks = &game.bricks;
+        assert(bricks->count <= 40 * 20);
+        for (uint32_t i = 0; i < bricks->count; ++i) {
+            assert(bricks->hp[i] >= 1 && bricks->hp[i] <= config.max_hp);
+            assert(bricks->color[i] < LEVEL_MAX_COLORS);
+            assert(bricks->type[i] < LEVEL_MAX_TYPES);
+            assert(bricks->x[i] - bricks->w[i] * 0.5f >= -1.0f && bricks->x[i] + bricks->w[i] * 0.5f <= 1.0f);
+            assert(bricks->y[i] - bricks->h[i] * 0.5f >= 0.2f && bricks->y[i] + bricks->h[i] * 0.5f <= 1.0f);
+            // NOTE: Cells are written in row-major order, each brick sits in its own cell
+            if (i > 0) {
+                bool later = bricks->y[i] < bricks->y[i - 1] - 1e-6f ||
+                             (fabsf(bricks->y[i] - bricks->y[i - 1]) < 1e-6f && bricks->x[i] > bricks->x[i - 1]);
+                assert(later);
+            }
+        }
+    }
+
+    LevelGenConfig bad = DefaultLevelGen(1, 0, 10);
+    Game game;
+    assert(!GenerateLevel(&game, &bad, 0, nullptr));
+}
+
+// NOTE: A loaded level borrows its columns from the file mapping, generating over it must take ownership
+void TestLevelGenReplacesLoadedLevel(void)
+{
+    Game source;
+    LevelGenConfig config = DefaultLevelGen(3, 14, 8);
+    LevelInfo info = {};
+    assert(GenerateLevel(&source, &config, 0, &info));
+    assert(SaveLevel(&source.bricks, &info, TEST_LEVEL_PATH));
+
+    Game game;
+    game.AddBall(0.0f, 0.0f, 0.03f, 1.0f, 1.0f);
+    assert(LoadLevel(&game, TEST_LEVEL_PATH, nullptr));
+    assert(game.bricks.borrowed && game.level_mapping != nullptr);
+
+    config.seed = 4;
+    assert(GenerateLevel(&game, &config, 0, nullptr));
+    assert(!game.bricks.borrowed && game.level_mapping == nullptr);
+    assert(game.balls.count == 1);
+    for (uint32_t tick = 0; tick < 600; ++tick) game.GameUpdate(nullptr);
+    remove(TEST_LEVEL_PATH);
+}
+
+void TestLevelGenLargeLevelTime(void)
+{
+    LevelGenConfig config = DefaultLevelGen(2024, 500, 400);
+    config.density = 1.0f;
+    Game game;
+    // NOTE: First run allocates the columns, later levels reuse them
+    bool generated = GenerateLevel(&game, &config, 0, nullptr);
+    assert(generated);
+
+    const uint32_t runs = 10;
+    timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < runs; ++i) {
+        config.seed++;
+        generated = GenerateLevel(&game, &config, 0, nullptr) && generated;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double parallel = Milliseconds(&start, &end) / runs;
+    assert(generated);
+    // NOTE: The seed rolls the pattern, so only the bound is known, the single threaded run below checks the contents
+    assert(game.bricks.count > 0 && game.bricks.count <= 500 * 400);
+
+    Game single_game;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < runs; ++i) {
+        generated = GenerateLevel(&single_game, &config, 1, nullptr) && generated;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double single = Milliseconds(&start, &end) / runs;
+    assert(generated);
+    // NOTE: Timing is informational only (the budget is one 16.6 ms frame); the split must not change the level
+    printf("INFO: 200k cell level: %.2f ms on all cores, %.2f ms on one (%u bricks)\n",
+           parallel, single, game.bricks.count);
+    assert(single_game.bricks.count == game.bricks.count);
+    assert(memcmp(single_game.bricks.x, game.bricks.x, game.bricks.count * sizeof(float)) == 0);
+    assert(memcmp(single_game.bricks.hp, game.bricks.hp, game.bricks.count) == 0);
+    assert(memcmp(single_game.bricks.type, game.bricks.type, game.bricks.count) == 0);
+}
+
+typedef ARRAY(TestCaseLevelGen) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseLevelGen);
+
+    array_append(TestCaseLevelGen, &Tests, TestCaseLevelGen("TestLevelGenThreadCountIndependent", TestLevelGenThreadCountIndependent));
+    array_append(TestCaseLevelGen, &Tests, TestCaseLevelGen("TestLevelGenSeeds", TestLevelGenSeeds));
+    array_append(TestCaseLevelGen, &Tests, TestCaseLevelGen("TestLevelGenBricksValid", TestLevelGenBricksValid));
+    array_append(TestCaseLevelGen, &Tests, TestCaseLevelGen("TestLevelGenReplacesLoadedLevel", TestLevelGenReplacesLoadedLevel));
+    array_append(TestCaseLevelGen, &Tests, TestCaseLevelGen("TestLevelGenLargeLevelTime", TestLevelGenLargeLevelTime));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "../src/particles.hpp"
+#include "../util/math_util.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+
+struct TestCaseParticles {
+public:
+    TestCaseParticles(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *ParticlesFunctionName;
+    void (*TestParticlesFunction)(void);
+};
+
+TestCaseParticles::TestCaseParticles(const char *Name, void (*Fn)(void)):
+    ParticlesFunctionName(Name), TestParticlesFunction(Fn) {}
+
+void TestCaseParticles::RunTestCase()
+{
+    TestParticlesFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", ParticlesFunctionName);
+}
+
+void TestParticlesSpawnCapacity(void)
+{
+    ParticlePool pool(10);
+    for (int i = 0; i < 10; ++i) assert(pool.Spawn(0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0xFFFFFFFFu, 1.0f));
+    assert(!pool.Spawn(0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0xFFFFFFFFu, 1.0f));
+    assert(pool.count == 10);
+    assert(((uintptr_t)pool.x % SOA_ALIGNMENT) == 0);
+}
+
+void TestParticlesIntegrate(void)
+{
+    // NOTE: 7 particles exercise both the 4-wide path and the scalar tail
+    ParticlePool pool(16);
+    for (int i = 0; i < 7; ++i) pool.Spawn((float)i, 0.0f, 1.0f, 2.0f, 10.0f, 0xFFFFFFFFu, 1.0f);
+    pool.Update(0.5f);
+
+    for (uint32_t i = 0; i < pool.count; ++i) {
+        float vy = 2.0f + PARTICLE_GRAVITY * 0.5f;
+        assert(almostEqual(pool.vy[i], vy));
+        assert(almostEqual(pool.x[i], (float)i + 0.5f));
+        assert(almostEqual(pool.y[i], vy * 0.5f));
+        assert(almostEqual(pool.life[i], 9.5f));
+    }
+}
+
+void TestParticlesExpire(void)
+{
+    ParticlePool pool(64);
+    for (int i = 0; i < 50; ++i) pool.Spawn((float)i, 0.0f, 0.0f, 0.0f, (i % 2) ? 1.0f : 3.0f, 0xFFFFFFFFu, 1.0f);
+    pool.Update(2.0f);
+    assert(pool.count == 25);
+    for (uint32_t i = 0; i < pool.count; ++i) {
+        // NOTE: only the even (long lived) particles survive
+        assert(((int)pool.x[i] % 2) == 0);
+        assert(pool.life[i] > 0.0f);
+    }
+    pool.Update(2.0f);
+    assert(pool.count == 0);
+}
+
+void TestParticlesFade(void)
+{
+    ParticlePool pool(4);
+    pool.Spawn(1.0f, 2.0f, 0.0f, 0.0f, 2.0f, pack_color(1.0f, 0.0f, 0.0f, 1.0f), 3.0f);
+    pool.Update(1.0f);
+
+    ParticleVertex vertices[4];
+    assert(pool.FillVertices(vertices) == 1);
+    assert(vertices[0].x == 1.0f && vertices[0].size == 3.0f);
+    uint32_t alpha = vertices[0].color >> 24;
+    assert(alpha >= 126 && alpha <= 128);
+    assert((vertices[0].color & 0xFFu) == 255);
+}
+
+void TestParticlesBurst(void)
+{
+    ParticlePool pool(PARTICLE_CAPACITY);
+    for (int i = 0; i < 2000; ++i) pool.SpawnBurst(0.0f, 0.0f, 100, 1.0f, 1.0f, 0xFFFFFFFFu);
+    assert(pool.count == PARTICLE_CAPACITY);
+    for (uint32_t i = 0; i < pool.count; ++i) {
+        float speed = sqrtf(pool.vx[i] * pool.vx[i] + pool.vy[i] * pool.vy[i]);
+        assert(speed <= 1.0001f);
+    }
+}
+
+typedef ARRAY(TestCaseParticles) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseParticles);
+
+    array_append(TestCaseParticles, &Tests, TestCaseParticles("TestParticlesSpawnCapacity", TestParticlesSpawnCapacity));
+    array_append(TestCaseParticles, &Tests, TestCaseParticles("TestParticlesIntegrate", TestParticlesIntegrate));
+    array_append(TestCaseParticles, &Tests, TestCaseParticles("TestParticlesExpire", TestParticlesExpire));
+    array_append(TestCaseParticles, &Tests, TestCaseParticles("TestParticlesFade", TestParticlesFade));
+    array_append(TestCaseParticles, &Tests, TestCaseParticles("TestParticlesBurst", TestParticlesBurst));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "../src/program_cache.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_CACHE_DIR "/tmp/breakoutt_program_cache_test/nested"
+
+struct TestCaseProgramCache {
+public:
+    TestCaseProgramCache(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *ProgramCacheFunctionName;
+    void (*TestProgramCacheFunction)(void);
+};
+
+TestCaseProgramCache::TestCaseProgramCache(const char *Name, void (*Fn)(void)):
+    ProgramCacheFunctionName(Name), TestProgramCacheFunction(Fn) {}
+
+void TestCaseProgramCache::RunTestCase()
+{
+    TestProgramCacheFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", ProgramCacheFunctionName);
+}
+
+static void RemoveTestCache(void)
+{
+    // NOTE: Only what the tests write, never a recursive delete
+    char path[PROGRAM_CACHE_PATH_LENGTH];
+    for (uint64_t key = 1; key <= 3; ++key) {
+        ProgramCachePath(path, sizeof(path), TEST_CACHE_DIR, key);
+        unlink(path);
+    }
+    rmdir(TEST_CACHE_DIR);
+    rmdir("/tmp/breakoutt_program_cache_test");
+}
+
+void TestProgramCacheKey(void)
+{
+    const char *parts[4] = {"void main() {}", "precision", "Mesa", "4.5"};
+    uint64_t key = ProgramCacheKey(parts, 4);
+    assert(key == ProgramCacheKey(parts, 4));
+
+    // NOTE: Any source or driver string change is a different key
+    const char *edited[4] = {"void main() { }", "precision", "Mesa", "4.5"};
+    assert(ProgramCacheKey(edited, 4) != key);
+    const char *driver[4] = {"void main() {}", "precision", "Mesa", "4.6"};
+    assert(ProgramCacheKey(driver, 4) != key);
+
+    // NOTE: Text moved across a part boundary still changes the key
+    const char *ab[2] = {"ab", "c"};
+    const char *a_bc[2] = {"a", "bc"};
+    assert(ProgramCacheKey(ab, 2) != ProgramCacheKey(a_bc, 2));
+
+    // NOTE: A missing driver string hashes like an empty one instead of crashing
+    const char *missing[2] = {"x", nullptr};
+    const char *empty[2] = {"x", ""};
+    assert(ProgramCacheKey(missing, 2) == ProgramCacheKey(empty, 2));
+
+    char path[PROGRAM_CACHE_PATH_LENGTH];
+    assert(ProgramCachePath(path, sizeof(path), "cache", 0xABCull));
+    assert(strcmp(path, "cache/0000000000000abc.prog") == 0);
+    assert(!ProgramCachePath(path, 8, "cache", 0xABCull));
+}
+
+void TestProgramCacheRoundTrip(void)
+{
+    RemoveTestCache();
+    ProgramBinary binary;
+    assert(!LoadProgramBinary(TEST_CACHE_DIR, 1, &binary));
+
+    uint8_t blob[1000];
+    for (uint32_t i = 0; i < sizeof(blob); ++i) blob[i] = (uint8_t)(i * 7);
+    assert(SaveProgramBinary(TEST_CACHE_DIR, 1, 0x8741, blob, sizeof(blob)));
+    assert(LoadProgramBinary(TEST_CACHE_DIR, 1, &binary));
+    assert(binary.format == 0x8741 && binary.size == sizeof(blob));
+    assert(memcmp(binary.data, blob, sizeof(blob)) == 0);
+
+    // NOTE: Overwriting an entry replaces it whole
+    blob[0] = 0xEE;
+    assert(SaveProgramBinary(TEST_CACHE_DIR, 1, 0x8742, blob, 10));
+    ProgramBinary replaced;
+    assert(LoadProgramBinary(TEST_CACHE_DIR, 1, &replaced));
+    assert(replaced.format == 0x8742 && replaced.size == 10 && ((const uint8_t*)replaced.data)[0] == 0xEE);
+
+    RemoveProgramBinary(TEST_CACHE_DIR, 1);
+    ProgramBinary removed;
+    assert(!LoadProgramBinary(TEST_CACHE_DIR, 1, &removed));
+    assert(removed.mapping == nullptr);
+    RemoveTestCache();
+}
+
+void TestProgramCacheRejectsMismatch(void)
+{
+    RemoveTestCache();
+    uint8_t blob[64] = {1, 2, 3};
+    assert(SaveProgramBinary(TEST_CACHE_DIR, 2, 1, blob, sizeof(blob)));
+
+    // NOTE: An entry copied under another key's name is refused
+    char from[PROGRAM_CACHE_PATH_LENGTH];
+    char to[PROGRAM_CACHE_PATH_LENGTH];
+    ProgramCachePath(from, sizeof(from), TEST_CACHE_DIR, 2);
+    ProgramCachePath(to, sizeof(to), TEST_CACHE_DIR, 3);
+    assert(rename(from, to) == 0);
+    ProgramBinary binary;
+    assert(!LoadProgramBinary(TEST_CACHE_DIR, 3, &binary));
+
+    // NOTE: Truncated entries are refused
+    assert(truncate(to, 20) == 0);
+    assert(!LoadProgramBinary(TEST_CACHE_DIR, 3, &binary));
+    RemoveTestCache();
+}
+
+typedef ARRAY(TestCaseProgramCache) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseProgramCache);
+
+    array_append(TestCaseProgramCache, &Tests, TestCaseProgramCache("TestProgramCacheKey", TestProgramCacheKey));
+    array_append(TestCaseProgramCache, &Tests, TestCaseProgramCache("TestProgramCacheRoundTrip", TestProgramCacheRoundTrip));
+    array_append(TestCaseProgramCache, &Tests, TestCaseProgramCache("TestProgramCacheRejectsMismatch", TestProgramCacheRejectsMismatch));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include "../src/random.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+struct TestCaseRandom {
+public:
+    TestCaseRandom(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *RandomFunctionName;
+    void (*TestRandomFunction)(void);
+};
+
+TestCaseRandom::TestCaseRandom(const char *Name, void (*Fn)(void)):
+    RandomFunctionName(Name), TestRandomFunction(Fn) {}
+
+void TestCaseRandom::RunTestCase()
+{
+    TestRandomFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", RandomFunctionName);
+}
+
+static double Seconds(void)
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// NOTE: Reference outputs of xoshiro128++ from state {1, 2, 3, 4}
+void TestRandomReferenceSequence(void)
+{
+    Rng rng;
+    rng.s[0] = 1; rng.s[1] = 2; rng.s[2] = 3; rng.s[3] = 4;
+    assert(rng.Next() == 0x00000281u);
+    assert(rng.Next() == 0x00180387u);
+    assert(rng.Next() == 0xc0183387u);
+    assert(rng.Next() == 0xd1ae3b02u);
+}
+
+void TestRandomSeeding(void)
+{
+    Rng a(42), b(42), c(43);
+    bool differs = false;
+    for (uint32_t i = 0; i < 64; ++i) {
+        uint32_t x = a.Next();
+        assert(x == b.Next());
+        differs |= x != c.Next();
+    }
+    assert(differs);
+
+    Rng zero(0);
+    assert((zero.s[0] | zero.s[1] | zero.s[2] | zero.s[3]) != 0);
+    b.Seed(42);
+    Rng fresh(42);
+    assert(memcmp(b.s, fresh.s, sizeof(b.s)) == 0);
+}
+
+// NOTE: The state update is linear over GF(2), so a correct jump distributes over xor
+void TestRandomJumpIsLinear(void)
+{
+    Rng a(1), b(2), both;
+    for (int i = 0; i < 4; ++i) both.s[i] = a.s[i] ^ b.s[i];
+    a.Jump();
+    b.Jump();
+    both.Jump();
+    for (int i = 0; i < 4; ++i) assert(both.s[i] == (a.s[i] ^ b.s[i]));
+
+    Rng c(3), d(3);
+    c.LongJump();
+    d.Jump();
+    assert(memcmp(c.s, d.s, sizeof(c.s)) != 0);
+}
+
+void TestRandomSplit(void)
+{
+    Rng parent(7);
+    Rng copy = parent;
+    Rng child = parent.Split();
+    assert(memcmp(child.s, copy.s, sizeof(copy.s)) == 0);
+    copy.Jump();
+    assert(memcmp(parent.s, copy.s, sizeof(copy.s)) == 0);
+
+    Rng sibling = parent.Split();
+    uint32_t same = 0;
+    for (uint32_t i = 0; i < 4096; ++i) same += child.Next() == sibling.Next();
+    assert(same < 4);
+}
+
+void TestRandomRanges(void)
+{
+    Rng rng(99);
+    const uint32_t n = 300000;
+    uint32_t counts[10] = {};
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t k = rng.Below(10);
+        assert(k < 10);
+        counts[k]++;
+
+        float f = rng.Float();
+        assert(f >= 0.0f && f < 1.0f);
+        sum += f;
+
+        float r = rng.Range(-2.0f, 3.0f);
+        assert(r >= -2.0f && r < 3.0f);
+    }
+    assert(sum / n > 0.49 && sum / n < 0.51);
+
+    double chi2 = 0.0;
+    double expected = n / 10.0;
+    for (uint32_t k = 0; k < 10; ++k) chi2 += (counts[k] - expected) * (counts[k] - expected) / expected;
+    // NOTE: 9 degrees of freedom, 27.9 is the 0.1% critical value
+    assert(chi2 < 27.9);
+
+    assert(rng.Below(1) == 0);
+    assert(rng.Below(0) == 0);
+}
+
+// NOTE: The batch path has to produce exactly the four split streams, tail included
+void TestRandomBatchMatchesScalar(void)
+{
+    Rng source(2024);
+    Rng lanes[4];
+    Rng copy = source;
+    for (int lane = 0; lane < 4; ++lane) lanes[lane] = copy.Split();
+
+    Rng4 batch(&source);
+    assert(memcmp(source.s, copy.s, sizeof(copy.s)) == 0);
+
+    uint32_t out[103];
+    batch.Fill(out, 103);
+    for (uint32_t i = 0; i < 103; ++i) assert(out[i] == lanes[i % 4].Next());
+    lanes[3].Next(); // NOTE: the partial last group stepped every lane
+
+    float floats[64];
+    batch.FillFloat(floats, 64);
+    for (uint32_t i = 0; i < 64; ++i) {
+        assert(floats[i] == lanes[i % 4].Float());
+        assert(floats[i] >= 0.0f && floats[i] < 1.0f);
+    }
+}
+
+void TestRandomThroughput(void)
+{
+    const size_t n = 1 << 20;
+    uint32_t *out = (uint32_t*)malloc(n * sizeof(uint32_t));
+    assert(out != NULL);
+
+    double start = Seconds();
+    srand(1);
+    for (size_t i = 0; i < n; ++i) out[i] = (uint32_t)rand();
+    double libc = Seconds() - start;
+
+    Rng rng(1);
+    start = Seconds();
+    for (size_t i = 0; i < n; ++i) out[i] = rng.Next();
+    double scalar = Seconds() - start;
+
+    Rng copy = rng;
+    Rng lanes[4];
+    for (int lane = 0; lane < 4; ++lane) lanes[lane] = copy.Split();
+    Rng4 batch(&rng);
+    start = Seconds();
+    batch.Fill(out, n);
+    double simd = Seconds() - start;
+
+    printf("INFO: %zu values: rand() %.2f ms, Rng::Next %.2f ms, Rng4::Fill %.2f ms\n",
+           n, libc * 1e3, scalar * 1e3, simd * 1e3);
+    // NOTE: The timed bulk fill must still be the four split streams interleaved
+    for (size_t i = 0; i < n; ++i) assert(out[i] == lanes[i % 4].Next());
+    free(out);
+}
+
+typedef ARRAY(TestCaseRandom) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseRandom);
+
+    array_append(TestCaseRandom, &Tests, TestCaseRandom("TestRandomReferenceSequence", TestRandomReferenceSequence));
+    array_append(TestCaseRandom, &Tests, TestCaseRandom("TestRandomSeeding", TestRandomSeeding));
+    array_append(TestCaseRandom, &Tests, TestCaseRandom("TestRandomJumpIsLinear", TestRandomJumpIsLinear));
+    array_append(TestCaseRandom, &Tests, TestCaseRandom("TestRandomSplit", TestRandomSplit));
+    array_append(TestCaseRandom, &Tests, TestCaseRandom("TestRandomRanges", TestRandomRanges));
+    array_append(TestCaseRandom, &Tests, TestCaseRandom("TestRandomBatchMatchesScalar", TestRandomBatchMatchesScalar));
+    array_append(TestCaseRandom, &Tests, TestCaseRandom("TestRandomThroughput", TestRandomThroughput));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
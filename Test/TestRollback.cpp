@@ -0,0 +1,357 @@
+#include "../src/rollback.hpp"
+#include "../src/net.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+struct TestCaseRollback {
+public:
+    TestCaseRollback(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *RollbackFunctionName;
+    void (*TestRollbackFunction)(void);
+};
+
+TestCaseRollback::TestCaseRollback(const char *Name, void (*Fn)(void)):
+    RollbackFunctionName(Name), TestRollbackFunction(Fn) {}
+
+void TestCaseRollback::RunTestCase()
+{
+    TestRollbackFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", RollbackFunctionName);
+}
+
+static void SetupGame(Game *game)
+{
+    game->AddPaddle(0.0f, -0.9f, 0.4f, 0.05f, 2.0f);
+    game->AddPaddle(0.0f, 0.9f, 0.4f, 0.05f, 2.0f);
+    for (uint32_t row = 0; row < 4; ++row) {
+        for (uint32_t col = 0; col < 10; ++col) {
+            game->AddBrick(-0.9f + col * 0.2f, -0.15f + row * 0.1f, 0.18f, 0.08f, 1 + row % 2, 0, (uint8_t)row);
+        }
+    }
+    game->AddBall(0.1f, -0.5f, 0.03f, 0.7f, 1.1f);
+    game->AddBall(-0.1f, 0.5f, 0.03f, -0.6f, -1.2f);
+}
+
+// NOTE: Deterministic input script, held for a few ticks at a time like a player would
+static uint8_t ScriptInput(uint32_t player, uint64_t tick)
+{
+    uint32_t x = (uint32_t)(tick / 11) * 2654435761u + player * 40503u + 12345u;
+    x ^= x >> 15;
+    x *= 2246822519u;
+    x ^= x >> 13;
+    return (uint8_t)(x % 3);
+}
+
+static uint8_t TrueInput(uint32_t player, uint64_t tick, uint32_t input_delay)
+{
+    return tick < input_delay ? (uint8_t)INPUT_NONE : ScriptInput(player, tick);
+}
+
+static uint32_t GameChecksum(const Game *game)
+{
+    StateBuffer state = {};
+    SaveState(game, &state);
+    uint32_t checksum = StateChecksum(&state);
+    state_buffer_free(&state);
+    return checksum;
+}
+
+static uint32_t ReferenceChecksum(uint64_t ticks, uint32_t input_delay)
+{
+    Game game;
+    SetupGame(&game);
+    for (uint64_t tick = 0; tick < ticks; ++tick) {
+        uint8_t inputs[MAX_PADDLES] = {TrueInput(0, tick, input_delay), TrueInput(1, tick, input_delay)};
+        game.GameUpdate(inputs);
+    }
+    return GameChecksum(&game);
+}
+
+void TestRollbackStateRoundTrip(void)
+{
+    Game game;
+    SetupGame(&game);
+    for (uint32_t i = 0; i < 50; ++i) game.GameUpdate(nullptr);
+
+    StateBuffer state = {};
+    SaveState(&game, &state);
+    for (uint32_t i = 0; i < 300; ++i) game.GameUpdate(nullptr);
+    uint32_t expected = GameChecksum(&game);
+    uint32_t score = game.score;
+    assert(score > 0);
+
+    float *ball_x = game.balls.x;
+    assert(LoadState(&game, &state));
+    assert(game.tick == 50);
+    // NOTE: Owned columns are reused, restoring does not allocate
+    assert(game.balls.x == ball_x);
+    for (uint32_t i = 0; i < 300; ++i) game.GameUpdate(nullptr);
+    assert(GameChecksum(&game) == expected);
+    assert(game.score == score);
+
+    // NOTE: Truncated buffers are rejected
+    state.size -= 1;
+    assert(!LoadState(&game, &state));
+    state_buffer_free(&state);
+}
+
+// NOTE: In-memory link with a fixed delay in frames and deterministic loss
+struct FakeLink {
+    uint8_t data[64][sizeof(RollbackPacket)];
+    size_t size[64];
+    uint64_t due[64];
+    uint32_t count;
+    uint32_t seed;
+};
+
+static void LinkSend(FakeLink *link, const RollbackPacket *packet, size_t size, uint64_t now, uint64_t delay, float loss)
+{
+    link->seed ^= link->seed << 13;
+    link->seed ^= link->seed >> 17;
+    link->seed ^= link->seed << 5;
+    if ((link->seed >> 8) * (1.0f / 16777216.0f) < loss) return;
+    if (link->count == 64) return;
+    memcpy(link->data[link->count], packet, size);
+    link->size[link->count] = size;
+    link->due[link->count] = now + delay;
+    link->count++;
+}
+
+static void LinkDeliver(FakeLink *link, RollbackSession *session, uint64_t now)
+{
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < link->count; ++i) {
+        if (link->due[i] <= now) {
+            assert(session->ReadPacket(link->data[i], link->size[i]));
+        } else {
+            memmove(link->data[kept], link->data[i], link->size[i]);
+            link->size[kept] = link->size[i];
+            link->due[kept] = link->due[i];
+            kept++;
+        }
+    }
+    link->count = kept;
+}
+
+// NOTE: Advances both peers to `ticks`, then keeps exchanging packets until every input is confirmed
+static void RunPeers(Game *games, RollbackSession **sessions, uint64_t ticks,
+                     void (*exchange)(void *context, RollbackSession **sessions, uint64_t frame), void *context)
+{
+    for (uint64_t frame = 0; frame < 100000; ++frame) {
+        bool settled = true;
+        for (uint32_t p = 0; p < 2; ++p) {
+            RollbackSession *session = sessions[p];
+            if (session->local_next < ticks) session->AddLocalInput(ScriptInput(p, session->local_next));
+            // NOTE: Stops simulating at `ticks` since no local input is added past it, late rollbacks still apply
+            session->AdvanceFrame(&games[p]);
+            settled = settled && session->current == ticks && session->remote_confirmed >= ticks &&
+                      session->rollback_from == UINT64_MAX;
+        }
+        if (settled) return;
+        exchange(context, sessions, frame);
+    }
+    assert(false && "Peers never converged");
+}
+
+struct FakeLinks {
+    FakeLink links[2];
+    uint64_t delay;
+    float loss;
+};
+
+static void FakeExchange(void *context, RollbackSession **sessions, uint64_t frame)
+{
+    FakeLinks *fake = (FakeLinks*)context;
+    RollbackPacket packet;
+    for (uint32_t p = 0; p < 2; ++p) {
+        size_t size = sessions[p]->BuildPacket(&packet);
+        LinkSend(&fake->links[p], &packet, size, frame, fake->delay, fake->loss);
+    }
+    for (uint32_t p = 0; p < 2; ++p) LinkDeliver(&fake->links[p], sessions[1 - p], frame);
+}
+
+void TestRollbackConvergesWithDelayAndLoss(void)
+{
+    const uint64_t ticks = 1200;
+    const uint32_t input_delay = 2;
+    Game games[2];
+    SetupGame(&games[0]);
+    SetupGame(&games[1]);
+    RollbackSession first(0, input_delay);
+    RollbackSession second(1, input_delay);
+    RollbackSession *sessions[2] = {&first, &second};
+
+    FakeLinks fake = {};
+    fake.links[0].seed = 0x1234u;
+    fake.links[1].seed = 0x8765u;
+    fake.delay = 5;
+    fake.loss = 0.25f;
+    RunPeers(games, sessions, ticks, FakeExchange, &fake);
+
+    uint32_t expected = ReferenceChecksum(ticks, input_delay);
+    assert(GameChecksum(&games[0]) == expected);
+    assert(GameChecksum(&games[1]) == expected);
+    assert(first.rollbacks > 0 && second.rollbacks > 0);
+    assert(first.max_resimulated <= ROLLBACK_MAX_PREDICTION);
+    assert(first.desyncs == 0 && second.desyncs == 0);
+}
+
+// NOTE: With a link far slower than the prediction window the peers stall instead of diverging
+void TestRollbackStallsOnSlowLink(void)
+{
+    const uint64_t ticks = 300;
+    Game games[2];
+    SetupGame(&games[0]);
+    SetupGame(&games[1]);
+    RollbackSession first(0, 0);
+    RollbackSession second(1, 0);
+    RollbackSession *sessions[2] = {&first, &second};
+
+    FakeLinks fake = {};
+    fake.links[0].seed = 0x4321u;
+    fake.links[1].seed = 0x5678u;
+    fake.delay = 20;
+    fake.loss = 0.0f;
+    RunPeers(games, sessions, ticks, FakeExchange, &fake);
+
+    assert(first.stalls > 0);
+    assert(first.max_resimulated <= ROLLBACK_MAX_PREDICTION);
+    assert(GameChecksum(&games[0]) == ReferenceChecksum(ticks, 0));
+    assert(GameChecksum(&games[1]) == GameChecksum(&games[0]));
+}
+
+struct UdpPeers {
+    UdpTransport transports[2];
+    uint64_t now;
+};
+
+static void UdpExchange(void *context, RollbackSession **sessions, uint64_t frame)
+{
+    (void)frame;
+    UdpPeers *peers = (UdpPeers*)context;
+    peers->now += 16667;
+    RollbackPacket packet;
+    for (uint32_t p = 0; p < 2; ++p) {
+        size_t size = sessions[p]->BuildPacket(&packet);
+        peers->transports[p].Send(&packet, size, peers->now);
+    }
+    uint8_t buffer[NET_MAX_PACKET];
+    for (uint32_t p = 0; p < 2; ++p) {
+        int size;
+        while ((size = peers->transports[p].Receive(buffer, sizeof(buffer), peers->now)) > 0) {
+            sessions[p]->ReadPacket(buffer, (size_t)size);
+        }
+    }
+}
+
+void TestRollbackOverLoopback(void)
+{
+    const uint64_t ticks = 600;
+    const uint32_t input_delay = 1;
+    uint16_t base = (uint16_t)(40000 + getpid() % 20000);
+
+    UdpPeers peers;
+    peers.now = 0;
+    for (uint32_t p = 0; p < 2; ++p) {
+        UdpTransport *transport = &peers.transports[p];
+        if (!transport->Open((uint16_t)(base + p)) || !transport->SetPeer("127.0.0.1", (uint16_t)(base + 1 - p))) {
+            printf("INFO: No loopback networking, skipping\n");
+            return;
+        }
+        transport->delay = 50000;
+        transport->jitter = 20000;
+        transport->loss = 0.1f;
+        transport->rng.Seed(0xABCDu + p);
+    }
+
+    Game games[2];
+    SetupGame(&games[0]);
+    SetupGame(&games[1]);
+    RollbackSession first(0, input_delay);
+    RollbackSession second(1, input_delay);
+    RollbackSession *sessions[2] = {&first, &second};
+    RunPeers(games, sessions, ticks, UdpExchange, &peers);
+
+    uint32_t expected = ReferenceChecksum(ticks, input_delay);
+    assert(GameChecksum(&games[0]) == expected);
+    assert(GameChecksum(&games[1]) == expected);
+    assert(peers.transports[0].dropped > 0);
+    assert(first.desyncs == 0 && second.desyncs == 0);
+}
+
+void TestRollbackResimulationCost(void)
+{
+    // NOTE: Both sessions play player 0, only `late` gets the remote input of the last window after predicting it
+    // NOTE: Short enough that the unacknowledged local inputs fit the ring without packets
+    const uint64_t warmup = 40;
+    Game games[2];
+    SetupGame(&games[0]);
+    SetupGame(&games[1]);
+    RollbackSession late(0, 0);
+    RollbackSession on_time(0, 0);
+    for (uint64_t tick = 0; tick < warmup; ++tick) {
+        late.AddLocalInput(ScriptInput(0, tick));
+        on_time.AddLocalInput(ScriptInput(0, tick));
+        late.AddRemoteInput(tick, ScriptInput(1, tick));
+        on_time.AddRemoteInput(tick, ScriptInput(1, tick));
+        assert(late.AdvanceFrame(&games[0]));
+        assert(on_time.AdvanceFrame(&games[1]));
+    }
+
+    // NOTE: The remote player changes input right when its packets stop arriving, every predicted tick is wrong
+    uint8_t remote = (uint8_t)((ScriptInput(1, warmup - 1) + 1) % 3);
+    for (uint64_t tick = warmup; tick < warmup + ROLLBACK_MAX_PREDICTION; ++tick) {
+        late.AddLocalInput(ScriptInput(0, tick));
+        on_time.AddLocalInput(ScriptInput(0, tick));
+        on_time.AddRemoteInput(tick, remote);
+        assert(late.AdvanceFrame(&games[0]));
+        assert(on_time.AdvanceFrame(&games[1]));
+    }
+    assert(late.current == on_time.current && late.rollbacks == 0);
+    assert(GameChecksum(&games[0]) != GameChecksum(&games[1]));
+
+    for (uint64_t tick = warmup; tick < warmup + ROLLBACK_MAX_PREDICTION; ++tick) late.AddRemoteInput(tick, remote);
+    assert(late.rollback_from == warmup);
+    timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    // NOTE: No new local input, the frame only restores and resimulates the window
+    assert(!late.AdvanceFrame(&games[0]));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) * 1e-6;
+    printf("INFO: Restore + resimulate %u ticks: %.4f ms\n", ROLLBACK_MAX_PREDICTION, ms);
+
+    assert(late.rollbacks == 1 && on_time.rollbacks == 0);
+    assert(late.max_resimulated == ROLLBACK_MAX_PREDICTION && late.resimulated == ROLLBACK_MAX_PREDICTION);
+    assert(late.current == warmup + ROLLBACK_MAX_PREDICTION);
+    assert(GameChecksum(&games[0]) == GameChecksum(&games[1]));
+}
+
+typedef ARRAY(TestCaseRollback) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseRollback);
+
+    array_append(TestCaseRollback, &Tests, TestCaseRollback("TestRollbackStateRoundTrip", TestRollbackStateRoundTrip));
+    array_append(TestCaseRollback, &Tests, TestCaseRollback("TestRollbackConvergesWithDelayAndLoss", TestRollbackConvergesWithDelayAndLoss));
+    array_append(TestCaseRollback, &Tests, TestCaseRollback("TestRollbackStallsOnSlowLink", TestRollbackStallsOnSlowLink));
+    array_append(TestCaseRollback, &Tests, TestCaseRollback("TestRollbackOverLoopback", TestRollbackOverLoopback));
+    array_append(TestCaseRollback, &Tests, TestCaseRollback("TestRollbackResimulationCost", TestRollbackResimulationCost));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
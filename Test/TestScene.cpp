@@ -0,0 +1,153 @@
+#include "../src/scene.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <ctime>
+
+struct TestCaseScene {
+public:
+    TestCaseScene(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *SceneFunctionName;
+    void (*TestSceneFunction)(void);
+};
+
+TestCaseScene::TestCaseScene(const char *Name, void (*Fn)(void)):
+    SceneFunctionName(Name), TestSceneFunction(Fn) {}
+
+void TestCaseScene::RunTestCase()
+{
+    TestSceneFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", SceneFunctionName);
+}
+
+static Vector4 WorldPoint(const SceneGraph *scene, uint32_t node, float x, float y)
+{
+    return scene->World(node)->transform(Vector4(x, y, 0.0f, Vector4Type::Point));
+}
+
+static bool Near(float a, float b)
+{
+    return fabsf(a - b) < 1e-4f;
+}
+
+void TestSceneRootTransform(void)
+{
+    SceneGraph scene;
+    uint32_t node = scene.AddNode(SCENE_NO_PARENT, 0.25f, -0.5f);
+    assert(scene.Update() == 1);
+    Vector4 p = WorldPoint(&scene, node, 0.1f, 0.1f);
+    assert(Near(p.getX(), 0.35f) && Near(p.getY(), -0.4f));
+
+    scene.SetScale(node, 2.0f, 3.0f);
+    scene.Update();
+    p = WorldPoint(&scene, node, 0.1f, 0.1f);
+    assert(Near(p.getX(), 0.45f) && Near(p.getY(), -0.2f));
+}
+
+// NOTE: Child offsets are rotated and scaled by the parent, then moved with it
+void TestSceneHierarchy(void)
+{
+    SceneGraph scene;
+    uint32_t parent = scene.AddNode(SCENE_NO_PARENT, 1.0f, 0.0f);
+    uint32_t child = scene.AddNode(parent, 0.5f, 0.0f);
+    uint32_t grandchild = scene.AddNode(child, 0.0f, 0.25f);
+    scene.SetRotation(parent, 90.0f);
+    scene.Update();
+
+    Vector4 c = WorldPoint(&scene, child, 0.0f, 0.0f);
+    assert(Near(c.getX(), 1.0f) && Near(c.getY(), 0.5f));
+    Vector4 g = WorldPoint(&scene, grandchild, 0.0f, 0.0f);
+    assert(Near(g.getX(), 0.75f) && Near(g.getY(), 0.5f));
+
+    scene.SetPosition(parent, 0.0f, 0.0f);
+    scene.Update();
+    g = WorldPoint(&scene, grandchild, 0.0f, 0.0f);
+    assert(Near(g.getX(), -0.25f) && Near(g.getY(), 0.5f));
+}
+
+// NOTE: Only dirty subtrees are rebuilt, a clean frame costs one pass over the flags
+void TestSceneDirtySubtrees(void)
+{
+    SceneGraph scene;
+    uint32_t root = scene.AddNode(SCENE_NO_PARENT, 0.0f, 0.0f);
+    uint32_t formation = scene.AddNode(root, 0.0f, 0.5f);
+    uint32_t paddle = scene.AddNode(root, 0.0f, -0.9f);
+    uint32_t first_brick = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        uint32_t node = scene.AddNode(formation, -0.9f + (i % 40) * 0.045f, (i / 40) * 0.02f);
+        if (i == 0) first_brick = node;
+    }
+    assert(scene.Update() == 1003);
+    assert(scene.Update() == 0);
+
+    scene.SetPosition(paddle, 0.3f, -0.9f);
+    assert(scene.Update() == 1);
+
+    // NOTE: Setting the same value again is not a change
+    scene.SetPosition(paddle, 0.3f, -0.9f);
+    assert(scene.Update() == 0);
+
+    scene.SetPosition(formation, 0.1f, 0.4f);
+    assert(scene.Update() == 1001);
+    Vector4 b = WorldPoint(&scene, first_brick, 0.0f, 0.0f);
+    assert(Near(b.getX(), -0.8f) && Near(b.getY(), 0.4f));
+    Vector4 p = WorldPoint(&scene, paddle, 0.0f, 0.0f);
+    assert(Near(p.getX(), 0.3f) && Near(p.getY(), -0.9f));
+
+    scene.SetPosition(first_brick, 0.0f, 0.0f);
+    assert(scene.Update() == 1);
+    assert(scene.updates == 6);
+}
+
+void TestSceneFormationCost(void)
+{
+    SceneGraph scene;
+    uint32_t formation = scene.AddNode(SCENE_NO_PARENT, 0.0f, 0.0f);
+    for (uint32_t i = 0; i < 1000; ++i) scene.AddNode(formation, (i % 40) * 0.045f, (i / 40) * 0.02f);
+    scene.Update();
+
+    const uint32_t frames = 100;
+    uint32_t moved_rebuilt = 0, still_rebuilt = 0;
+    timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        scene.SetPosition(formation, sinf((frame + 1) * 0.1f) * 0.2f, 0.0f);
+        moved_rebuilt += scene.Update();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double moving = ((end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) * 1e-6) / frames;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t frame = 0; frame < frames; ++frame) still_rebuilt += scene.Update();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double still = ((end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) * 1e-6) / frames;
+    printf("INFO: 1000 brick formation: %.4f ms per moved frame, %.4f ms per still frame\n", moving, still);
+    // NOTE: Moving the formation rebuilds it and its 1000 bricks once per frame, a still frame rebuilds nothing
+    assert(moved_rebuilt == frames * 1001);
+    assert(still_rebuilt == 0);
+}
+
+typedef ARRAY(TestCaseScene) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseScene);
+
+    array_append(TestCaseScene, &Tests, TestCaseScene("TestSceneRootTransform", TestSceneRootTransform));
+    array_append(TestCaseScene, &Tests, TestCaseScene("TestSceneHierarchy", TestSceneHierarchy));
+    array_append(TestCaseScene, &Tests, TestCaseScene("TestSceneDirtySubtrees", TestSceneDirtySubtrees));
+    array_append(TestCaseScene, &Tests, TestCaseScene("TestSceneFormationCost", TestSceneFormationCost));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
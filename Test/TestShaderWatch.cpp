@@ -0,0 +1,161 @@
+#include "../src/shader_watch.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_WATCH_DIR "/tmp/breakoutt_shader_watch_test"
+
+struct TestCaseShaderWatch {
+public:
+    TestCaseShaderWatch(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *ShaderWatchFunctionName;
+    void (*TestShaderWatchFunction)(void);
+};
+
+TestCaseShaderWatch::TestCaseShaderWatch(const char *Name, void (*Fn)(void)):
+    ShaderWatchFunctionName(Name), TestShaderWatchFunction(Fn) {}
+
+void TestCaseShaderWatch::RunTestCase()
+{
+    TestShaderWatchFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", ShaderWatchFunctionName);
+}
+
+static void WriteTestFile(const char *name, const char *text)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", TEST_WATCH_DIR, name);
+    FILE *file = fopen(path, "w");
+    assert(file != nullptr);
+    fputs(text, file);
+    fclose(file);
+}
+
+static void RemoveTestDir(void)
+{
+    // NOTE: Only what the tests write, never a recursive delete
+    const char *names[] = {"a.vert", "b.frag", "c.comp", "c.comp.tmp"};
+    char path[256];
+    for (size_t i = 0; i < sizeof(names)/sizeof(names[0]); ++i) {
+        snprintf(path, sizeof(path), "%s/%s", TEST_WATCH_DIR, names[i]);
+        unlink(path);
+    }
+    rmdir(TEST_WATCH_DIR);
+}
+
+// NOTE: The worker runs on its own thread, give it up to a second to see the events
+static bool WaitPending(const ShaderWatch *watch)
+{
+    for (int i = 0; i < 1000; ++i) {
+        if (watch->Pending()) return true;
+        usleep(1000);
+    }
+    return false;
+}
+
+static bool HasName(const ShaderWatchChanges *changes, const char *name)
+{
+    for (uint32_t i = 0; i < changes->count; ++i) {
+        if (strcmp(changes->names[i], name) == 0) return true;
+    }
+    return false;
+}
+
+void TestShaderWatchReportsWrites(void)
+{
+    RemoveTestDir();
+    assert(mkdir(TEST_WATCH_DIR, 0755) == 0);
+    ShaderWatch watch;
+    assert(watch.Start(TEST_WATCH_DIR));
+    assert(!watch.Pending());
+
+    WriteTestFile("a.vert", "one");
+    WriteTestFile("b.frag", "two");
+    WriteTestFile("a.vert", "three");
+    assert(WaitPending(&watch));
+    usleep(20000); // NOTE: let the remaining writes land in the same batch
+
+    ShaderWatchChanges changes;
+    watch.TakeChanges(&changes);
+    assert(!changes.all);
+    assert(HasName(&changes, "a.vert") && HasName(&changes, "b.frag"));
+    // NOTE: A file written twice is reported once
+    assert(changes.count == 2);
+    assert(!watch.Pending());
+
+    watch.Stop();
+    RemoveTestDir();
+}
+
+void TestShaderWatchReportsRenames(void)
+{
+    RemoveTestDir();
+    assert(mkdir(TEST_WATCH_DIR, 0755) == 0);
+    WriteTestFile("c.comp.tmp", "four");
+    ShaderWatch watch;
+    assert(watch.Start(TEST_WATCH_DIR));
+
+    // NOTE: Editors that save through a temporary rename it over the original
+    assert(rename(TEST_WATCH_DIR "/c.comp.tmp", TEST_WATCH_DIR "/c.comp") == 0);
+    assert(WaitPending(&watch));
+    ShaderWatchChanges changes;
+    watch.TakeChanges(&changes);
+    assert(HasName(&changes, "c.comp"));
+    assert(!HasName(&changes, "c.comp.tmp"));
+
+    watch.Stop();
+    RemoveTestDir();
+}
+
+void TestShaderWatchStartStop(void)
+{
+    ShaderWatch watch;
+    assert(!watch.Start(TEST_WATCH_DIR "/missing"));
+    assert(watch.inotify_fd == -1 && watch.wake_fd == -1);
+
+    RemoveTestDir();
+    assert(mkdir(TEST_WATCH_DIR, 0755) == 0);
+    assert(watch.Start(TEST_WATCH_DIR));
+    watch.Stop();
+    assert(!watch.worker.joinable());
+    // NOTE: Writes after Stop are never seen, and stopping twice is harmless
+    WriteTestFile("a.vert", "five");
+    usleep(20000);
+    assert(!watch.Pending());
+    watch.Stop();
+
+    // NOTE: A stopped watch can be started again
+    assert(watch.Start(TEST_WATCH_DIR));
+    WriteTestFile("b.frag", "six");
+    assert(WaitPending(&watch));
+    watch.Stop();
+    RemoveTestDir();
+}
+
+typedef ARRAY(TestCaseShaderWatch) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseShaderWatch);
+
+    array_append(TestCaseShaderWatch, &Tests, TestCaseShaderWatch("TestShaderWatchReportsWrites", TestShaderWatchReportsWrites));
+    array_append(TestCaseShaderWatch, &Tests, TestCaseShaderWatch("TestShaderWatchReportsRenames", TestShaderWatchReportsRenames));
+    array_append(TestCaseShaderWatch, &Tests, TestCaseShaderWatch("TestShaderWatchStartStop", TestShaderWatchStartStop));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
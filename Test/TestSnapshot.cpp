@@ -0,0 +1,163 @@
+#include "../src/game.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+
+#define SNAPSHOT_TEST_PATH "/tmp/breakoutt_test.snap"
+
+struct TestCaseSnapshot {
+public:
+    TestCaseSnapshot(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *SnapshotFunctionName;
+    void (*TestSnapshotFunction)(void);
+};
+
+TestCaseSnapshot::TestCaseSnapshot(const char *Name, void (*Fn)(void)):
+    SnapshotFunctionName(Name), TestSnapshotFunction(Fn) {}
+
+void TestCaseSnapshot::RunTestCase()
+{
+    TestSnapshotFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", SnapshotFunctionName);
+}
+
+static void FillGame(Game *game, uint32_t brick_count)
+{
+    game->AddPaddle(0.0f, -0.9f, 0.4f, 0.05f, 2.0f);
+    game->AddBall(0.0f, 0.0f, 0.1f, 1.0f, 1.0f);
+    game->AddBall(0.5f, -0.2f, 0.05f, -0.7f, 0.3f);
+    for (uint32_t i = 0; i < brick_count; ++i) {
+        game->AddBrick(-0.9f + (i % 10) * 0.2f, 0.9f - (i / 10) * 0.1f, 0.18f, 0.08f,
+                       (uint8_t)(1 + i % 3), (uint8_t)(i % 4), (uint8_t)(i % 7));
+    }
+}
+
+static bool GamesEqual(const Game *a, const Game *b)
+{
+    if (a->tick != b->tick) return false;
+    if (a->balls.count != b->balls.count || a->bricks.count != b->bricks.count) return false;
+    if (a->paddle_count != b->paddle_count) return false;
+    if (memcmp(a->paddles, b->paddles, sizeof(Paddle) * a->paddle_count) != 0) return false;
+
+    size_t n = a->balls.count * sizeof(float);
+    if (memcmp(a->balls.x, b->balls.x, n) || memcmp(a->balls.y, b->balls.y, n) ||
+        memcmp(a->balls.vx, b->balls.vx, n) || memcmp(a->balls.vy, b->balls.vy, n) ||
+        memcmp(a->balls.radius, b->balls.radius, n)) return false;
+
+    size_t f = a->bricks.count * sizeof(float);
+    size_t u = a->bricks.count * sizeof(uint8_t);
+    return !(memcmp(a->bricks.x, b->bricks.x, f) || memcmp(a->bricks.y, b->bricks.y, f) ||
+             memcmp(a->bricks.w, b->bricks.w, f) || memcmp(a->bricks.h, b->bricks.h, f) ||
+             memcmp(a->bricks.hp, b->bricks.hp, u) || memcmp(a->bricks.type, b->bricks.type, u) ||
+             memcmp(a->bricks.color, b->bricks.color, u));
+}
+
+void TestSnapshotRoundTrip(void)
+{
+    Game saved;
+    FillGame(&saved, 1000);
+    for (int i = 0; i < 30; ++i) saved.GameUpdate(nullptr);
+    assert(SaveSnapshot(&saved, SNAPSHOT_TEST_PATH));
+
+    Game loaded;
+    assert(LoadSnapshot(&loaded, SNAPSHOT_TEST_PATH));
+    assert(loaded.mapping != nullptr);
+    assert(loaded.balls.borrowed && loaded.bricks.borrowed);
+    assert(GamesEqual(&saved, &loaded));
+}
+
+void TestSnapshotAlignment(void)
+{
+    Game saved;
+    FillGame(&saved, 37);
+    assert(SaveSnapshot(&saved, SNAPSHOT_TEST_PATH));
+
+    Game loaded;
+    assert(LoadSnapshot(&loaded, SNAPSHOT_TEST_PATH));
+    assert(((uintptr_t)loaded.balls.x % SOA_ALIGNMENT) == 0);
+    assert(((uintptr_t)loaded.balls.radius % SOA_ALIGNMENT) == 0);
+    assert(((uintptr_t)loaded.bricks.x % SOA_ALIGNMENT) == 0);
+    assert(((uintptr_t)loaded.bricks.color % SOA_ALIGNMENT) == 0);
+}
+
+void TestSnapshotSimulateAfterLoad(void)
+{
+    Game saved;
+    FillGame(&saved, 10);
+    assert(SaveSnapshot(&saved, SNAPSHOT_TEST_PATH));
+
+    Game loaded;
+    assert(LoadSnapshot(&loaded, SNAPSHOT_TEST_PATH));
+    uint8_t inputs[MAX_PADDLES] = {INPUT_LEFT};
+    for (int i = 0; i < 120; ++i) {
+        saved.GameUpdate(inputs);
+        loaded.GameUpdate(inputs);
+    }
+    assert(GamesEqual(&saved, &loaded));
+
+    // NOTE: Growing a borrowed column copies it out of the mapping
+    loaded.AddBall(0.0f, 0.0f, 0.1f, 0.0f, 1.0f);
+    assert(!loaded.balls.borrowed);
+    assert(loaded.balls.count == 3);
+    assert(loaded.balls.x[0] == saved.balls.x[0]);
+}
+
+void TestSnapshotRejectsGarbage(void)
+{
+    FILE *fp = fopen(SNAPSHOT_TEST_PATH, "wb");
+    assert(fp != nullptr);
+    char garbage[512] = "NOTASNAPSHOT";
+    fwrite(garbage, 1, sizeof(garbage), fp);
+    fclose(fp);
+
+    Game game;
+    FillGame(&game, 5);
+    assert(!LoadSnapshot(&game, SNAPSHOT_TEST_PATH));
+    // NOTE: A failed load leaves the current state untouched
+    assert(game.bricks.count == 5);
+}
+
+void TestSnapshotRejectsBadBrickIndices(void)
+{
+    const uint8_t bad_values[2] = {LEVEL_MAX_TYPES, LEVEL_MAX_COLORS};
+    for (uint32_t column = 0; column < 2; ++column) {
+        Game saved;
+        FillGame(&saved, 12);
+        // NOTE: A stale or crafted file with one out of range type, then one out of range color
+        if (column == 0) saved.bricks.type[7] = bad_values[0];
+        else saved.bricks.color[7] = bad_values[1];
+        assert(SaveSnapshot(&saved, SNAPSHOT_TEST_PATH));
+
+        Game game;
+        FillGame(&game, 5);
+        assert(!LoadSnapshot(&game, SNAPSHOT_TEST_PATH));
+        assert(game.bricks.count == 5);
+    }
+}
+
+typedef ARRAY(TestCaseSnapshot) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseSnapshot);
+
+    array_append(TestCaseSnapshot, &Tests, TestCaseSnapshot("TestSnapshotRoundTrip", TestSnapshotRoundTrip));
+    array_append(TestCaseSnapshot, &Tests, TestCaseSnapshot("TestSnapshotAlignment", TestSnapshotAlignment));
+    array_append(TestCaseSnapshot, &Tests, TestCaseSnapshot("TestSnapshotSimulateAfterLoad", TestSnapshotSimulateAfterLoad));
+    array_append(TestCaseSnapshot, &Tests, TestCaseSnapshot("TestSnapshotRejectsGarbage", TestSnapshotRejectsGarbage));
+    array_append(TestCaseSnapshot, &Tests, TestCaseSnapshot("TestSnapshotRejectsBadBrickIndices", TestSnapshotRejectsBadBrickIndices));
+
+    RunAllTestCases(&Tests);
+    remove(SNAPSHOT_TEST_PATH);
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include "../src/soak.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+struct TestCaseSoak {
+public:
+    TestCaseSoak(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *SoakFunctionName;
+    void (*TestSoakFunction)(void);
+};
+
+TestCaseSoak::TestCaseSoak(const char *Name, void (*Fn)(void)):
+    SoakFunctionName(Name), TestSoakFunction(Fn) {}
+
+void TestCaseSoak::RunTestCase()
+{
+    TestSoakFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", SoakFunctionName);
+}
+
+static void SetupGame(Game *game)
+{
+    game->AddPaddle(0.0f, -0.9f, 0.4f, 0.05f, 2.0f);
+    game->AddBall(0.0f, 0.0f, 0.03f, 0.7f, 1.1f);
+}
+
+static uint32_t CountLines(FILE *file)
+{
+    rewind(file);
+    uint32_t lines = 0;
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '\n') lines++;
+    }
+    return lines;
+}
+
+// NOTE: The prediction has to agree with the simulation, wall bounces included
+void TestSoakPredictBallX(void)
+{
+    Game game;
+    game.AddBall(0.6f, 0.5f, 0.03f, 1.3f, -0.8f);
+    float x, t;
+    assert(PredictBallX(&game, 0, -0.8f, &x, &t));
+    assert(!PredictBallX(&game, 0, 0.9f, &x, &t) && "ball moving away from that height");
+
+    assert(PredictBallX(&game, 0, -0.8f, &x, &t));
+    uint32_t ticks = (uint32_t)(t / DELTA_TIME);
+    for (uint32_t i = 0; i < ticks; ++i) game.GameUpdate(nullptr);
+    float remaining = t - ticks * DELTA_TIME;
+    float end_x = game.balls.x[0] + game.balls.vx[0] * remaining;
+    // NOTE: The game flips vx one tick after the ball crosses a wall, up to one tick of travel off per bounce
+    assert(fabsf(end_x - x) <= 2.0f * 1.3f * DELTA_TIME + 1e-4f);
+}
+
+void TestSoakAutoplayerKeepsBallInPlay(void)
+{
+    for (uint32_t seed = 1; seed <= 8; ++seed) {
+        Game game;
+        SetupGame(&game);
+        SoakSeedGame(&game, seed);
+        Autoplayer autoplayer(seed);
+        uint32_t misses = 0;
+        for (uint32_t tick = 0; tick < 60 * FPS; ++tick) {
+            uint8_t inputs[MAX_PADDLES] = {autoplayer.Input(&game, 0)};
+            game.GameUpdate(inputs);
+            misses += SoakCountMisses(&game);
+        }
+        assert(misses == 0);
+    }
+}
+
+// NOTE: Same seed, same run: the log lines only differ in frame times and memory
+void TestSoakHeadlessDeterministic(void)
+{
+    SoakConfig config = {30.0, 0, 7, 10.0, nullptr, nullptr};
+    uint64_t ticks[2];
+    uint32_t scores[2];
+    for (uint32_t run = 0; run < 2; ++run) {
+        Game game;
+        SetupGame(&game);
+        SoakSeedGame(&game, config.seed);
+        FILE *log = tmpfile();
+        assert(log != NULL);
+        assert(RunHeadlessSoak(&game, &config, log) >= 0);
+        // NOTE: One line every 10 s and a final one
+        assert(CountLines(log) == 4);
+        fclose(log);
+        ticks[run] = game.tick;
+        scores[run] = game.score;
+    }
+    assert(ticks[0] == (uint64_t)(30 * FPS));
+    assert(ticks[0] == ticks[1]);
+    assert(scores[0] == scores[1]);
+    assert(scores[0] > 0);
+}
+
+void TestSoakHeadlessClears(void)
+{
+    SoakConfig config = {600.0, 1, 3, 60.0, nullptr, nullptr};
+    Game game;
+    SetupGame(&game);
+    SoakSeedGame(&game, config.seed);
+    int clears = RunHeadlessSoak(&game, &config, nullptr);
+    assert(clears == 1);
+    assert(game.bricks.count == 50);
+    assert(!SoakLevelCleared(&game) && "refilled after the clear");
+
+    SoakConfig unbounded = {0.0, 0, 1, 10.0, nullptr, nullptr};
+    assert(RunHeadlessSoak(&game, &unbounded, nullptr) == -1);
+}
+
+void TestSoakMemoryUsage(void)
+{
+    size_t rss = 0, virt = 0;
+    assert(read_memory_usage(&rss, &virt));
+    assert(rss > 0);
+    assert(virt >= rss);
+}
+
+void TestSoakFrameHistogram(void)
+{
+    SoakMonitor monitor(1.0, nullptr);
+    for (uint32_t i = 0; i < 99; ++i) monitor.Frame(0.001);
+    monitor.Frame(0.2);
+    assert(monitor.frames == 100);
+    assert(fabs(monitor.max - 200.0) < 1e-9);
+    assert(!monitor.Due(0.5));
+    assert(monitor.Due(1.0));
+
+    FILE *log = tmpfile();
+    assert(log != NULL);
+    monitor.log = log;
+    Game game;
+    monitor.Report(&game, 1.0);
+    rewind(log);
+    char line[512];
+    assert(fgets(line, sizeof(line), log) != NULL);
+    assert(strstr(line, "p50=1.05ms") != NULL);
+    assert(strstr(line, "p99=1.05ms") != NULL);
+    assert(strstr(line, "max=200.000ms") != NULL);
+    fclose(log);
+    assert(monitor.frames == 0);
+    assert(!monitor.Due(1.5));
+}
+
+typedef ARRAY(TestCaseSoak) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseSoak);
+
+    array_append(TestCaseSoak, &Tests, TestCaseSoak("TestSoakPredictBallX", TestSoakPredictBallX));
+    array_append(TestCaseSoak, &Tests, TestCaseSoak("TestSoakAutoplayerKeepsBallInPlay", TestSoakAutoplayerKeepsBallInPlay));
+    array_append(TestCaseSoak, &Tests, TestCaseSoak("TestSoakHeadlessDeterministic", TestSoakHeadlessDeterministic));
+    array_append(TestCaseSoak, &Tests, TestCaseSoak("TestSoakHeadlessClears", TestSoakHeadlessClears));
+    array_append(TestCaseSoak, &Tests, TestCaseSoak("TestSoakMemoryUsage", TestSoakMemoryUsage));
+    array_append(TestCaseSoak, &Tests, TestCaseSoak("TestSoakFrameHistogram", TestSoakFrameHistogram));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include "../src/vecenv.hpp"
+#include "../util/array.h"
+
+#include <cassert>
+#include <cstring>
+
+struct TestCaseVecEnv {
+public:
+    TestCaseVecEnv(const char *Name, void (*Fn)(void));
+    void RunTestCase();
+private:
+    const char *VecEnvFunctionName;
+    void (*TestVecEnvFunction)(void);
+};
+
+TestCaseVecEnv::TestCaseVecEnv(const char *Name, void (*Fn)(void)):
+    VecEnvFunctionName(Name), TestVecEnvFunction(Fn) {}
+
+void TestCaseVecEnv::RunTestCase()
+{
+    TestVecEnvFunction();
+    printf("INFO: TestCase \"%s\" passed.\n", VecEnvFunctionName);
+}
+
+static uint32_t test_seed = 0x2545F491u;
+static uint8_t RandomAction(void)
+{
+    test_seed ^= test_seed << 13;
+    test_seed ^= test_seed >> 17;
+    test_seed ^= test_seed << 5;
+    return (uint8_t)((test_seed >> 8) % 3);
+}
+
+static void AssertSameOutputs(const VecEnv *a, const VecEnv *b)
+{
+    assert(a->count == b->count);
+    size_t n = a->count * sizeof(float);
+    assert(memcmp(a->ball_x, b->ball_x, n) == 0);
+    assert(memcmp(a->ball_y, b->ball_y, n) == 0);
+    assert(memcmp(a->ball_vx, b->ball_vx, n) == 0);
+    assert(memcmp(a->ball_vy, b->ball_vy, n) == 0);
+    assert(memcmp(a->paddle_x, b->paddle_x, n) == 0);
+    assert(memcmp(a->bricks_left, b->bricks_left, n) == 0);
+    assert(memcmp(a->reward, b->reward, n) == 0);
+    assert(memcmp(a->done, b->done, a->count) == 0);
+}
+
+void TestVecEnvThreadCountIndependent(void)
+{
+    const uint32_t count = 37;
+    VecEnv single(count, 1, 1, 42, nullptr);
+    VecEnv multi(count, 4, 1, 42, nullptr);
+    assert(multi.thread_count == 4);
+    AssertSameOutputs(&single, &multi);
+
+    uint8_t actions[count];
+    for (uint32_t step = 0; step < 3000; ++step) {
+        for (uint32_t i = 0; i < count; ++i) actions[i] = RandomAction();
+        single.Step(actions);
+        multi.Step(actions);
+        AssertSameOutputs(&single, &multi);
+    }
+    assert(single.ticks == multi.ticks);
+    assert(single.episodes == multi.episodes);
+    assert(single.episodes > 0);
+}
+
+void TestVecEnvMatchesSingleGame(void)
+{
+    const uint32_t count = 8;
+    const uint32_t seed = 7;
+    VecEnv env(count, 2, 1, seed, nullptr);
+
+    // NOTE: Env 5 replayed by hand with the same stream
+    Rng master(seed);
+    for (uint32_t i = 0; i < 5; ++i) master.Jump();
+    Rng game_rng = master.Split();
+    Game game;
+    DefaultEnvSetup(&game, &game_rng);
+
+    uint8_t actions[count];
+    for (uint32_t step = 0; step < 2000; ++step) {
+        for (uint32_t i = 0; i < count; ++i) actions[i] = RandomAction();
+        env.Step(actions);
+        if (env.done[5]) break;
+
+        uint8_t inputs[MAX_PADDLES] = {actions[5]};
+        game.GameUpdate(inputs);
+        assert(env.ball_x[5] == game.balls.x[0] && env.ball_y[5] == game.balls.y[0]);
+        assert(env.ball_vx[5] == game.balls.vx[0] && env.ball_vy[5] == game.balls.vy[0]);
+        assert(env.paddle_x[5] == game.paddles[0].x);
+    }
+}
+
+void TestVecEnvRewards(void)
+{
+    const uint32_t count = 16;
+    VecEnv env(count, 2, 1, 1234, nullptr);
+    uint8_t actions[count] = {};
+
+    float brick_rewards = 0.0f;
+    uint32_t misses = 0;
+    for (uint32_t step = 0; step < 4000; ++step) {
+        env.Step(actions);
+        for (uint32_t i = 0; i < count; ++i) {
+            float reward = env.reward[i];
+            if (reward < 0.0f) {
+                // NOTE: The idle paddle eventually misses, which ends the episode and resets
+                assert(env.done[i]);
+                assert(env.games[i].tick == 0);
+                assert(env.bricks_left[i] == 1.0f);
+                misses++;
+                reward -= ENV_MISS_REWARD;
+            }
+            brick_rewards += reward;
+        }
+    }
+    assert(misses > 0);
+    assert(misses == env.episodes);
+    assert(brick_rewards > 0.0f);
+    assert(env.ticks == 4000ull * count);
+}
+
+void TestVecEnvFrameSkip(void)
+{
+    const uint32_t count = 4;
+    VecEnv skip(count, 1, 4, 99, nullptr);
+    VecEnv step(count, 1, 1, 99, nullptr);
+
+    uint8_t actions[count];
+    for (uint32_t n = 0; n < 200; ++n) {
+        for (uint32_t i = 0; i < count; ++i) actions[i] = RandomAction();
+        skip.Step(actions);
+        float reward[count] = {};
+        bool done = false;
+        for (uint32_t k = 0; k < 4; ++k) {
+            step.Step(actions);
+            for (uint32_t i = 0; i < count; ++i) {
+                reward[i] += step.reward[i];
+                done = done || step.done[i];
+            }
+        }
+        // NOTE: Episode boundaries cut skipped steps short, only compare until the first one
+        if (done || skip.episodes > 0) break;
+        for (uint32_t i = 0; i < count; ++i) {
+            assert(skip.ball_x[i] == step.ball_x[i] && skip.paddle_x[i] == step.paddle_x[i]);
+            assert(skip.reward[i] == reward[i]);
+        }
+    }
+    assert(skip.ticks > 0);
+}
+
+typedef ARRAY(TestCaseVecEnv) TestCases;
+void RunAllTestCases(const TestCases *Tests)
+{
+    for (uint32_t i = 0; i < Tests->count; ++i) {
+        Tests->items[i].RunTestCase();
+    }
+    printf("SUCCESS: All %u Test cases Passed\n", Tests->count);
+}
+
+int main(void)
+{
+    TestCases Tests = {nullptr, 0, 0};
+    array_new(&Tests, TestCaseVecEnv);
+
+    array_append(TestCaseVecEnv, &Tests, TestCaseVecEnv("TestVecEnvThreadCountIndependent", TestVecEnvThreadCountIndependent));
+    array_append(TestCaseVecEnv, &Tests, TestCaseVecEnv("TestVecEnvMatchesSingleGame", TestVecEnvMatchesSingleGame));
+    array_append(TestCaseVecEnv, &Tests, TestCaseVecEnv("TestVecEnvRewards", TestVecEnvRewards));
+    array_append(TestCaseVecEnv, &Tests, TestCaseVecEnv("TestVecEnvFrameSkip", TestVecEnvFrameSkip));
+
+    RunAllTestCases(&Tests);
+    return 0;
+}
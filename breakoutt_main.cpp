@@ -1,25 +1,276 @@
 #include "./src/breakoutt.hpp"
+#include "./src/asset_pack.hpp"
+
+#include <unistd.h>
+#include <dirent.h>
 
 #define SCREEN_WIDTH  800 // Window width
 #define SCREEN_HEIGHT 600 // Window height
 #define RADIUS 0.1f
 #define ASPECT_RATIO ((float)SCREEN_WIDTH / (float)SCREEN_HEIGHT)
-#define FPS 60
-#define DELTA_TIME   ((float) 1 / (float)FPS)
 #define MAX_UPDATES 5
+#define MAX_FRAME_TIME 0.25 // NOTE: Longer frames (breakpoints, window drags) are clamped
+#define SHADER_CACHE_DIR "build/shader_cache"
+#define SHADER_DIR "shader"
+#define BATCH_VERTEX_SHADER "shader/vertex_shader.vert"
+#define BATCH_FRAGMENT_SHADER "shader/sprite.frag"
+#define MAX_PRELOAD_SHADERS 32
+
+// NOTE: build/assets.pak, assembled in by src/asset_pack_data.S
+extern "C" const char asset_pack_data[];
+extern "C" const char asset_pack_data_end[];
 
 #define RED (Color(1.0f, 0.0f, 0.0f, 1.0f))
 #define GREEN (Color(0.0f, 1.0f, 0.0f, 1.0f))
 #define BLUE (Color(0.0f, 0.0f, 1.0f, 1.0f))
 #define WHITE (Color(1.0f, 1.0f, 1.0f, 1.0f))
 
-Indices BallIndices = {nullptr, 0, 0};
-Vertices BallVertices = {nullptr, 0, 0};
+// NOTE: Retained batch slots, the two paddles then one per brick
+#define SLOT_PADDLE 0
+#define SLOT_REMOTE_PADDLE 1
+#define SLOT_BRICKS 2
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [--load <snapshot>] [--save <snapshot>] [--level <level.lvl>] [--events]\n"
+                    "       [--player <0|1> --port <local port> --peer <host:port> [--input-delay n]]\n"
+                    "       [--autoplay] [--headless] [--duration <seconds>] [--clears <n>] [--seed <n>] [--stats-interval <seconds>]\n"
+                    "       [--generate <seed> [--generate-size <cols>x<rows>]] [--gpu-balls <n>] [--mesh-balls]\n"
+                    "       [--atlas <atlas.atl> | --skin <dir> [--save-atlas <atlas.atl>]]\n"
+                    "       [--shader-cache <dir> | --no-shader-cache] [--watch-shaders] [--loose-assets]\n", program);
+}
+
+// NOTE: Bricks are stored in playfield space, the batch model matrix places them.
+// Unchanged bricks compare equal to their slot and upload nothing
+static void sync_bricks(BatchRenderer *batch, const Bricks *bricks, const Atlas *atlas, const int32_t *brick_sprites)
+{
+    batch->ResizeRetained(SLOT_BRICKS + bricks->count);
+    for (uint32_t i = 0; i < bricks->count; ++i) {
+        if (bricks->hp[i] == 0) {
+            batch->HideRetained(SLOT_BRICKS + i);
+            continue;
+        }
+        int32_t sprite = brick_sprites[bricks->type[i]];
+        batch->SetRetainedQuad(SLOT_BRICKS + i, bricks->x[i], bricks->y[i], bricks->w[i], bricks->h[i],
+                               sprite < 0 ? nullptr : &atlas->sprites[sprite], BrickPalette[bricks->color[i]]);
+    }
+}
+
+// NOTE: Maps every shader up front on several threads; the loaders below share the mappings
+static void preload_shaders(const char *dir)
+{
+    DIR *directory = opendir(dir);
+    if (directory == nullptr) return;
+    static char paths[MAX_PRELOAD_SHADERS][ASSET_PATH_LENGTH];
+    const char *path_list[MAX_PRELOAD_SHADERS];
+    uint32_t count = 0;
+    for (struct dirent *entry = readdir(directory); entry && count < MAX_PRELOAD_SHADERS; entry = readdir(directory)) {
+        if (entry->d_name[0] == '.') continue;
+        int n = snprintf(paths[count], ASSET_PATH_LENGTH, "%s/%s", dir, entry->d_name);
+        if (n <= 0 || n >= ASSET_PATH_LENGTH) continue;
+        path_list[count] = paths[count];
+        count++;
+    }
+    closedir(directory);
+    uint32_t loaded = assets.Preload(path_list, count);
+    printf("Preloaded %u/%u shader files\n", loaded, count);
+}
+
+// NOTE: A pre-packed atlas is mapped as is, otherwise the skin is packed at startup.
+// Skin sprites missing from `skin_dir` (<name>.pam or <name>.ppm) use the built-in ones.
+static bool load_atlas(Atlas *atlas, const char *atlas_path, const char *skin_dir, const char *save_path)
+{
+    if (atlas_path) {
+        if (!LoadAtlas(atlas, atlas_path)) return false;
+        printf("Loaded atlas %s\n", atlas_path);
+        return true;
+    }
+
+    AtlasImage images[ATLAS_SKIN_SPRITES] = {};
+    for (uint32_t i = 0; i < ATLAS_SKIN_SPRITES; ++i) {
+        char path[512];
+        bool loaded = false;
+        const char *extensions[2] = {"pam", "ppm"};
+        for (uint32_t e = 0; skin_dir && !loaded && e < 2; ++e) {
+            snprintf(path, sizeof(path), "%s/%s.%s", skin_dir, SkinSpriteNames[i], extensions[e]);
+            loaded = access(path, R_OK) == 0 && LoadImage(path, &images[i]);
+        }
+        if (!loaded) MakeSkinSprite(i, &images[i]);
+    }
+    bool built = BuildAtlas(atlas, images, SkinSpriteNames, ATLAS_SKIN_SPRITES, 4096);
+    for (uint32_t i = 0; i < ATLAS_SKIN_SPRITES; ++i) FreeImage(&images[i]);
+    if (!built) return false;
+    if (save_path && SaveAtlas(atlas, save_path)) printf("Saved atlas %s\n", save_path);
+    return true;
+}
+
+static bool setup_game(Game *game, const char *load_path, const char *level_path, const LevelGenConfig *generator, bool netplay)
+{
+    if (load_path) {
+        if (!LoadSnapshot(game, load_path)) return false;
+        printf("Loaded snapshot %s\n", load_path);
+        game->stats();
+    } else {
+        game->AddBall(0.0f, 0.0f, RADIUS, 1.0f, 1.0f);
+        game->AddPaddle(0.0f, -0.9f, 0.4f, 0.05f, 2.0f);
+    }
+    if (level_path) {
+        LevelInfo info = {};
+        if (!LoadLevel(game, level_path, &info)) return false;
+        printf("Loaded level %s: %ux%u, %u bricks\n", level_path, info.cols, info.rows, info.brick_count);
+    }
+    if (generator && !load_path) {
+        LevelInfo info = {};
+        if (!GenerateLevel(game, generator, 0, &info)) return false;
+        printf("Generated level %lu: %ux%u, %u bricks\n", (unsigned long)generator->seed, info.cols, info.rows, info.brick_count);
+    }
+    // NOTE: Player 1 defends the top edge, both peers must start from the same state
+    if (netplay && game->paddle_count < 2) game->AddPaddle(0.0f, 0.9f, 0.4f, 0.05f, 2.0f);
+    if (game->balls.count == 0 || game->paddle_count == 0) {
+        fprintf(stderr, "Game state needs at least one ball and one paddle.\n");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *load_path = nullptr;
+    const char *save_path = nullptr;
+    const char *level_path = nullptr;
+    bool event_mode = false;
+    int net_player = -1;
+    long net_port = 0;
+    const char *net_peer = nullptr;
+    uint32_t input_delay = 2;
+    bool autoplay = false;
+    bool headless = false;
+    bool seed_given = false;
+    SoakConfig soak = {0.0, 0, 1, 10.0, nullptr, nullptr};
+    bool generate = false;
+    uint64_t generate_seed = 0;
+    uint32_t generate_cols = 14, generate_rows = 8;
+    uint32_t gpu_ball_count = 0;
+    BallMode ball_mode = BALL_SDF;
+    const char *atlas_path = nullptr;
+    const char *skin_dir = nullptr;
+    const char *save_atlas_path = nullptr;
+    const char *shader_cache_dir = SHADER_CACHE_DIR;
+    bool watch_shaders = false;
+    bool loose_assets = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            load_path = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            level_path = argv[++i];
+        } else if (strcmp(argv[i], "--events") == 0) {
+            event_mode = true;
+        } else if (strcmp(argv[i], "--player") == 0 && i + 1 < argc) {
+            net_player = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            net_port = strtol(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--peer") == 0 && i + 1 < argc) {
+            net_peer = argv[++i];
+        } else if (strcmp(argv[i], "--input-delay") == 0 && i + 1 < argc) {
+            input_delay = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--autoplay") == 0) {
+            autoplay = true;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+            autoplay = true;
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            soak.duration = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--clears") == 0 && i + 1 < argc) {
+            soak.clears = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            soak.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+            seed_given = true;
+        } else if (strcmp(argv[i], "--stats-interval") == 0 && i + 1 < argc) {
+            soak.stats_interval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            generate_seed = strtoull(argv[++i], nullptr, 10);
+            generate = true;
+        } else if (strcmp(argv[i], "--generate-size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%ux%u", &generate_cols, &generate_rows) != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--gpu-balls") == 0 && i + 1 < argc) {
+            gpu_ball_count = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--mesh-balls") == 0) {
+            ball_mode = BALL_MESH;
+        } else if (strcmp(argv[i], "--atlas") == 0 && i + 1 < argc) {
+            atlas_path = argv[++i];
+        } else if (strcmp(argv[i], "--skin") == 0 && i + 1 < argc) {
+            skin_dir = argv[++i];
+        } else if (strcmp(argv[i], "--save-atlas") == 0 && i + 1 < argc) {
+            save_atlas_path = argv[++i];
+        } else if (strcmp(argv[i], "--shader-cache") == 0 && i + 1 < argc) {
+            shader_cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--no-shader-cache") == 0) {
+            shader_cache_dir = nullptr;
+        } else if (strcmp(argv[i], "--watch-shaders") == 0) {
+            watch_shaders = true;
+        } else if (strcmp(argv[i], "--loose-assets") == 0) {
+            loose_assets = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    bool netplay = net_player >= 0 || net_peer != nullptr || net_port != 0;
+    char net_host[64];
+    uint16_t net_peer_port = 0;
+    if (netplay && ((net_player != 0 && net_player != 1) || net_port <= 0 || net_port > 65535 || net_peer == nullptr ||
+                    !parse_address(net_peer, net_host, sizeof(net_host), &net_peer_port))) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (netplay && event_mode) {
+        fprintf(stderr, "--events can not be combined with netplay.\n");
+        return 1;
+    }
+
+    if (atlas_path && (skin_dir || save_atlas_path)) {
+        fprintf(stderr, "--atlas can not be combined with --skin or --save-atlas.\n");
+        return 1;
+    }
+
+    if (generate && level_path) {
+        fprintf(stderr, "--generate can not be combined with --level.\n");
+        return 1;
+    }
+
+    // NOTE: Shaders and built levels come from the pack linked into the binary; loose files on disk
+    // win with --loose-assets, and always while watching shaders so edits are seen
+    AssetPack pack;
+    if (pack.Open(asset_pack_data, (size_t)(asset_pack_data_end - asset_pack_data), "embedded asset pack")) {
+        assets.Mount(&pack);
+    }
+    assets.loose_first = loose_assets || watch_shaders;
 
-Indices TileIndices = {nullptr, 0, 0};
-Vertices TileVertices = {nullptr, 0, 0};
+    // NOTE: Endless mode, every cleared level is followed by the next seed
+    LevelGenConfig generator = DefaultLevelGen(generate_seed, generate_cols, generate_rows);
+    soak.level_path = level_path;
+    soak.generator = generate ? &generator : nullptr;
+    if (headless) {
+        if (netplay) {
+            fprintf(stderr, "--headless can not be combined with netplay.\n");
+            return 1;
+        }
+        // NOTE: Headless soaks run as fast as possible, --duration is simulated time
+        Game game;
+        if (!setup_game(&game, load_path, level_path, soak.generator, false)) return 1;
+        if (seed_given && !load_path) SoakSeedGame(&game, soak.seed);
+        int clears = RunHeadlessSoak(&game, &soak, stdout);
+        if (clears < 0) return 1;
+        game.stats();
+        if (save_path && SaveSnapshot(&game, save_path)) printf("Saved snapshot %s\n", save_path);
+        return 0;
+    }
 
-int main(void) {
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         SDL_Log("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
@@ -79,99 +330,247 @@ int main(void) {
     if (getSwapInterVal == 0) printf("Vsync Disabled\n");
     else printf("Vsync Enabled\n");
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gl_state.Enable(GL_BLEND, true);
+    gl_state.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     double last_time = (double) SDL_GetTicks() * 0.001f;
     double frame_count = 0.0;
 
-    GLuint ProgramId = LoadShader("shader/vertex_shader.vert", "shader/fragment_shader.frag");
+    AssetView packed_shader;
+    if (!assets.FindPacked(BATCH_VERTEX_SHADER, &packed_shader)) preload_shaders(SHADER_DIR);
+    SetShaderCacheDir(shader_cache_dir);
+    GLuint ProgramId = LoadShader(BATCH_VERTEX_SHADER, BATCH_FRAGMENT_SHADER);
     if (ProgramId == 0) return 1;
     printf("ProgramId: %u\n", ProgramId);
 
-    Vector3 BallPos(0.0f, 0.0f, 0.0f);
-    Vector3 BallVel(1.0f, 1.0f, 0.0f);
-    Ball ball = Ball(BallPos, RADIUS, WHITE, BallVel, 12*10, BallIndices, BallVertices);
+    Game game;
+    if (!setup_game(&game, load_path, level_path, soak.generator, netplay)) return 1;
+    if (autoplay && seed_given && !load_path) SoakSeedGame(&game, soak.seed);
+    if (autoplay && !netplay && game.bricks.count == 0 && !SoakRefill(&game, &soak)) return 1;
 
-    ball.GenerateBall();
-    ball.RenderBall();
+    const Paddle *paddle = &game.paddles[0];
+    const Paddle *remote_paddle = &game.paddles[game.paddle_count > 1 ? 1 : 0];
 
-    Vector3 TilePos = Vector3(0.0f, -0.9f, 0.0f);
-    Vector3 TileSize = Vector3(0.4f, 0.05, 0.0f);
-    Vector3 TileVel = Vector3(1.0f, 0.00f, 0.0f);
-    Tile tile = Tile(TilePos, TileSize, TileVel, GREEN, TileIndices, TileVertices);
-    tile.GenerateTile();
-    tile.RenderTile();
+    SceneGraph scene;
+    uint32_t playfield_node = scene.AddNode(SCENE_NO_PARENT, 0.0f, 0.0f);
+    uint32_t ball_node = scene.AddNode(playfield_node, game.balls.x[0], game.balls.y[0]);
+    uint32_t tile_node = scene.AddNode(playfield_node, paddle->x, paddle->y);
+    uint32_t remote_tile_node = scene.AddNode(playfield_node, remote_paddle->x, remote_paddle->y);
 
-    glUseProgram(ProgramId);
-    GLint aspectRatioLoc = glGetUniformLocation(ProgramId, "aspectRatio");
-    if (aspectRatioLoc == -1) {
-        printf("ERROR: Could not find aspectRatio uniform location\n");
+    UdpTransport transport;
+    RollbackSession session(netplay ? (uint32_t)net_player : 0, input_delay);
+    if (netplay) {
+        if (!transport.Open((uint16_t)net_port) || !transport.SetPeer(net_host, net_peer_port)) return 1;
+        printf("Netplay: player %d on port %ld, peer %s\n", net_player, net_port, net_peer);
+    }
+
+    ParticlePool particles(PARTICLE_CAPACITY);
+    ParticleRenderer particle_renderer;
+    if (!particle_renderer.Init(PARTICLE_CAPACITY)) return 1;
+
+    // NOTE: Cosmetic swarm simulated on the GPU, it breaks its own copy of the bricks
+    GpuBalls gpu_balls;
+    if (gpu_ball_count > 0) {
+        if (!gpu_balls.Init(gpu_ball_count, RADIUS * 0.25f)) return 1;
+        Rng gpu_rng(soak.seed);
+        gpu_balls.Spawn(gpu_ball_count, &gpu_rng);
+        gpu_balls.UploadBricks(&game.bricks);
+    }
+
+    BatchRenderer batch;
+    if (!batch.Init(ProgramId)) return 1;
+    Atlas atlas;
+    if (!load_atlas(&atlas, atlas_path, skin_dir, save_atlas_path) || !batch.SetAtlas(&atlas)) return 1;
+    atlas.stats();
+    // NOTE: Sprites are looked up once, a pre-packed atlas may lack some and falls back to plain quads
+    int32_t brick_sprites[LEVEL_MAX_TYPES];
+    for (uint32_t i = 0; i < LEVEL_MAX_TYPES; ++i) brick_sprites[i] = atlas.Find(SkinSpriteNames[i]);
+    int32_t paddle_sprite = atlas.Find("paddle");
+    BallRenderer ball_renderer;
+    if (!ball_renderer.Init(ball_mode, 2.0f / SCREEN_HEIGHT)) return 1;
+    const uint32_t ball_color = pack_color(1.0f, 1.0f, 1.0f, 1.0f);
+    const AtlasSprite *paddle_quad = paddle_sprite < 0 ? nullptr : &atlas.sprites[paddle_sprite];
+    bool bricks_changed = true; // NOTE: Bricks are only walked on frames that broke or replaced some
+    // NOTE: Every program is built, later loads (shader reloads) map the files afresh
+    assets.Unpin();
+
+    ShaderReloader reloader;
+    if (watch_shaders && reloader.Start(SHADER_DIR)) {
+        batch.WatchShaders(&reloader, BATCH_VERTEX_SHADER, BATCH_FRAGMENT_SHADER);
+        ball_renderer.WatchShaders(&reloader);
+        particle_renderer.WatchShaders(&reloader);
+        if (gpu_ball_count > 0) gpu_balls.WatchShaders(&reloader);
     }
-    glUniform1f(aspectRatioLoc, ASPECT_RATIO);
 
     bool quit = false;  // Main loop flag
     SDL_Event e; // Event handler
-    auto previous_time = SDL_GetTicks();
-    auto accumulated = 0.0f;
+    const double frequency = (double) SDL_GetPerformanceFrequency();
+    Uint64 previous_counter = SDL_GetPerformanceCounter();
+    double accumulated = 0.0;
+
+    // NOTE: previous/current tick are blended by the accumulator remainder so the
+    // simulation rate does not have to match the display rate
+    EventSim event_sim;
+    FrameState previous;
+    FrameState rendered;
+    previous.Capture(&game);
+
+    Autoplayer autoplayer(soak.seed);
+    SoakMonitor monitor(soak.stats_interval, stdout);
+    const Uint64 start_counter = previous_counter;
 
     // Game loop
     while (!quit) {
-        auto current_time = SDL_GetTicks();
-        auto frame_time = current_time - previous_time;
-        previous_time = current_time;
-        accumulated += frame_time / 1000.0f;
-
-        bool leftPressed = false;
-        bool rightPressed = false;
+        Uint64 current_counter = SDL_GetPerformanceCounter();
+        double frame_time = (double)(current_counter - previous_counter) / frequency;
+        previous_counter = current_counter;
+        if (frame_time > MAX_FRAME_TIME) frame_time = MAX_FRAME_TIME;
+        accumulated += frame_time;
 
         // Handle events on queue
         while (SDL_PollEvent(&e)) {
             // User requests quit
             if (e.type == SDL_QUIT) {
                 quit = true;
-            } else if (e.type == SDL_KEYDOWN) {
-                switch (e.key.keysym.sym) {
-                case SDLK_LEFT: leftPressed = true; break;
-                case SDLK_RIGHT: rightPressed = true; break;
-                }
-            } else if (e.type == SDL_KEYUP) {
-                switch (e.key.keysym.sym) {
-                case SDLK_LEFT: leftPressed = false; break;
-                case SDLK_RIGHT: rightPressed = false; break;
-                }
             }
         }
 
+        const Uint8 *keys = SDL_GetKeyboardState(nullptr);
+        uint8_t inputs[MAX_PADDLES] = {};
+        if (keys[SDL_SCANCODE_LEFT])  inputs[0] |= INPUT_LEFT;
+        if (keys[SDL_SCANCODE_RIGHT]) inputs[0] |= INPUT_RIGHT;
+        // NOTE: The local input always goes in slot 0, rollback places it on the right paddle
+        if (autoplay) inputs[0] = autoplayer.Input(&game, netplay ? (uint32_t)net_player : 0);
+
+        uint64_t now_us = (uint64_t)((double)current_counter / frequency * 1e6);
+        if (netplay) {
+            uint8_t packet[NET_MAX_PACKET];
+            int size;
+            while ((size = transport.Receive(packet, sizeof(packet), now_us)) > 0) session.ReadPacket(packet, (size_t)size);
+        }
+
         int updates = 0;
         // Fixed timestep update
         while (accumulated >= DELTA_TIME && updates < MAX_UPDATES) {
-            if (leftPressed)  tile.Position.x -= tile.Velocity.x * DELTA_TIME * 2;
-            if (rightPressed) tile.Position.x += tile.Velocity.x * DELTA_TIME * 2;
-            // Update ball position
-            ball.Position.x += ball.Velocity.x * DELTA_TIME;
-            ball.Position.y += ball.Velocity.y * DELTA_TIME;
-            // Ball Tile Collission
-            BallBounds(&ball);
-            TileBounds(&tile);
+            previous.Capture(&game);
+            if (netplay) {
+                session.AddLocalInput(inputs[0]);
+                // NOTE: Stalled on the peer, keep the time and try again next frame
+                if (!session.AdvanceFrame(&game)) break;
+            } else if (event_mode) {
+                event_sim.Update(&game, inputs);
+            } else {
+                game.GameUpdate(inputs);
+            }
+            if (game.broken.count > 0) bricks_changed = true;
+            for (uint32_t i = 0; i < game.broken.count; ++i) {
+                uint32_t brick = game.broken.items[i];
+                const Color color = BrickPalette[game.bricks.color[brick]];
+                particles.SpawnBurst(game.bricks.x[brick], game.bricks.y[brick], 64, 1.5f, 0.6f,
+                                     pack_color(color.r, color.g, color.b, color.a));
+            }
+            if (autoplay) monitor.misses += SoakCountMisses(&game);
+            // NOTE: Refilling outside the simulation would desync a rollback session
+            if (!netplay && (autoplay || soak.generator) && SoakLevelCleared(&game)) {
+                monitor.clears++;
+                if (!SoakRefill(&game, &soak)) quit = true;
+                bricks_changed = true;
+                event_sim.Invalidate();
+                if (gpu_ball_count > 0) gpu_balls.UploadBricks(&game.bricks);
+            }
             accumulated -= DELTA_TIME;
+            updates++;
+        }
+        // NOTE: A rollback re-simulates ticks whose broken bricks are never reported here
+        if (netplay && updates > 0) bricks_changed = true;
+        if (netplay) {
+            RollbackPacket packet;
+            size_t size = session.BuildPacket(&packet);
+            transport.Send(&packet, size, now_us);
+        }
+        if (accumulated >= DELTA_TIME && updates >= MAX_UPDATES) {
+            // NOTE: Can't keep up, drop the backlog instead of spiralling
+            int dropped = (int)(accumulated / DELTA_TIME);
+            fprintf(stderr, "WARNING: Simulation fell behind, dropping %d ticks\n", dropped);
+            accumulated -= dropped * DELTA_TIME;
         }
+
+        if (gpu_ball_count > 0) gpu_balls.Step(&game, (uint32_t)updates);
+
+        // NOTE: Particles are cosmetic and advance with the frame, not the simulation tick
+        particles.Update((float)frame_time);
+
+        float alpha = (float)(accumulated / DELTA_TIME);
+        rendered.Blend(&previous, &game, alpha);
+        scene.SetPosition(ball_node, rendered.ball_x[0], rendered.ball_y[0]);
+        scene.SetPosition(tile_node, rendered.paddle_x[0], rendered.paddle_y[0]);
+        if (rendered.paddle_count > 1) {
+            scene.SetPosition(remote_tile_node, rendered.paddle_x[1], rendered.paddle_y[1]);
+        }
+        scene.Update();
+        // NOTE: Between frames, so a swapped program never sees half a frame
+        reloader.Poll();
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // Regenerate ball vertices with new position
-        ball.UpdateBall();
-        // Regenerate Tile vertices with new position
-        tile.UpdateTile();
-
-        // Update GPU buffer
-        glBindVertexArray(ball.VAO);
-        glDrawElements(GL_TRIANGLES, ball.indices.count, GL_UNSIGNED_INT, (void*) 0);
-        glBindVertexArray(tile.VAO);
-        glDrawElements(GL_TRIANGLES, tile.indices.count, GL_UNSIGNED_INT, (void*) 0);
+        // NOTE: Bricks and paddles are retained quads in one batch and one draw call, only the
+        // slots that changed are uploaded. The batch is in playfield space, so moving the
+        // playfield node only changes the model matrix. Balls are instanced
+        const Matrix4 *playfield = scene.World(playfield_node);
+        batch.Begin();
+        if (bricks_changed) {
+            sync_bricks(&batch, &game.bricks, &atlas, brick_sprites);
+            bricks_changed = false;
+        }
+        for (uint32_t i = 0; i < rendered.ball_count; ++i) {
+            Vector4 p = i == 0 ? scene.World(ball_node)->transform(Vector4(0.0f, 0.0f, 0.0f, Vector4Type::Point))
+                               : playfield->transform(Vector4(rendered.ball_x[i], rendered.ball_y[i], 0.0f, Vector4Type::Point));
+            ball_renderer.Push(p.getX(), p.getY(), game.balls.radius[i], ball_color);
+        }
+        // NOTE: The paddle nodes are direct children of the playfield, their local position is playfield space
+        const SceneNode *tile = &scene.nodes.items[tile_node];
+        batch.SetRetainedQuad(SLOT_PADDLE, tile->x, tile->y, paddle->w, paddle->h, paddle_quad, GREEN);
+        if (game.paddle_count > 1) {
+            const SceneNode *remote_tile = &scene.nodes.items[remote_tile_node];
+            batch.SetRetainedQuad(SLOT_REMOTE_PADDLE, remote_tile->x, remote_tile->y,
+                                  remote_paddle->w, remote_paddle->h, paddle_quad, BLUE);
+        } else {
+            batch.HideRetained(SLOT_REMOTE_PADDLE);
+        }
+        batch.Flush(ASPECT_RATIO, playfield);
+        ball_renderer.Draw(ASPECT_RATIO);
+        particle_renderer.Draw(&particles, ASPECT_RATIO);
+        if (gpu_ball_count > 0) gpu_balls.Draw(ASPECT_RATIO, RADIUS * 0.25f * SCREEN_HEIGHT);
 
         calculate_fps(&last_time, &frame_count);
         SDL_GL_SwapWindow(window);
+        gl_state.EndFrame();
+
+        if (autoplay) {
+            monitor.Frame(frame_time);
+            double elapsed = (double)(current_counter - start_counter) / frequency;
+            if (monitor.Due(elapsed)) monitor.Report(&game, elapsed);
+            if (SoakDone(&soak, &monitor, elapsed)) {
+                monitor.Report(&game, elapsed);
+                quit = true;
+            }
+        }
+    }
+
+    gl_state.stats();
+    ShaderCacheStats();
+    batch.stats();
+    ball_renderer.stats();
+    reloader.stats();
+    assets.stats();
+    if (event_mode) event_sim.stats();
+    if (gpu_ball_count > 0) gpu_balls.stats();
+    if (netplay) {
+        session.stats();
+        transport.stats();
+    }
+    if (save_path) {
+        if (SaveSnapshot(&game, save_path)) printf("Saved snapshot %s\n", save_path);
     }
 
     // Destroy window
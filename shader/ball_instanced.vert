@@ -0,0 +1,22 @@
+#version 330 core
+
+// Shared unit circle or unit quad, placed and tinted per instance
+layout(location = 0) in vec2 aUnit;
+layout(location = 1) in vec3 aInstance; // center xy, radius z
+layout(location = 2) in vec4 aColor;
+
+out vec4 vertex_color;
+out vec2 circle_uv;
+
+uniform float aspectRatio;
+uniform float aaMargin; // quads grow by this much so the anti-aliased edge isn't clipped
+void main()
+{
+    float extent = aInstance.z + aaMargin;
+    vec2 pos = aInstance.xy + aUnit * extent;
+    pos.x /= aspectRatio;
+
+    gl_Position = vec4(pos, 0.0, 1.0);
+    vertex_color = aColor;
+    circle_uv = aUnit * (extent / aInstance.z);
+}
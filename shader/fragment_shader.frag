@@ -1,9 +1,19 @@
 #version 330 core
 
 in vec4 vertex_color;
+in vec2 circle_uv; // NOTE: 1.0 at the circle's edge, only used in circle mode
 out vec4 fragColor;
 
+uniform bool circleMode;
+
 void main() {
+    if (circleMode) {
+        // Signed distance to the edge in radii, blended over one pixel
+        float d = length(circle_uv) - 1.0;
+        float alpha = clamp(0.5 - d / max(fwidth(d), 1e-5), 0.0, 1.0);
+        if (alpha <= 0.0) discard;
+        fragColor = vec4(vertex_color.rgb, vertex_color.a * alpha);
+        return;
+    }
     fragColor = vertex_color;
 }
-
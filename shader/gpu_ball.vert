@@ -0,0 +1,26 @@
+#version 430 core
+
+struct GpuBall {
+    vec2 position;
+    vec2 velocity;
+};
+
+// Same buffer the compute pass writes, nothing goes through the CPU
+layout(std430, binding = 0) readonly buffer BallBuffer { GpuBall balls[]; };
+
+out vec4 vertex_color;
+
+uniform float aspectRatio;
+uniform float pointSize;
+void main()
+{
+    GpuBall ball = balls[gl_VertexID];
+    vec2 pos = ball.position;
+    pos.x /= aspectRatio;
+
+    gl_Position = vec4(pos, 0.0, 1.0);
+    gl_PointSize = pointSize;
+    // Faster balls are drawn warmer
+    float heat = clamp(length(ball.velocity) * 0.5, 0.0, 1.0);
+    vertex_color = vec4(mix(vec3(0.4, 0.7, 1.0), vec3(1.0, 0.6, 0.2), heat), 1.0);
+}
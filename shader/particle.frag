@@ -0,0 +1,11 @@
+#version 330 core
+
+in vec4 vertex_color;
+out vec4 fragColor;
+
+void main() {
+    // Round point sprites
+    vec2 d = gl_PointCoord - vec2(0.5);
+    if (dot(d, d) > 0.25) discard;
+    fragColor = vertex_color;
+}
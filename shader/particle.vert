@@ -0,0 +1,18 @@
+#version 330 core
+
+layout(location = 0) in vec2 aPosition;
+layout(location = 1) in vec4 aColor;
+layout(location = 2) in float aSize;
+
+out vec4 vertex_color;
+
+uniform float aspectRatio;
+void main()
+{
+    vec2 pos = aPosition;
+    pos.x /= aspectRatio;
+
+    gl_Position = vec4(pos, 0.0, 1.0);
+    gl_PointSize = aSize;
+    vertex_color = aColor;
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+in vec4 vertex_color;
+in vec2 uv;
+out vec4 fragColor;
+
+uniform sampler2D atlas;
+
+void main() {
+    fragColor = texture(atlas, uv) * vertex_color;
+}
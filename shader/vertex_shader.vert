@@ -2,15 +2,19 @@
 
 layout(location = 0) in vec3 vertexPosition_pixels;
 layout(location = 1) in vec4 aColor;
+layout(location = 2) in vec2 aUV;
 
 out vec4 vertex_color;
+out vec2 uv;
 
 uniform float aspectRatio;
+uniform mat4 model;
 void main()
 {
-    vec3 pos = vertexPosition_pixels;
+    vec3 pos = (model * vec4(vertexPosition_pixels, 1.0)).xyz;
     pos.x/= aspectRatio;
     
     gl_Position = vec4(pos, 1.0);
     vertex_color = aColor;
+    uv = aUV;
 }
@@ -0,0 +1,173 @@
+#include "./asset_pack.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct AssetPackHeader {
+    BlockFileHeader file;
+    uint32_t slot_count;
+    uint32_t asset_count;
+};
+
+#define ASSET_PACK_BLOCKS 3
+
+uint64_t AssetPackHash(const char *name, size_t length)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// NOTE: "./shader/x" and "shader/x" are the same asset
+static const char *pack_name(const char *name)
+{
+    while (name[0] == '.' && name[1] == '/') name += 2;
+    return name;
+}
+
+static inline uint64_t align_up(uint64_t size, uint64_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static void pack_columns(SoAColumn *columns, void **data)
+{
+    columns[0] = {&data[0], sizeof(AssetPackEntry)};
+    columns[1] = {&data[1], 1};
+    columns[2] = {&data[2], 1};
+}
+
+bool WriteAssetPack(const char *file_path, const char *const *names, const AssetView *contents, uint32_t count)
+{
+    // NOTE: At most half full, so probes stay short and always reach an empty slot
+    uint32_t slot_count = 1;
+    while (slot_count < count * 2 + 1) slot_count *= 2;
+
+    uint64_t names_size = 0, data_size = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        size_t length = strlen(pack_name(names[i]));
+        if (length == 0 || length >= ASSET_PATH_LENGTH) {
+            fprintf(stderr, "%s: asset name \"%s\" is empty or too long.\n", file_path, names[i]);
+            return false;
+        }
+        names_size += length + 1;
+        data_size = align_up(data_size, SOA_ALIGNMENT) + contents[i].size + 1;
+    }
+    if (names_size > UINT32_MAX || data_size > UINT32_MAX) {
+        fprintf(stderr, "%s: assets too large for one pack.\n", file_path);
+        return false;
+    }
+
+    AssetPackEntry *slots = (AssetPackEntry*)calloc(slot_count, sizeof(AssetPackEntry));
+    char *name_block = (char*)calloc(names_size + 1, 1);
+    char *data_block = (char*)calloc(data_size + 1, 1);
+    bool written = slots && name_block && data_block;
+    uint32_t name_at = 0;
+    uint64_t data_at = 0;
+    for (uint32_t i = 0; written && i < count; ++i) {
+        const char *name = pack_name(names[i]);
+        uint32_t length = (uint32_t)strlen(name);
+        uint64_t hash = AssetPackHash(name, length);
+        uint32_t slot = (uint32_t)hash & (slot_count - 1);
+        for (; slots[slot].name_length != 0; slot = (slot + 1) & (slot_count - 1)) {
+            if (slots[slot].hash == hash && slots[slot].name_length == length &&
+                memcmp(name_block + slots[slot].name_offset, name, length) == 0) {
+                fprintf(stderr, "%s: asset \"%s\" given twice.\n", file_path, name);
+                written = false;
+                break;
+            }
+        }
+        if (!written) break;
+
+        data_at = align_up(data_at, SOA_ALIGNMENT);
+        slots[slot] = {hash, data_at, contents[i].size, name_at, length};
+        memcpy(name_block + name_at, name, length);
+        name_at += length + 1;
+        if (contents[i].size > 0) memcpy(data_block + data_at, contents[i].data, contents[i].size);
+        data_at += contents[i].size + 1; // NOTE: calloc'd, so the terminator is already there
+    }
+
+    if (written) {
+        AssetPackHeader header = {};
+        header.slot_count = slot_count;
+        header.asset_count = count;
+        void *data[ASSET_PACK_BLOCKS] = {slots, name_block, data_block};
+        SoAColumn columns[ASSET_PACK_BLOCKS];
+        pack_columns(columns, data);
+        const uint32_t counts[ASSET_PACK_BLOCKS] = {slot_count, (uint32_t)names_size, (uint32_t)data_size};
+        written = blockfile_write(file_path, &header, sizeof(header), ASSET_PACK_MAGIC, ASSET_PACK_VERSION,
+                                  columns, counts, ASSET_PACK_BLOCKS);
+    }
+    free(slots);
+    free(name_block);
+    free(data_block);
+    return written;
+}
+
+AssetPack::AssetPack():
+    slots(nullptr), slot_count(0), asset_count(0), names(nullptr), data(nullptr)
+{}
+
+bool AssetPack::Open(const void *pack, size_t size, const char *name)
+{
+    void *data_pointers[ASSET_PACK_BLOCKS] = {};
+    SoAColumn columns[ASSET_PACK_BLOCKS];
+    pack_columns(columns, data_pointers);
+    if (!blockfile_check(pack, size, name, ASSET_PACK_MAGIC, ASSET_PACK_VERSION,
+                         sizeof(AssetPackHeader), columns, ASSET_PACK_BLOCKS)) return false;
+
+    const AssetPackHeader *header = (const AssetPackHeader*)pack;
+    const BlockFileBlock *blocks = blockfile_blocks(pack);
+    const AssetPackEntry *entries = (const AssetPackEntry*)((const char*)pack + blocks[0].offset);
+    const char *name_block = (const char*)pack + blocks[1].offset;
+    const char *data_block = (const char*)pack + blocks[2].offset;
+    uint32_t slots_count = blocks[0].count;
+    bool valid = slots_count == header->slot_count && slots_count > 0 && (slots_count & (slots_count - 1)) == 0 &&
+                 header->asset_count < slots_count;
+
+    uint32_t used = 0;
+    for (uint32_t i = 0; valid && i < slots_count; ++i) {
+        const AssetPackEntry *entry = &entries[i];
+        if (entry->name_length == 0) continue;
+        used++;
+        valid = (uint64_t)entry->name_offset + entry->name_length <= blocks[1].count &&
+                entry->name_length < ASSET_PATH_LENGTH &&
+                entry->hash == AssetPackHash(name_block + entry->name_offset, entry->name_length) &&
+                entry->offset % SOA_ALIGNMENT == 0 && entry->offset <= blocks[2].count &&
+                entry->size < blocks[2].count - entry->offset &&
+                data_block[entry->offset + entry->size] == '\0';
+    }
+    if (!valid || used != header->asset_count) {
+        fprintf(stderr, "%s: corrupt asset pack index.\n", name);
+        return false;
+    }
+
+    slots = entries;
+    slot_count = slots_count;
+    asset_count = header->asset_count;
+    names = name_block;
+    data = data_block;
+    return true;
+}
+
+bool AssetPack::Find(const char *name, AssetView *view) const
+{
+    if (slot_count == 0) return false;
+    name = pack_name(name);
+    size_t length = strlen(name);
+    uint64_t hash = AssetPackHash(name, length);
+    for (uint32_t slot = (uint32_t)hash & (slot_count - 1); slots[slot].name_length != 0;
+         slot = (slot + 1) & (slot_count - 1)) {
+        const AssetPackEntry *entry = &slots[slot];
+        if (entry->hash != hash || entry->name_length != length ||
+            memcmp(names + entry->name_offset, name, length) != 0) continue;
+        view->data = data + entry->offset;
+        view->size = entry->size;
+        return true;
+    }
+    return false;
+}
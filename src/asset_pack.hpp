@@ -0,0 +1,47 @@
+#ifndef ASSET_PACK_H_
+#define ASSET_PACK_H_
+
+#include "./assets.hpp"
+#include "./blockfile.hpp"
+
+// Asset pack: many small files (shaders, compiled levels) stored in one block
+// file, built by tools/assetpack and assembled into the game binary, so a
+// cold start does no opens or reads for them and the game runs from any
+// working directory.
+//
+// Blocks: an open addressed hash table of AssetPackEntry (power of two slots,
+// linear probing on FNV-1a 64 of the name, empty slots have name_length 0),
+// the names, then the data. Every asset starts on SOA_ALIGNMENT within the
+// data block and is followed by a '\0', so views into a pack behave like the
+// ones AssetLoader maps from loose files. Names are the paths the game asks
+// for, e.g. "shader/sprite.frag".
+
+#define ASSET_PACK_MAGIC "BRKPACK"
+#define ASSET_PACK_VERSION 1
+
+struct AssetPackEntry {
+    uint64_t hash;
+    uint64_t offset; // NOTE: into the data block
+    uint64_t size;   // NOTE: without the trailing '\0'
+    uint32_t name_offset;
+    uint32_t name_length;
+};
+
+struct AssetPack {
+    AssetPack();
+
+    // NOTE: Checks the whole index up front so Find can trust it; `data` must stay alive and SOA_ALIGNMENT aligned
+    bool Open(const void *data, size_t size, const char *name);
+    bool Find(const char *name, AssetView *view) const;
+
+    const AssetPackEntry *slots;
+    uint32_t slot_count;
+    uint32_t asset_count;
+    const char *names;
+    const char *data;
+};
+
+uint64_t AssetPackHash(const char *name, size_t length);
+bool WriteAssetPack(const char *file_path, const char *const *names, const AssetView *contents, uint32_t count);
+
+#endif // ASSET_PACK_H_
@@ -0,0 +1,257 @@
+#include "./assets.hpp"
+#include "./asset_pack.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+AssetLoader assets;
+
+AssetLoader::AssetLoader():
+    entries({nullptr, 0, 0}), pinned({nullptr, 0, 0}), pack(nullptr), loose_first(false),
+    maps(0), packed(0), shared(0), bytes_mapped(0)
+{
+    array_new(&entries, Asset*);
+    array_new(&pinned, Asset*);
+}
+
+static void unmap_asset(Asset *asset)
+{
+    if (asset->mapping) munmap(asset->mapping, asset->mapping_size);
+    delete asset;
+}
+
+AssetLoader::~AssetLoader()
+{
+    Unpin();
+    // NOTE: Holders that never released are past caring at exit
+    for (uint32_t i = 0; i < entries.count; ++i) unmap_asset(entries.items[i]);
+    array_delete(&entries);
+    array_delete(&pinned);
+}
+
+static int64_t mtime_ns(const struct stat *st)
+{
+    return (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+}
+
+static bool same_file(const Asset *asset, const char *path, const struct stat *st)
+{
+    return asset->mapping != nullptr && asset->device == (uint64_t)st->st_dev && asset->inode == (uint64_t)st->st_ino &&
+           asset->mtime_ns == mtime_ns(st) && asset->view.size == (size_t)st->st_size &&
+           strcmp(asset->path, path) == 0;
+}
+
+// NOTE: Reserves size + 1 bytes of zero pages and maps the file over the front of them,
+// so the terminator exists even when the file ends exactly on a page boundary
+static Asset *map_asset(const char *path)
+{
+    if (strlen(path) >= ASSET_PATH_LENGTH) {
+        fprintf(stderr, "Asset path too long: %s.\n", path);
+        return nullptr;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open file %s: %s.\n", path, strerror(errno));
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "%s is not a regular file.\n", path);
+        close(fd);
+        return nullptr;
+    }
+
+    size_t size = (size_t)st.st_size;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mapping_size = (size / page + 1) * page;
+    void *mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping != MAP_FAILED && size > 0 &&
+        mmap(mapping, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(mapping, mapping_size);
+        mapping = MAP_FAILED;
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s: %s.\n", path, strerror(errno));
+        return nullptr;
+    }
+
+    Asset *asset = new Asset();
+    strcpy(asset->path, path);
+    asset->view.data = (const char*)mapping;
+    asset->view.size = size;
+    asset->mapping = mapping;
+    asset->mapping_size = mapping_size;
+    asset->device = (uint64_t)st.st_dev;
+    asset->inode = (uint64_t)st.st_ino;
+    asset->mtime_ns = mtime_ns(&st);
+    asset->refs = 1;
+    return asset;
+}
+
+void AssetLoader::Mount(const AssetPack *asset_pack)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    pack = asset_pack;
+}
+
+bool AssetLoader::FindPacked(const char *path, AssetView *view) const
+{
+    if (pack == nullptr || !pack->Find(path, view)) return false;
+    return !loose_first || access(path, R_OK) != 0;
+}
+
+static Asset *packed_asset(const char *path, AssetView view)
+{
+    if (strlen(path) >= ASSET_PATH_LENGTH) {
+        fprintf(stderr, "Asset path too long: %s.\n", path);
+        return nullptr;
+    }
+    Asset *asset = new Asset();
+    strcpy(asset->path, path);
+    asset->view = view;
+    asset->refs = 1;
+    return asset;
+}
+
+const Asset *AssetLoader::Acquire(const char *path)
+{
+    AssetView view;
+    if (FindPacked(path, &view)) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (uint32_t i = 0; i < entries.count; ++i) {
+            if (entries.items[i]->mapping != nullptr || entries.items[i]->view.data != view.data) continue;
+            entries.items[i]->refs++;
+            shared++;
+            return entries.items[i];
+        }
+        Asset *asset = packed_asset(path, view);
+        if (asset == nullptr) return nullptr;
+        array_append(Asset*, &entries, asset);
+        packed++;
+        return asset;
+    }
+
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        fprintf(stderr, "Failed to open file %s: %s.\n", path, strerror(errno));
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (uint32_t i = 0; i < entries.count; ++i) {
+            if (!same_file(entries.items[i], path, &st)) continue;
+            entries.items[i]->refs++;
+            shared++;
+            return entries.items[i];
+        }
+    }
+
+    // NOTE: Mapped outside the lock so preload threads fault files in side by side
+    Asset *asset = map_asset(path);
+    if (asset == nullptr) return nullptr;
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (uint32_t i = 0; i < entries.count; ++i) {
+        Asset *other = entries.items[i];
+        if (other->mapping == nullptr || other->device != asset->device || other->inode != asset->inode ||
+            other->mtime_ns != asset->mtime_ns || strcmp(other->path, path) != 0) continue;
+        // NOTE: Another thread mapped the same file first, share theirs
+        other->refs++;
+        shared++;
+        unmap_asset(asset);
+        return other;
+    }
+    array_append(Asset*, &entries, asset);
+    maps++;
+    bytes_mapped += asset->view.size;
+    return asset;
+}
+
+void AssetLoader::Release(const Asset *asset)
+{
+    if (asset == nullptr) return;
+    std::lock_guard<std::mutex> guard(lock);
+    for (uint32_t i = 0; i < entries.count; ++i) {
+        if (entries.items[i] != asset) continue;
+        if (--entries.items[i]->refs == 0) {
+            unmap_asset(entries.items[i]);
+            entries.items[i] = entries.items[entries.count - 1];
+            entries.count--;
+        }
+        return;
+    }
+    fprintf(stderr, "Released an asset that is not mapped: %s.\n", asset->path);
+}
+
+// NOTE: Touches one byte per page so the reads happen on the preload thread, not at first use
+static void fault_in(const Asset *asset)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    volatile char sink = 0;
+    for (size_t offset = 0; offset < asset->view.size; offset += page) sink += asset->view.data[offset];
+    (void)sink;
+}
+
+static void preload_worker(AssetLoader *loader, const char *const *paths, const Asset **loaded,
+                           uint32_t count, std::atomic<uint32_t> *next)
+{
+    for (uint32_t i = next->fetch_add(1); i < count; i = next->fetch_add(1)) {
+        loaded[i] = loader->Acquire(paths[i]);
+        if (loaded[i]) fault_in(loaded[i]);
+    }
+}
+
+uint32_t AssetLoader::Preload(const char *const *paths, uint32_t count)
+{
+    if (count == 0) return 0;
+    const Asset **loaded = (const Asset**)calloc(count, sizeof(const Asset*));
+    if (loaded == nullptr) return 0;
+
+    std::atomic<uint32_t> next(0);
+    uint32_t thread_count = count < ASSET_PRELOAD_THREADS ? count : ASSET_PRELOAD_THREADS;
+    std::thread workers[ASSET_PRELOAD_THREADS];
+    for (uint32_t t = 1; t < thread_count; ++t) {
+        workers[t] = std::thread(preload_worker, this, paths, loaded, count, &next);
+    }
+    preload_worker(this, paths, loaded, count, &next);
+    for (uint32_t t = 1; t < thread_count; ++t) workers[t].join();
+
+    uint32_t pinned_count = 0;
+    std::lock_guard<std::mutex> guard(lock);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (loaded[i] == nullptr) continue;
+        array_append(Asset*, &pinned, (Asset*)loaded[i]);
+        pinned_count++;
+    }
+    free(loaded);
+    return pinned_count;
+}
+
+void AssetLoader::Unpin()
+{
+    ARRAY(Asset*) released = {nullptr, 0, 0};
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        released.items = pinned.items;
+        released.count = pinned.count;
+        released.capacity = pinned.capacity;
+        array_new(&pinned, Asset*);
+    }
+    for (uint32_t i = 0; i < released.count; ++i) Release(released.items[i]);
+    array_delete(&released);
+}
+
+void AssetLoader::stats() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    printf("Asset Info: \n");
+    printf("    Live: %u, Pinned: %u, Maps: %lu, Packed: %lu, Shared: %lu, Bytes Mapped: %lu\n",
+           entries.count, pinned.count, (unsigned long)maps, (unsigned long)packed, (unsigned long)shared,
+           (unsigned long)bytes_mapped);
+}
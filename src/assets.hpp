@@ -0,0 +1,78 @@
+#ifndef ASSETS_H_
+#define ASSETS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "../util/array.h"
+
+// Read-only file assets (shaders, images) mapped with mmap instead of read
+// into heap buffers.
+//
+// Acquire hands out a shared, reference counted mapping of a file; callers
+// read it through a zero-copy view and Release it when done. The byte past
+// the end of every view is a guaranteed '\0' (the mapping reserves one extra
+// zero page when the file fills its last page exactly), so text assets can go
+// straight to APIs that want C strings. A path that is acquired again while
+// mapped shares the mapping unless the file was replaced on disk since, in
+// which case a fresh mapping is made and the old one lives on until its last
+// holder releases it. Preload maps a list of files on several threads and
+// pins them until Unpin, so a cold start pays the page faults in parallel.
+// With an asset pack mounted, names the pack holds are served from it (no
+// syscalls at all) unless loose_first is set and the file exists on disk,
+// which is how a development build picks up edited files.
+
+#define ASSET_PATH_LENGTH 256
+#define ASSET_PRELOAD_THREADS 4
+
+struct AssetPack;
+
+struct AssetView {
+    const char *data; // NOTE: data[size] is always '\0'
+    size_t size;
+};
+
+struct Asset {
+    char path[ASSET_PATH_LENGTH];
+    AssetView view;
+    void *mapping; // NOTE: nullptr for assets served from a pack
+    size_t mapping_size;
+    uint64_t device;
+    uint64_t inode;
+    int64_t mtime_ns;
+    uint32_t refs; // NOTE: guarded by the loader lock
+};
+
+struct AssetLoader {
+    AssetLoader();
+    ~AssetLoader();
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // NOTE: nullptr with a message on stderr when the file can't be opened or mapped
+    const Asset *Acquire(const char *path);
+    void Release(const Asset *asset);
+    // NOTE: Returns how many of `paths` are now mapped and pinned
+    uint32_t Preload(const char *const *paths, uint32_t count);
+    void Unpin();
+    void Mount(const AssetPack *pack);
+    // NOTE: True when `path` would be served from the mounted pack
+    bool FindPacked(const char *path, AssetView *view) const;
+    void stats() const;
+
+    ARRAY(Asset*) entries; // NOTE: guarded by lock
+    ARRAY(Asset*) pinned;  // NOTE: guarded by lock
+    mutable std::mutex lock;
+    const AssetPack *pack;
+    bool loose_first;
+    uint64_t maps;
+    uint64_t packed;
+    uint64_t shared;
+    uint64_t bytes_mapped;
+};
+
+// NOTE: Shared by the shader and image loaders
+extern AssetLoader assets;
+
+#endif // ASSETS_H_
@@ -0,0 +1,335 @@
+#include "./atlas.hpp"
+#include "./blockfile.hpp"
+#include "./assets.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <sys/mman.h>
+
+struct AtlasHeader {
+    BlockFileHeader file;
+    uint32_t width;
+    uint32_t height;
+    uint32_t sprite_count;
+    uint32_t reserved;
+};
+
+Atlas::Atlas():
+    width(0), height(0), pixels(nullptr), sprites(nullptr), sprite_count(0),
+    mapping(nullptr), mapping_size(0)
+{}
+
+Atlas::~Atlas()
+{
+    Reset();
+}
+
+void Atlas::Reset()
+{
+    if (mapping) {
+        munmap(mapping, mapping_size);
+    } else {
+        free(pixels);
+        free(sprites);
+    }
+    mapping = nullptr;
+    mapping_size = 0;
+    pixels = nullptr;
+    sprites = nullptr;
+    width = height = sprite_count = 0;
+}
+
+int32_t Atlas::Find(const char *name) const
+{
+    for (uint32_t i = 0; i < sprite_count; ++i) {
+        if (strncmp(sprites[i].name, name, ATLAS_NAME_LENGTH) == 0) return (int32_t)i;
+    }
+    return -1;
+}
+
+void Atlas::stats() const
+{
+    printf("Atlas Info: \n");
+    printf("    Size: %ux%u, %u sprites, %s\n", width, height, sprite_count, mapping ? "mapped" : "packed");
+}
+
+static inline uint32_t gray_pixel(float value, float alpha)
+{
+    uint32_t v = (uint32_t)(fminf(fmaxf(value, 0.0f), 1.0f) * 255.0f);
+    uint32_t a = (uint32_t)(fminf(fmaxf(alpha, 0.0f), 1.0f) * 255.0f);
+    return v | (v << 8) | (v << 16) | (a << 24);
+}
+
+// NOTE: Skips whitespace and # comments, reads one header token
+static bool next_token(const uint8_t *data, size_t size, size_t *at, char *out, size_t out_size)
+{
+    while (*at < size) {
+        if (data[*at] == '#') {
+            while (*at < size && data[*at] != '\n') (*at)++;
+        } else if (data[*at] == ' ' || data[*at] == '\t' || data[*at] == '\n' || data[*at] == '\r') {
+            (*at)++;
+        } else {
+            break;
+        }
+    }
+    size_t length = 0;
+    while (*at < size && data[*at] > ' ' && length + 1 < out_size) out[length++] = (char)data[(*at)++];
+    out[length] = '\0';
+    return length > 0;
+}
+
+bool LoadImage(const char *file_path, AtlasImage *image)
+{
+    // NOTE: The raster is converted straight out of the mapped file
+    const Asset *asset = assets.Acquire(file_path);
+    if (asset == nullptr) return false;
+    const uint8_t *data = (const uint8_t*)asset->view.data;
+
+    size_t size = asset->view.size, at = 0;
+    char token[32];
+    uint32_t width = 0, height = 0, depth = 0, maxval = 0;
+    bool valid = next_token(data, size, &at, token, sizeof(token));
+    if (valid && strcmp(token, "P6") == 0) {
+        valid = next_token(data, size, &at, token, sizeof(token)) && sscanf(token, "%u", &width) == 1 &&
+                next_token(data, size, &at, token, sizeof(token)) && sscanf(token, "%u", &height) == 1 &&
+                next_token(data, size, &at, token, sizeof(token)) && sscanf(token, "%u", &maxval) == 1;
+        depth = 3;
+        at++; // NOTE: exactly one whitespace byte before the raster
+    } else if (valid && strcmp(token, "P7") == 0) {
+        char value[32];
+        while ((valid = next_token(data, size, &at, token, sizeof(token))) && strcmp(token, "ENDHDR") != 0) {
+            if (!next_token(data, size, &at, value, sizeof(value))) {
+                valid = false;
+                break;
+            }
+            if (strcmp(token, "WIDTH") == 0) width = (uint32_t)strtoul(value, nullptr, 10);
+            else if (strcmp(token, "HEIGHT") == 0) height = (uint32_t)strtoul(value, nullptr, 10);
+            else if (strcmp(token, "DEPTH") == 0) depth = (uint32_t)strtoul(value, nullptr, 10);
+            else if (strcmp(token, "MAXVAL") == 0) maxval = (uint32_t)strtoul(value, nullptr, 10);
+        }
+        at++;
+    } else {
+        valid = false;
+    }
+
+    uint64_t raster = (uint64_t)width * height * depth;
+    if (!valid || width == 0 || height == 0 || width > 16384 || height > 16384 ||
+        maxval != 255 || (depth != 3 && depth != 4) || at + raster > size) {
+        fprintf(stderr, "%s: unsupported image, expected 8 bit P6 or P7 RGB/RGB_ALPHA.\n", file_path);
+        assets.Release(asset);
+        return false;
+    }
+
+    image->width = width;
+    image->height = height;
+    image->pixels = (uint32_t*)malloc((size_t)width * height * sizeof(uint32_t));
+    const uint8_t *src = data + at;
+    for (uint64_t i = 0; i < (uint64_t)width * height; ++i, src += depth) {
+        uint32_t alpha = depth == 4 ? src[3] : 255;
+        image->pixels[i] = src[0] | (src[1] << 8) | (src[2] << 16) | (alpha << 24);
+    }
+    assets.Release(asset);
+    return true;
+}
+
+void FreeImage(AtlasImage *image)
+{
+    free(image->pixels);
+    image->pixels = nullptr;
+    image->width = image->height = 0;
+}
+
+// NOTE: Shelves left to right, top to bottom, in the given order; false if the square is too small
+static bool shelf_pack(const uint32_t *w, const uint32_t *h, const uint32_t *order, uint32_t count,
+                       uint32_t size, uint32_t *x, uint32_t *y)
+{
+    uint32_t cursor = 0, shelf = 0, shelf_height = 0;
+    for (uint32_t k = 0; k < count; ++k) {
+        uint32_t i = order[k];
+        if (w[i] > size) return false;
+        if (cursor + w[i] > size) {
+            shelf += shelf_height;
+            cursor = 0;
+            shelf_height = 0;
+        }
+        if (shelf + h[i] > size) return false;
+        x[i] = cursor;
+        y[i] = shelf;
+        cursor += w[i];
+        if (h[i] > shelf_height) shelf_height = h[i];
+    }
+    return true;
+}
+
+bool BuildAtlas(Atlas *atlas, const AtlasImage *images, const char *const *names, uint32_t count, uint32_t max_size)
+{
+    static const uint32_t white = 0xFFFFFFFFu;
+    uint32_t total = count + 1;
+    const uint32_t **sources = new const uint32_t*[total];
+    const char **sprite_names = new const char*[total];
+    uint32_t *w = new uint32_t[total * 5];
+    uint32_t *h = w + total, *x = w + total * 2, *y = w + total * 3, *order = w + total * 4;
+
+    bool valid = true;
+    sources[0] = &white;
+    sprite_names[0] = ATLAS_WHITE;
+    w[0] = h[0] = 1 + 2 * ATLAS_PADDING;
+    for (uint32_t i = 0; i < count; ++i) {
+        sources[i + 1] = images[i].pixels;
+        sprite_names[i + 1] = names[i];
+        w[i + 1] = images[i].width + 2 * ATLAS_PADDING;
+        h[i + 1] = images[i].height + 2 * ATLAS_PADDING;
+        if (images[i].pixels == nullptr || images[i].width == 0 || images[i].height == 0 ||
+            strlen(names[i]) >= ATLAS_NAME_LENGTH) {
+            fprintf(stderr, "Atlas sprite %u (%s) is empty or its name is too long.\n", i, names[i]);
+            valid = false;
+        }
+    }
+
+    // NOTE: Tallest first keeps the shelves tight; insertion sort, skins are small
+    for (uint32_t i = 0; i < total; ++i) {
+        uint32_t k = i;
+        while (k > 0 && h[order[k - 1]] < h[i]) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = i;
+    }
+
+    uint32_t size = ATLAS_MIN_SIZE;
+    while (valid && size <= max_size && !shelf_pack(w, h, order, total, size, x, y)) size *= 2;
+    if (valid && size > max_size) {
+        fprintf(stderr, "Atlas sprites don't fit into %ux%u.\n", max_size, max_size);
+        valid = false;
+    }
+
+    if (valid) {
+        atlas->Reset();
+        atlas->width = atlas->height = size;
+        atlas->pixels = (uint32_t*)calloc((size_t)size * size, sizeof(uint32_t));
+        atlas->sprites = (AtlasSprite*)calloc(total, sizeof(AtlasSprite));
+        atlas->sprite_count = total;
+        for (uint32_t i = 0; i < total; ++i) {
+            uint32_t sw = w[i] - 2 * ATLAS_PADDING, sh = h[i] - 2 * ATLAS_PADDING;
+            // NOTE: The padding repeats the nearest edge pixel
+            for (uint32_t py = 0; py < h[i]; ++py) {
+                int32_t sy = (int32_t)py - ATLAS_PADDING;
+                sy = sy < 0 ? 0 : (sy >= (int32_t)sh ? (int32_t)sh - 1 : sy);
+                uint32_t *dst = atlas->pixels + (size_t)(y[i] + py) * size + x[i];
+                for (uint32_t px = 0; px < w[i]; ++px) {
+                    int32_t sx = (int32_t)px - ATLAS_PADDING;
+                    sx = sx < 0 ? 0 : (sx >= (int32_t)sw ? (int32_t)sw - 1 : sx);
+                    dst[px] = sources[i][(size_t)sy * sw + sx];
+                }
+            }
+            AtlasSprite *sprite = &atlas->sprites[i];
+            strncpy(sprite->name, sprite_names[i], ATLAS_NAME_LENGTH - 1);
+            sprite->x = x[i] + ATLAS_PADDING;
+            sprite->y = y[i] + ATLAS_PADDING;
+            sprite->width = sw;
+            sprite->height = sh;
+            sprite->u0 = (float)sprite->x / size;
+            sprite->v0 = (float)sprite->y / size;
+            sprite->u1 = (float)(sprite->x + sw) / size;
+            sprite->v1 = (float)(sprite->y + sh) / size;
+        }
+    }
+
+    delete[] sources;
+    delete[] sprite_names;
+    delete[] w;
+    return valid;
+}
+
+bool SaveAtlas(const Atlas *atlas, const char *file_path)
+{
+    void *sprites = atlas->sprites;
+    void *pixels = atlas->pixels;
+    SoAColumn columns[2] = {{&sprites, sizeof(AtlasSprite)}, {&pixels, sizeof(uint32_t)}};
+    uint32_t counts[2] = {atlas->sprite_count, atlas->width * atlas->height};
+
+    AtlasHeader header = {};
+    header.width = atlas->width;
+    header.height = atlas->height;
+    header.sprite_count = atlas->sprite_count;
+    return blockfile_write(file_path, &header, sizeof(header), ATLAS_MAGIC, ATLAS_VERSION, columns, counts, 2);
+}
+
+bool LoadAtlas(Atlas *atlas, const char *file_path)
+{
+    void *sprites = nullptr;
+    void *pixels = nullptr;
+    SoAColumn columns[2] = {{&sprites, sizeof(AtlasSprite)}, {&pixels, sizeof(uint32_t)}};
+    size_t size = 0;
+    void *mapping = blockfile_map(file_path, &size, ATLAS_MAGIC, ATLAS_VERSION, sizeof(AtlasHeader), columns, 2);
+    if (mapping == nullptr) return false;
+
+    const AtlasHeader *header = (const AtlasHeader*)mapping;
+    const BlockFileBlock *blocks = blockfile_blocks(mapping);
+    const AtlasSprite *loaded = (const AtlasSprite*)((const char*)mapping + blocks[0].offset);
+    bool valid = header->width > 0 && header->width <= 16384 && header->height > 0 && header->height <= 16384 &&
+                 blocks[0].count == header->sprite_count &&
+                 (uint64_t)blocks[1].count == (uint64_t)header->width * header->height;
+    for (uint32_t i = 0; valid && i < header->sprite_count; ++i) {
+        const AtlasSprite *sprite = &loaded[i];
+        if (memchr(sprite->name, '\0', ATLAS_NAME_LENGTH) == nullptr ||
+            (uint64_t)sprite->x + sprite->width > header->width ||
+            (uint64_t)sprite->y + sprite->height > header->height) {
+            valid = false;
+        }
+    }
+    if (!valid) {
+        fprintf(stderr, "%s: corrupt atlas header or sprite table.\n", file_path);
+        munmap(mapping, size);
+        return false;
+    }
+
+    atlas->Reset();
+    atlas->width = header->width;
+    atlas->height = header->height;
+    atlas->sprite_count = header->sprite_count;
+    atlas->sprites = (AtlasSprite*)((char*)mapping + blocks[0].offset);
+    atlas->pixels = (uint32_t*)((char*)mapping + blocks[1].offset);
+    atlas->mapping = mapping;
+    atlas->mapping_size = size;
+    return true;
+}
+
+const char *const SkinSpriteNames[ATLAS_SKIN_SPRITES] = {
+    "brick0", "brick1", "brick2", "brick3", "brick4", "brick5", "brick6", "brick7", "paddle",
+};
+
+// NOTE: Brick types differ by groove and rivet bits, the paddle is a lit capsule
+void MakeSkinSprite(uint32_t index, AtlasImage *image)
+{
+    bool paddle = index >= LEVEL_MAX_TYPES;
+    image->width = paddle ? 64 : 32;
+    image->height = 16;
+    image->pixels = (uint32_t*)malloc((size_t)image->width * image->height * sizeof(uint32_t));
+    int32_t w = (int32_t)image->width, h = (int32_t)image->height;
+
+    for (int32_t y = 0; y < h; ++y) {
+        for (int32_t x = 0; x < w; ++x) {
+            float value, alpha = 1.0f;
+            if (paddle) {
+                float r = h * 0.5f;
+                float cx = fminf(fmaxf(x + 0.5f, r), w - r);
+                float d = hypotf(x + 0.5f - cx, y + 0.5f - r);
+                alpha = fminf(fmaxf(r - d, 0.0f), 1.0f);
+                value = 0.95f - 0.35f * (float)y / h - (d > r - 1.5f ? 0.25f : 0.0f);
+            } else {
+                int32_t edge = x < y ? x : y;
+                edge = edge < w - 1 - x ? edge : w - 1 - x;
+                edge = edge < h - 1 - y ? edge : h - 1 - y;
+                if (edge == 0) value = 0.5f;
+                else if (edge == 1) value = (x == 1 || y == 1) ? 1.0f : 0.65f;
+                else value = 0.85f;
+                if ((index & 1) && edge > 1 && y == h / 2) value = 0.65f;
+                if ((index & 2) && edge > 1 && (x == w / 3 || x == 2 * w / 3)) value = 0.65f;
+                if ((index & 4) && (x == 4 || x == w - 5) && (y == 4 || y == h - 5)) value = 1.0f;
+            }
+            image->pixels[y * w + x] = gray_pixel(value, alpha);
+        }
+    }
+}
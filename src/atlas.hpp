@@ -0,0 +1,75 @@
+#ifndef ATLAS_H_
+#define ATLAS_H_
+
+#include "./game.hpp"
+
+// Sprite atlas: every sprite image of a skin packed into one RGBA8 texture, so
+// bricks and paddles of any type share one texture bind and one draw call.
+//
+// BuildAtlas packs images onto shelves, tallest first, into the smallest
+// power-of-two square that fits. Every sprite gets an ATLAS_PADDING border
+// that repeats its edge pixels, so linear filtering never bleeds neighbours
+// in. A 1x1 white sprite named "white" always comes first; untextured quads
+// sample it and stay in the same batch.
+//
+// Packed atlases can be saved as block files and mapped back in, which skips
+// loading and packing the images at startup.
+
+#define ATLAS_MAGIC "BRKATLS"
+#define ATLAS_VERSION 1
+#define ATLAS_NAME_LENGTH 24
+#define ATLAS_PADDING 1
+#define ATLAS_MIN_SIZE 64
+#define ATLAS_WHITE "white"
+#define ATLAS_SKIN_SPRITES (LEVEL_MAX_TYPES + 1) // NOTE: brick0..brick7 and paddle
+
+struct AtlasImage {
+    uint32_t width;
+    uint32_t height;
+    uint32_t *pixels; // NOTE: RGBA8, red in the lowest byte
+};
+
+struct AtlasSprite {
+    char name[ATLAS_NAME_LENGTH];
+    uint32_t x; // NOTE: texels, without the padding
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+};
+
+struct Atlas {
+    Atlas();
+    ~Atlas();
+    Atlas(const Atlas&) = delete;
+    Atlas& operator=(const Atlas&) = delete;
+
+    void Reset();
+    int32_t Find(const char *name) const; // NOTE: -1 if missing
+    void stats() const;
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t *pixels;
+    AtlasSprite *sprites;
+    uint32_t sprite_count;
+    void *mapping; // NOTE: set when loaded, pixels and sprites point into it
+    size_t mapping_size;
+};
+
+// NOTE: Binary PPM (P6, maxval 255) or PAM (P7 with RGB or RGB_ALPHA tuples)
+bool LoadImage(const char *file_path, AtlasImage *image);
+void FreeImage(AtlasImage *image);
+
+bool BuildAtlas(Atlas *atlas, const AtlasImage *images, const char *const *names, uint32_t count, uint32_t max_size);
+bool SaveAtlas(const Atlas *atlas, const char *file_path);
+bool LoadAtlas(Atlas *atlas, const char *file_path);
+
+// NOTE: Grayscale brick and paddle sprites, tinted per brick color when drawn
+extern const char *const SkinSpriteNames[ATLAS_SKIN_SPRITES];
+void MakeSkinSprite(uint32_t index, AtlasImage *image);
+
+#endif // ATLAS_H_
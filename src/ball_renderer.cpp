@@ -0,0 +1,166 @@
+#include "./breakoutt.hpp"
+
+#define BALL_VERTEX_SHADER "shader/ball_instanced.vert"
+#define BALL_FRAGMENT_SHADER "shader/fragment_shader.frag"
+
+BallRenderer::BallRenderer():
+    VAO(0), MeshVBO(0), EBO(0), ProgramId(0), aspectRatioLoc(-1),
+    aaMarginLoc(-1), circleModeLoc(-1), mode(BALL_SDF), pixel_size(0.0f),
+    index_count(0), index_first(0), instances({nullptr, 0, 0}), previous({nullptr, 0, 0}),
+    previous_offset(0), uploaded_bytes(0), reused_frames(0), draw_calls(0)
+{}
+
+BallRenderer::~BallRenderer()
+{
+    array_delete(&instances);
+    array_delete(&previous);
+    gl_state.DeleteBuffer(&EBO);
+    gl_state.DeleteBuffer(&MeshVBO);
+    gl_state.DeleteVertexArray(&VAO);
+    gl_state.DeleteProgram(&ProgramId);
+}
+
+bool BallRenderer::Init(BallMode ball_mode, float pixel)
+{
+    mode = ball_mode;
+    pixel_size = pixel;
+    GLuint program = LoadShader(BALL_VERTEX_SHADER, BALL_FRAGMENT_SHADER);
+    if (program == 0) return false;
+    SwapProgram(program);
+    array_new(&instances, BallInstance);
+    array_new(&previous, BallInstance);
+    if (!stream.Init(64 * sizeof(BallInstance))) return false;
+
+    // NOTE: Unit circle around the origin, center vertex first, followed by the unit quad
+    const uint32_t quad_first = BALL_MESH_SEGMENTS + 1;
+    float mesh[(BALL_MESH_SEGMENTS + 1 + 4) * 2] = {};
+    uint32_t mesh_indices[BALL_MESH_SEGMENTS * 3 + 6];
+    float step = 2.0f * PI / (float)BALL_MESH_SEGMENTS;
+    for (uint32_t s = 0; s < BALL_MESH_SEGMENTS; ++s) {
+        mesh[(s + 1) * 2 + 0] = cosf(step * s);
+        mesh[(s + 1) * 2 + 1] = sinf(step * s);
+        mesh_indices[s * 3 + 0] = 0;
+        mesh_indices[s * 3 + 1] = 1 + s;
+        mesh_indices[s * 3 + 2] = 1 + (s + 1) % BALL_MESH_SEGMENTS;
+    }
+    const float quad[8] = {-1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f};
+    memcpy(mesh + quad_first * 2, quad, sizeof(quad));
+    const uint32_t quad_indices[6] = {0, 1, 2, 0, 2, 3};
+    for (uint32_t i = 0; i < 6; ++i) mesh_indices[BALL_MESH_SEGMENTS * 3 + i] = quad_first + quad_indices[i];
+
+    if (mode == BALL_SDF) {
+        index_first = BALL_MESH_SEGMENTS * 3;
+        index_count = 6;
+    } else {
+        index_first = 0;
+        index_count = BALL_MESH_SEGMENTS * 3;
+    }
+
+    glGenVertexArrays(1, &VAO);
+    gl_state.BindVertexArray(VAO);
+
+    glGenBuffers(1, &MeshVBO);
+    gl_state.BindBuffer(GL_ARRAY_BUFFER, MeshVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(mesh), mesh, GL_STATIC_DRAW);
+    glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(0, 0);
+    glEnableVertexAttribArray(0);
+    glBindVertexBuffer(0, MeshVBO, 0, 2 * sizeof(float));
+
+    glGenBuffers(1, &EBO);
+    gl_state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(mesh_indices), mesh_indices, GL_STATIC_DRAW);
+
+    // NOTE: Instances come from the stream, binding 1 is re-pointed every frame
+    glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(BallInstance, x));
+    glVertexAttribBinding(1, 1);
+    glEnableVertexAttribArray(1);
+    glVertexAttribFormat(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(BallInstance, color));
+    glVertexAttribBinding(2, 1);
+    glEnableVertexAttribArray(2);
+    glVertexBindingDivisor(1, 1);
+
+    gl_state.BindVertexArray(0);
+    return true;
+}
+
+void BallRenderer::Push(float x, float y, float radius, uint32_t color)
+{
+    BallInstance instance = {x, y, radius, color};
+    array_append(BallInstance, &instances, instance);
+}
+
+// NOTE: Only the instances go over the bus, 16 bytes per ball per frame
+bool BallRenderer::SwapProgram(GLuint program)
+{
+    gl_state.DeleteProgram(&ProgramId);
+    ProgramId = program;
+    aspectRatioLoc = glGetUniformLocation(ProgramId, "aspectRatio");
+    aaMarginLoc = glGetUniformLocation(ProgramId, "aaMargin");
+    circleModeLoc = glGetUniformLocation(ProgramId, "circleMode");
+    return true;
+}
+
+static bool swap_ball_program(void *owner, GLuint program)
+{
+    return ((BallRenderer*)owner)->SwapProgram(program);
+}
+
+void BallRenderer::WatchShaders(ShaderReloader *reloader)
+{
+    reloader->Add(BALL_VERTEX_SHADER, BALL_FRAGMENT_SHADER, this, swap_ball_program);
+}
+
+void BallRenderer::Draw(float aspect_ratio)
+{
+    uint32_t count = instances.count;
+    instances.count = 0;
+    if (count == 0) {
+        previous.count = 0;
+        return;
+    }
+
+    // NOTE: Nothing moved, the last region still holds these instances and stays current
+    uint32_t bytes = count * sizeof(BallInstance);
+    GLintptr offset = previous_offset;
+    if (count == previous.count && memcmp(instances.items, previous.items, bytes) == 0) {
+        reused_frames++;
+    } else {
+        stream.BeginFrame();
+        void *dst = stream.Allocate(bytes, &offset);
+        if (dst == nullptr) {
+            previous.count = 0;
+            return;
+        }
+        memcpy(dst, instances.items, bytes);
+        stream.Commit(offset, bytes);
+        uploaded_bytes += bytes;
+
+        BallInstances swap = previous;
+        previous = instances;
+        instances = swap;
+        instances.count = 0;
+        previous.count = count;
+        previous_offset = offset;
+    }
+
+    gl_state.UseProgram(ProgramId);
+    glUniform1f(aspectRatioLoc, aspect_ratio);
+    glUniform1f(aaMarginLoc, mode == BALL_SDF ? pixel_size : 0.0f);
+    glUniform1i(circleModeLoc, mode == BALL_SDF);
+    gl_state.BindVertexArray(VAO);
+    glBindVertexBuffer(1, stream.Buffer, offset, sizeof(BallInstance));
+    glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT,
+                            (void*)(index_first * sizeof(uint32_t)), count);
+    stream.EndFrame();
+    draw_calls++;
+}
+
+void BallRenderer::stats() const
+{
+    printf("Ball Renderer Info: \n");
+    printf("    Mode: %s, %u indices per ball\n", mode == BALL_SDF ? "SDF quad" : "mesh", index_count);
+    printf("    Draw calls: %lu, Instance bytes uploaded: %lu, Frames without upload: %lu\n",
+           (unsigned long)draw_calls, (unsigned long)uploaded_bytes, (unsigned long)reused_frames);
+    stream.stats();
+}
@@ -0,0 +1,321 @@
+#include "./breakoutt.hpp"
+
+BatchRenderer::BatchRenderer():
+    VAO(0), ProgramId(0), aspectRatioLoc(-1), modelLoc(-1), atlasLoc(-1),
+    AtlasTexture(0), white_u(0.5f), white_v(0.5f),
+    vertices({nullptr, 0, 0}), indices({nullptr, 0, 0}),
+    RetainedVBO(0), RetainedEBO(0), retained(nullptr), retained_count(0), retained_capacity(0),
+    frames(0), draw_calls(0), peak_vertices(0), streamed_bytes(0), retained_bytes(0), retained_uploads(0)
+{}
+
+BatchRenderer::~BatchRenderer()
+{
+    array_delete(&vertices);
+    array_delete(&indices);
+    free(retained);
+    gl_state.DeleteBuffer(&RetainedEBO);
+    gl_state.DeleteBuffer(&RetainedVBO);
+    gl_state.DeleteTexture(&AtlasTexture);
+    gl_state.DeleteVertexArray(&VAO);
+    gl_state.DeleteProgram(&ProgramId);
+}
+
+// NOTE: The batch owns the program once Init succeeds, it needs the aspectRatio, model and atlas uniforms
+bool BatchRenderer::Init(GLuint program)
+{
+    if (!SwapProgram(program)) return false;
+
+    // NOTE: Until an atlas is set everything samples a single white texel
+    const uint32_t white = 0xFFFFFFFFu;
+    glGenTextures(1, &AtlasTexture);
+    gl_state.BindTexture(0, AtlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl_state.BindTexture(0, 0);
+
+    array_new(&vertices, Vertex);
+    array_new(&indices, uint32_t);
+    if (!stream.Init(INITIAL_CAPACITY * (4 * sizeof(Vertex) + 6 * sizeof(uint32_t)))) return false;
+
+    // NOTE: The format is fixed, the vertex buffer binding moves through the stream every frame
+    glGenVertexArrays(1, &VAO);
+    gl_state.BindVertexArray(VAO);
+
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
+    glVertexAttribBinding(0, 0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribFormat(1, 4, GL_FLOAT, GL_FALSE, offsetof(Vertex, color));
+    glVertexAttribBinding(1, 0);
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, u));
+    glVertexAttribBinding(2, 0);
+    glEnableVertexAttribArray(2);
+
+    gl_state.BindVertexArray(0);
+
+    glGenBuffers(1, &RetainedVBO);
+    glGenBuffers(1, &RetainedEBO);
+    return true;
+}
+
+bool BatchRenderer::SwapProgram(GLuint program)
+{
+    GLint aspect = glGetUniformLocation(program, "aspectRatio");
+    GLint model = glGetUniformLocation(program, "model");
+    GLint atlas = glGetUniformLocation(program, "atlas");
+    if (aspect == -1 || model == -1 || atlas == -1) {
+        fprintf(stderr, "Batch program is missing the aspectRatio, model or atlas uniform.\n");
+        return false;
+    }
+    gl_state.DeleteProgram(&ProgramId);
+    ProgramId = program;
+    aspectRatioLoc = aspect;
+    modelLoc = model;
+    atlasLoc = atlas;
+    return true;
+}
+
+static bool swap_batch_program(void *owner, GLuint program)
+{
+    return ((BatchRenderer*)owner)->SwapProgram(program);
+}
+
+void BatchRenderer::WatchShaders(ShaderReloader *reloader, const char *vertex_path, const char *fragment_path)
+{
+    reloader->Add(vertex_path, fragment_path, this, swap_batch_program);
+}
+
+bool BatchRenderer::SetAtlas(const Atlas *atlas)
+{
+    int32_t white = atlas->Find(ATLAS_WHITE);
+    if (white < 0) {
+        fprintf(stderr, "Atlas has no \"%s\" sprite for untextured quads.\n", ATLAS_WHITE);
+        return false;
+    }
+    const AtlasSprite *sprite = &atlas->sprites[white];
+    white_u = (sprite->x + 0.5f) / atlas->width;
+    white_v = (sprite->y + 0.5f) / atlas->height;
+
+    gl_state.BindTexture(0, AtlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlas->width, atlas->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, atlas->pixels);
+    gl_state.BindTexture(0, 0);
+    return true;
+}
+
+void BatchRenderer::Begin()
+{
+    vertices.count = 0;
+    indices.count = 0;
+}
+
+static void batch_reserve(void **items, uint32_t *capacity, uint32_t needed, size_t elem_size)
+{
+    if (needed <= *capacity) return;
+    uint32_t grown = *capacity == 0 ? INITIAL_CAPACITY : *capacity;
+    while (grown < needed) grown *= 2;
+    *items = realloc(*items, grown * elem_size);
+    assert(*items != nullptr && "Memory Reallocation For Batch Failed.");
+    *capacity = grown;
+}
+
+void BatchRenderer::PushQuad(float x, float y, float w, float h, Color color)
+{
+    PushTexturedQuad(x, y, w, h, white_u, white_v, white_u, white_v, color);
+}
+
+// NOTE: Image rows run top down, so the top edge samples v0
+void BatchRenderer::PushSprite(float x, float y, float w, float h, const AtlasSprite *sprite, Color tint)
+{
+    PushTexturedQuad(x, y, w, h, sprite->u0, sprite->v0, sprite->u1, sprite->v1, tint);
+}
+
+static void write_quad(Vertex *v, float x, float y, float w, float h, float u0, float v0, float u1, float v1, Color color)
+{
+    float hw = w * 0.5f;
+    float hh = h * 0.5f;
+    v[0] = Vertex(Vector3(x - hw, y - hh, 0.0f), color, u0, v1); // bottom-left
+    v[1] = Vertex(Vector3(x - hw, y + hh, 0.0f), color, u0, v0); // top-left
+    v[2] = Vertex(Vector3(x + hw, y + hh, 0.0f), color, u1, v0); // top-right
+    v[3] = Vertex(Vector3(x + hw, y - hh, 0.0f), color, u1, v1); // bottom-right
+}
+
+void BatchRenderer::PushTexturedQuad(float x, float y, float w, float h, float u0, float v0, float u1, float v1, Color color)
+{
+    batch_reserve((void**)&vertices.items, &vertices.capacity, vertices.count + 4, sizeof(Vertex));
+    batch_reserve((void**)&indices.items, &indices.capacity, indices.count + 6, sizeof(uint32_t));
+
+    uint32_t base = vertices.count;
+    write_quad(vertices.items + base, x, y, w, h, u0, v0, u1, v1, color);
+    vertices.count += 4;
+
+    uint32_t *i = indices.items + indices.count;
+    i[0] = base; i[1] = base + 1; i[2] = base + 2;
+    i[3] = base; i[4] = base + 2; i[5] = base + 3;
+    indices.count += 6;
+}
+
+// NOTE: A fan around a center vertex, written as plain triangles so it shares the draw with the quads
+void BatchRenderer::PushCircle(float x, float y, float radius, uint32_t segments, Color color)
+{
+    if (segments < 3) segments = 3;
+    batch_reserve((void**)&vertices.items, &vertices.capacity, vertices.count + segments + 1, sizeof(Vertex));
+    batch_reserve((void**)&indices.items, &indices.capacity, indices.count + segments * 3, sizeof(uint32_t));
+
+    uint32_t center = vertices.count;
+    Vertex *v = vertices.items + center;
+    v[0] = Vertex(Vector3(x, y, 0.0f), color, white_u, white_v);
+    float step = 2.0f * PI / (float)segments;
+    for (uint32_t s = 0; s < segments; ++s) {
+        v[s + 1] = Vertex(Vector3(x + radius * cosf(step * s), y + radius * sinf(step * s), 0.0f), color, white_u, white_v);
+    }
+    vertices.count += segments + 1;
+
+    uint32_t *i = indices.items + indices.count;
+    for (uint32_t s = 0; s < segments; ++s) {
+        i[s * 3 + 0] = center;
+        i[s * 3 + 1] = center + 1 + s;
+        i[s * 3 + 2] = center + 1 + (s + 1) % segments;
+    }
+    indices.count += segments * 3;
+}
+
+// NOTE: All zero, same as a freshly grown slot, so hiding a new slot uploads nothing
+static const Vertex hidden_quad[4] = {
+    Vertex(Vector3(0.0f, 0.0f, 0.0f), Color(0.0f, 0.0f, 0.0f, 0.0f), 0.0f, 0.0f),
+    Vertex(Vector3(0.0f, 0.0f, 0.0f), Color(0.0f, 0.0f, 0.0f, 0.0f), 0.0f, 0.0f),
+    Vertex(Vector3(0.0f, 0.0f, 0.0f), Color(0.0f, 0.0f, 0.0f, 0.0f), 0.0f, 0.0f),
+    Vertex(Vector3(0.0f, 0.0f, 0.0f), Color(0.0f, 0.0f, 0.0f, 0.0f), 0.0f, 0.0f),
+};
+
+// NOTE: New slots start hidden. Growing reallocates the GPU buffer, so every slot is re-sent once
+void BatchRenderer::ResizeRetained(uint32_t count)
+{
+    if (count == retained_count) return;
+    if (count > retained_capacity) {
+        uint32_t grown = retained_capacity == 0 ? INITIAL_CAPACITY : retained_capacity;
+        while (grown < count) grown *= 2;
+        retained = (Vertex*)realloc(retained, (size_t)grown * 4 * sizeof(Vertex));
+        assert(retained != nullptr && "Memory Reallocation For Retained Quads Failed.");
+        retained_capacity = grown;
+
+        gl_state.BindBuffer(GL_ARRAY_BUFFER, RetainedVBO);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)grown * 4 * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+
+        // NOTE: Every slot is the same two triangles, the index buffer never changes after this
+        uint32_t *quad_indices = (uint32_t*)malloc((size_t)grown * 6 * sizeof(uint32_t));
+        assert(quad_indices != nullptr && "Memory Allocation For Retained Indices Failed.");
+        for (uint32_t q = 0; q < grown; ++q) {
+            uint32_t *i = quad_indices + q * 6;
+            i[0] = q * 4; i[1] = q * 4 + 1; i[2] = q * 4 + 2;
+            i[3] = q * 4; i[4] = q * 4 + 2; i[5] = q * 4 + 3;
+        }
+        // NOTE: Through the copy target, binding it as element array would change whichever VAO is bound
+        gl_state.BindBuffer(GL_COPY_WRITE_BUFFER, RetainedEBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)grown * 6 * sizeof(uint32_t), quad_indices, GL_STATIC_DRAW);
+        free(quad_indices);
+    }
+    for (uint32_t slot = retained_count; slot < count; ++slot) {
+        memcpy(retained + (size_t)slot * 4, hidden_quad, sizeof(hidden_quad));
+    }
+    retained_count = count;
+    retained_dirty.Resize(count);
+}
+
+void BatchRenderer::SetRetainedQuad(uint32_t slot, float x, float y, float w, float h, const AtlasSprite *sprite, Color color)
+{
+    assert(slot < retained_count);
+    Vertex quad[4] = {hidden_quad[0], hidden_quad[1], hidden_quad[2], hidden_quad[3]};
+    if (sprite == nullptr) write_quad(quad, x, y, w, h, white_u, white_v, white_u, white_v, color);
+    else write_quad(quad, x, y, w, h, sprite->u0, sprite->v0, sprite->u1, sprite->v1, color);
+
+    Vertex *v = retained + (size_t)slot * 4;
+    if (memcmp(v, quad, sizeof(quad)) == 0) return;
+    memcpy(v, quad, sizeof(quad));
+    retained_dirty.Mark(slot);
+}
+
+void BatchRenderer::HideRetained(uint32_t slot)
+{
+    assert(slot < retained_count);
+    Vertex *v = retained + (size_t)slot * 4;
+    if (memcmp(v, hidden_quad, sizeof(hidden_quad)) == 0) return;
+    memcpy(v, hidden_quad, sizeof(hidden_quad));
+    retained_dirty.Mark(slot);
+}
+
+void BatchRenderer::UploadRetained()
+{
+    uint32_t ranges = retained_dirty.Collect(BATCH_RETAINED_GAP);
+    if (ranges == 0) return;
+    gl_state.BindBuffer(GL_ARRAY_BUFFER, RetainedVBO);
+    for (uint32_t r = 0; r < ranges; ++r) {
+        const DirtyRange *range = &retained_dirty.ranges.items[r];
+        GLintptr offset = (GLintptr)range->first * 4 * sizeof(Vertex);
+        GLsizeiptr size = (GLsizeiptr)range->count * 4 * sizeof(Vertex);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, size, retained + (size_t)range->first * 4);
+        retained_bytes += (uint64_t)size;
+    }
+    retained_uploads += ranges;
+}
+
+// NOTE: Retained quads draw first, so anything pushed this frame lands on top of them
+void BatchRenderer::Flush(float aspect_ratio, const Matrix4 *model)
+{
+    frames++;
+    if (vertices.count > peak_vertices) peak_vertices = vertices.count;
+    UploadRetained();
+    if (retained_count == 0 && indices.count == 0) return;
+
+    uint32_t vertex_bytes = vertices.count * sizeof(Vertex);
+    uint32_t index_bytes = indices.count * sizeof(uint32_t);
+    GLintptr offset = 0;
+    uint8_t *dst = nullptr;
+    if (indices.count > 0) {
+        stream.BeginFrame();
+        dst = (uint8_t*)stream.Allocate(vertex_bytes + index_bytes, &offset);
+        if (dst != nullptr) {
+            memcpy(dst, vertices.items, vertex_bytes);
+            memcpy(dst + vertex_bytes, indices.items, index_bytes);
+            stream.Commit(offset, vertex_bytes + index_bytes);
+            streamed_bytes += vertex_bytes + index_bytes;
+        }
+    }
+
+    // NOTE: Quads are stored in the space `model` maps from, so moving it never touches a vertex
+    static const Matrix4 identity = Matrix4().identity();
+    gl_state.UseProgram(ProgramId);
+    glUniform1f(aspectRatioLoc, aspect_ratio);
+    glUniformMatrix4fv(modelLoc, 1, GL_TRUE, (model ? model : &identity)->getData());
+    glUniform1i(atlasLoc, 0);
+    gl_state.BindTexture(0, AtlasTexture);
+    gl_state.BindVertexArray(VAO);
+
+    if (retained_count > 0) {
+        glBindVertexBuffer(0, RetainedVBO, 0, sizeof(Vertex));
+        gl_state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, RetainedEBO);
+        glDrawElements(GL_TRIANGLES, retained_count * 6, GL_UNSIGNED_INT, (void*)0);
+        draw_calls++;
+    }
+    if (dst != nullptr) {
+        glBindVertexBuffer(0, stream.Buffer, offset, sizeof(Vertex));
+        gl_state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, stream.Buffer);
+        glDrawElements(GL_TRIANGLES, indices.count, GL_UNSIGNED_INT, (void*)(offset + vertex_bytes));
+        draw_calls++;
+    }
+    if (indices.count > 0) stream.EndFrame();
+}
+
+void BatchRenderer::stats() const
+{
+    printf("Batch Renderer Info: \n");
+    printf("    Frames: %lu, Draw calls: %lu\n", (unsigned long)frames, (unsigned long)draw_calls);
+    printf("    Peak vertices: %u, Streamed bytes: %lu\n", peak_vertices, (unsigned long)streamed_bytes);
+    printf("    Retained quads: %u, Uploaded bytes: %lu in %lu ranges\n",
+           retained_count, (unsigned long)retained_bytes, (unsigned long)retained_uploads);
+    stream.stats();
+}
@@ -0,0 +1,175 @@
+#include "./blockfile.hpp"
+
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#define BLOCKFILE_MAX_BLOCKS 32
+
+static inline uint64_t align_up(uint64_t size, uint64_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+bool blockfile_write(const char *file_path, void *header, uint32_t header_size,
+                     const char *magic, uint32_t version,
+                     SoAColumn *columns, const uint32_t *counts, uint32_t block_count)
+{
+    static const char padding[SOA_ALIGNMENT] = {};
+    assert(block_count <= BLOCKFILE_MAX_BLOCKS);
+    assert(header_size >= sizeof(BlockFileHeader));
+
+    BlockFileHeader *file = (BlockFileHeader*)header;
+    memset(file->magic, 0, sizeof(file->magic));
+    strncpy(file->magic, magic, sizeof(file->magic) - 1);
+    file->version = version;
+    file->header_size = header_size;
+    file->block_count = block_count;
+
+    BlockFileBlock blocks[BLOCKFILE_MAX_BLOCKS];
+    // NOTE: header, block table, then one (data, padding) pair per column
+    struct iovec iov[3 + 2*BLOCKFILE_MAX_BLOCKS];
+    int iov_count = 0;
+
+    uint64_t table_end = header_size + block_count * sizeof(BlockFileBlock);
+    uint64_t offset = align_up(table_end, SOA_ALIGNMENT);
+
+    iov[iov_count++] = {header, header_size};
+    iov[iov_count++] = {blocks, block_count * sizeof(BlockFileBlock)};
+    iov[iov_count++] = {(void*)padding, offset - table_end};
+
+    for (uint32_t i = 0; i < block_count; ++i) {
+        uint64_t bytes = (uint64_t)counts[i] * columns[i].elem_size;
+        uint64_t padded = align_up(bytes, SOA_ALIGNMENT);
+        blocks[i] = {columns[i].elem_size, counts[i], offset};
+        iov[iov_count++] = {*columns[i].data, bytes};
+        iov[iov_count++] = {(void*)padding, padded - bytes};
+        offset += padded;
+    }
+    file->file_size = offset;
+
+    int fd = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s: %s.\n", file_path, strerror(errno));
+        return false;
+    }
+
+    // NOTE: One sequential write, retried only if the kernel writes partially
+    uint64_t written = 0;
+    int first = 0;
+    while (written < offset) {
+        ssize_t n = writev(fd, iov + first, iov_count - first);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Failed to write %s: %s.\n", file_path, strerror(errno));
+            close(fd);
+            return false;
+        }
+        written += n;
+        while (first < iov_count && (size_t)n >= iov[first].iov_len) {
+            n -= iov[first].iov_len;
+            first++;
+        }
+        if (first < iov_count) {
+            iov[first].iov_base = (char*)iov[first].iov_base + n;
+            iov[first].iov_len -= n;
+        }
+    }
+
+    close(fd);
+    return true;
+}
+
+static bool blockfile_validate(const void *mapping, size_t file_size, const char *file_path,
+                               const char *magic, uint32_t version, uint32_t header_size,
+                               const SoAColumn *columns, uint32_t block_count)
+{
+    const BlockFileHeader *header = (const BlockFileHeader*)mapping;
+    if (strncmp(header->magic, magic, sizeof(header->magic)) != 0) {
+        fprintf(stderr, "%s: bad magic, expected %s.\n", file_path, magic);
+        return false;
+    }
+    if (header->version != version || header->header_size != header_size) {
+        fprintf(stderr, "%s: unsupported version %u.\n", file_path, header->version);
+        return false;
+    }
+    if (header->file_size != file_size || header->block_count != block_count) {
+        fprintf(stderr, "%s: corrupt header.\n", file_path);
+        return false;
+    }
+
+    const BlockFileBlock *blocks = blockfile_blocks(mapping);
+    for (uint32_t i = 0; i < block_count; ++i) {
+        uint64_t bytes = (uint64_t)blocks[i].count * blocks[i].elem_size;
+        if (blocks[i].elem_size != columns[i].elem_size || blocks[i].offset % SOA_ALIGNMENT != 0 ||
+            blocks[i].offset > file_size || bytes > file_size - blocks[i].offset) {
+            fprintf(stderr, "%s: corrupt block %u.\n", file_path, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+void *blockfile_map(const char *file_path, size_t *size,
+                    const char *magic, uint32_t version, uint32_t header_size,
+                    const SoAColumn *columns, uint32_t block_count)
+{
+    int fd = open(file_path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s: %s.\n", file_path, strerror(errno));
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < header_size + sizeof(BlockFileBlock)*block_count) {
+        fprintf(stderr, "%s: truncated file.\n", file_path);
+        close(fd);
+        return nullptr;
+    }
+
+    *size = st.st_size;
+    // NOTE: Private mapping, so the simulation can write into the columns without touching the file
+    void *mapping = mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s: %s.\n", file_path, strerror(errno));
+        return nullptr;
+    }
+
+    if (!blockfile_validate(mapping, *size, file_path, magic, version, header_size, columns, block_count)) {
+        munmap(mapping, *size);
+        return nullptr;
+    }
+    return mapping;
+}
+
+bool blockfile_check(const void *data, size_t size, const char *name,
+                     const char *magic, uint32_t version, uint32_t header_size,
+                     const SoAColumn *columns, uint32_t block_count)
+{
+    if (data == nullptr || size < header_size + sizeof(BlockFileBlock)*block_count) {
+        fprintf(stderr, "%s: truncated file.\n", name);
+        return false;
+    }
+    return blockfile_validate(data, size, name, magic, version, header_size, columns, block_count);
+}
+
+void *blockfile_copy(const void *data, size_t size, const char *name,
+                     const char *magic, uint32_t version, uint32_t header_size,
+                     const SoAColumn *columns, uint32_t block_count)
+{
+    if (!blockfile_check(data, size, name, magic, version, header_size, columns, block_count)) return nullptr;
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Failed to allocate %zu bytes for %s: %s.\n", size, name, strerror(errno));
+        return nullptr;
+    }
+    memcpy(mapping, data, size);
+    return mapping;
+}
@@ -0,0 +1,62 @@
+#ifndef BLOCKFILE_H_
+#define BLOCKFILE_H_
+
+#include "./game.hpp"
+
+// Block files hold SoA columns as aligned blocks, so they can be mapped and
+// used in place. Layout (native endianness and struct layout):
+//
+//   format header (starts with BlockFileHeader)
+//   BlockFileBlock[block_count]
+//   padding to SOA_ALIGNMENT
+//   column 0, padded to SOA_ALIGNMENT
+//   ...
+//   column block_count-1, padded to SOA_ALIGNMENT
+//
+// Used by snapshots and levels.
+
+struct BlockFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size; // NOTE: size of the whole format header
+    uint64_t file_size;
+    uint32_t block_count;
+    uint32_t reserved;
+};
+
+struct BlockFileBlock {
+    uint32_t elem_size;
+    uint32_t count;
+    uint64_t offset;
+};
+
+// NOTE: `header` must start with a BlockFileHeader; magic, version and block layout are filled in here
+bool blockfile_write(const char *file_path, void *header, uint32_t header_size,
+                     const char *magic, uint32_t version,
+                     SoAColumn *columns, const uint32_t *counts, uint32_t block_count);
+
+// NOTE: Maps the file copy-on-write and checks magic, version, sizes and block bounds.
+// Returns the mapping or nullptr, the caller owns it (munmap with *size).
+void *blockfile_map(const char *file_path, size_t *size,
+                    const char *magic, uint32_t version, uint32_t header_size,
+                    const SoAColumn *columns, uint32_t block_count);
+
+// NOTE: Same checks as blockfile_map for a block file image already in memory (an embedded asset);
+// `name` is only used in messages
+bool blockfile_check(const void *data, size_t size, const char *name,
+                     const char *magic, uint32_t version, uint32_t header_size,
+                     const SoAColumn *columns, uint32_t block_count);
+
+// NOTE: Checks an in-memory image and copies it into a private mapping the caller owns like
+// one from blockfile_map, for loaders that write into their columns
+void *blockfile_copy(const void *data, size_t size, const char *name,
+                     const char *magic, uint32_t version, uint32_t header_size,
+                     const SoAColumn *columns, uint32_t block_count);
+
+static inline const BlockFileBlock *blockfile_blocks(const void *mapping)
+{
+    const BlockFileHeader *header = (const BlockFileHeader*)mapping;
+    return (const BlockFileBlock*)((const char*)mapping + header->header_size);
+}
+
+#endif // BLOCKFILE_H_
@@ -8,206 +8,16 @@ void Color::stats() const
     printf("Color: [r: %.2f, g: %.2f, b: %.2f, a: %.2f]\n", r, g, b, a);
 }
 
-Ball::Ball(Vector3 position, float radius, Color color,
-            Vector3 velocity, int vcount, Indices indices,
-            Vertices vertices):
-    Position(position), Radius(radius), color(color),
-    Velocity(velocity), vCount(vcount), indices(indices),
-    vertices(vertices)
-{}
-
-Ball::~Ball()
-{
-    array_delete(&vertices);
-    array_delete(&indices);
-}
-
-void Ball::stats() const
-{
-    printf("Ball Info: \n");
-    printf("    Position: ");
-    Position.print();
-    printf("    Radius: %.2f\n", Radius);
-    printf("    vCount: %d\n", vCount);
-    printf("    Color: ");
-    color.stats();
-    printf("    Velocity: ");
-    Velocity.print();
-    printf("    Vertices: ");
-    array_analysis(&vertices);
-    printf("    Indices: ");
-    array_analysis(&indices);
-}
-
-void Ball::GenerateBall()
-{
-    if (vertices.items) array_delete(&vertices);
-    if (indices.items) array_delete(&indices);
-
-    float angle = 360.0f / vCount;
-    int triangleCount = vCount - 2;
-    array_new(&indices, uint32_t);
-    array_new(&vertices, Vertex);
-
-    // positions
-    for (int i = 0; i < vCount; i++)
-    {
-        float currentAngle = angle * i;
-        float x = Radius * cosf(degreesToRadians(currentAngle));
-        float y = Radius * sinf(degreesToRadians(currentAngle));
-        float z = 0.0f;
-        array_append(Vertex, &vertices, Vertex(Position + Vector3(x, y, z), color));
-    }
-
-    for (int i = 0; i < triangleCount; i++)
-    {
-        array_append(uint32_t, &indices, 0);
-        array_append(uint32_t, &indices, i + 1);
-        array_append(uint32_t, &indices, i + 2);
-    }
-}
-
-void Ball::RenderBall()
-{
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.count*sizeof(vertices.items[0]), vertices.items, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &EBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.count*sizeof(indices.items[0]), indices.items, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
-    glEnableVertexAttribArray(1);
-}
-
-void Ball::UpdateBall()
-{
-    // Regenerate ball vertices with new position
-    GenerateBall();
-
-    // Update vertex buffer
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.count * sizeof(vertices.items[0]), vertices.items);
-}
-
-Tile::Tile(Vector3 position, Vector3 size, Vector3 velocity,
-           Color color, Indices indices, Vertices vertices):
-    Position(position), Size(size), Velocity(velocity),
-    color(color), indices(indices), vertices(vertices)
-{}
-
-Tile::~Tile()
-{
-    array_delete(&vertices);
-    array_delete(&indices);
-}
-
-void Tile::stats() const
-{
-    printf("Tile Info: \n");
-    printf("    Position: ");
-    Position.print();
-    printf("    Size: ");
-    Size.print();
-    printf("    Color: ");
-    color.stats();
-    printf("    Vertices: ");
-    array_analysis(&vertices);
-    printf("    Indices: ");
-    array_analysis(&indices);
-}
-
-void Tile::GenerateTile()
-{
-    if (vertices.items) array_delete(&vertices);
-    if (indices.items) array_delete(&indices);
-
-    array_new(&indices, uint32_t);
-    array_new(&vertices, Vertex);
-
-    // Calculate corner positions
-    Vector3 half_size = Size *  0.5f;
-    float x = half_size.x;
-    float y = half_size.y;
-    Vector3 corners[4] = {
-        Position + Vector3(-x,  -y, 0.0f), // botom-left
-        Position + Vector3(-x,   y, 0.0f), // top-left
-        Position + Vector3( x,   y, 0.0f), // top-right
-        Position + Vector3( x,  -y, 0.0f) // bottom-right
-    };
-
-    uint32_t base_index = vertices.count;
-    for (uint32_t i = 0; i < 4; ++i) {
-        array_append(Vertex, &vertices, Vertex(corners[i], color));
-    }
-
-    uint32_t quad_indices[6] = {
-        base_index, base_index+1, base_index+2,
-        base_index, base_index+2, base_index+3
-    };
-    for (uint32_t i = 0; i < 6; ++i) {
-        array_append(uint32_t, &indices, quad_indices[i]);
-    }
-}
-
-void Tile::RenderTile()
-{
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.count*sizeof(vertices.items[0]), vertices.items, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &EBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.count*sizeof(indices.items[0]), indices.items, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
-    glEnableVertexAttribArray(1);
-}
-
-void Tile::UpdateTile()
-{
-    // Regenerate Tile vertices with new position
-    GenerateTile();
-
-    // Update vertex buffer
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.count * sizeof(vertices.items[0]), vertices.items);
-}
-
-void BallBounds(Ball *ball)
-{
-    // Boundary checking (simple example)
-    if (ball->Position.x + ball->Radius > 1.0f || ball->Position.x - ball->Radius < -1.0f) {
-        ball->Velocity.x *= -1.0f;
-    }
-
-    if (ball->Position.y + ball->Radius > 1.0f || ball->Position.y - ball->Radius < -1.0f) {
-        ball->Velocity.y *= -1.0f;
-    }
-}
-
-void TileBounds(Tile *tile)
-{
-    if (tile->Position.x > 1.0f) {
-        tile->Position.x = 1.0f;
-    }
-    if(tile->Position.x < -1.0f) {
-        tile->Position.x = -1.0f;
-    }
-}
-
-Vertex::Vertex(Vector3 Position, Color color):
-    Position(Position), color(color) {}
+const Color BrickPalette[LEVEL_MAX_COLORS] = {
+    Color(0.90f, 0.20f, 0.20f, 1.0f), Color(0.95f, 0.80f, 0.20f, 1.0f),
+    Color(0.30f, 0.80f, 0.30f, 1.0f), Color(0.25f, 0.45f, 0.95f, 1.0f),
+    Color(0.70f, 0.30f, 0.85f, 1.0f), Color(0.20f, 0.80f, 0.80f, 1.0f),
+    Color(0.95f, 0.55f, 0.15f, 1.0f), Color(0.85f, 0.85f, 0.85f, 1.0f),
+    Color(0.60f, 0.10f, 0.10f, 1.0f), Color(0.60f, 0.50f, 0.10f, 1.0f),
+    Color(0.10f, 0.45f, 0.15f, 1.0f), Color(0.10f, 0.20f, 0.55f, 1.0f),
+    Color(0.40f, 0.15f, 0.50f, 1.0f), Color(0.10f, 0.45f, 0.45f, 1.0f),
+    Color(0.55f, 0.30f, 0.10f, 1.0f), Color(0.45f, 0.45f, 0.45f, 1.0f),
+};
+
+Vertex::Vertex(Vector3 Position, Color color, float u, float v):
+    Position(Position), color(color), u(u), v(v) {}
@@ -7,6 +7,19 @@
 
 #include "../util/math_util.hpp"
 #include "../util/array.h"
+#include "./game.hpp"
+#include "./particles.hpp"
+#include "./events.hpp"
+#include "./rollback.hpp"
+#include "./net.hpp"
+#include "./soak.hpp"
+#include "./random.hpp"
+#include "./scene.hpp"
+#include "./levelgen.hpp"
+#include "./atlas.hpp"
+#include "./dirty.hpp"
+#include "./shader_watch.hpp"
+#include "./assets.hpp"
 
 struct Color {
     Color(float r, float g, float b, float a);
@@ -17,90 +30,343 @@ struct Color {
     float a;
 };
 
+// NOTE: Brick color indices (Bricks::color) map into this palette
+extern const Color BrickPalette[LEVEL_MAX_COLORS];
+
 struct Vertex {
     Vector3 Position;
     Color color;
-    Vertex(Vector3 Position, Color color);
+    float u;
+    float v;
+    Vertex(Vector3 Position, Color color, float u, float v);
 };
 
-struct Ball;
-struct Tile;
-
-typedef ARRAY(Ball) Balls;
-typedef ARRAY(Tile) Bricks;
 typedef ARRAY(uint32_t) Indices;
 typedef ARRAY(Vertex) Vertices;
 
-struct Ball {
-public:
-    Ball(Vector3 position, float radius, Color color,
-         Vector3 velocity, int vcount, Indices indices,
-         Vertices vertices);
-    ~Ball();
+// Thin cache over the binding state the renderers share: program, VAO, buffer
+// targets, storage buffer bindings, 2D textures per unit and the blend and
+// point size switches. Calls that would not change anything are dropped, the
+// rest go through and are counted per frame. Every bind has to go through the
+// cache, and objects are deleted through it too, so a recycled name is never
+// taken for a binding that is still current. The element array binding belongs
+// to the VAO and is forgotten whenever the VAO changes.
+#define STATE_CACHE_TEXTURE_UNITS 4
+#define STATE_CACHE_STORAGE_BINDINGS 4
+#define STATE_CACHE_CAPABILITIES 2 // NOTE: GL_BLEND and GL_PROGRAM_POINT_SIZE
+#define STATE_CACHE_UNKNOWN 0xFFFFFFFFu
+
+enum StateCacheTarget : uint8_t {
+    STATE_ARRAY_BUFFER = 0,
+    STATE_ELEMENT_ARRAY_BUFFER,
+    STATE_COPY_WRITE_BUFFER,
+    STATE_SHADER_STORAGE_BUFFER,
+    STATE_BUFFER_TARGETS,
+};
+
+struct GLStateCache {
+    GLStateCache();
+    void Invalidate(); // NOTE: After anything outside the cache touched the bindings
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vao);
+    void BindBuffer(GLenum target, GLuint buffer);
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void BindTexture(GLuint unit, GLuint texture); // NOTE: GL_TEXTURE_2D
+    void Enable(GLenum capability, bool enabled);
+    void BlendFunc(GLenum source, GLenum destination);
+    void DeleteProgram(GLuint *program);
+    void DeleteVertexArray(GLuint *vao);
+    void DeleteBuffer(GLuint *buffer);
+    void DeleteTexture(GLuint *texture);
+    void EndFrame();
     void stats() const;
-    void GenerateBall();
-    void RenderBall();
-    void UpdateBall();
 
-    Vector3 Position;
-    float Radius;
-    Color color;
-    Vector3 Velocity;
-    int vCount;
-    Indices indices;
-    Vertices vertices;
-    GLuint VBO;
-    GLuint VAO;
-    GLuint EBO;
+    GLuint program;
+    GLuint vao;
+    GLuint buffers[STATE_BUFFER_TARGETS];
+    GLuint storage[STATE_CACHE_STORAGE_BINDINGS];
+    GLuint active_unit;
+    GLuint textures[STATE_CACHE_TEXTURE_UNITS];
+    uint32_t capabilities[STATE_CACHE_CAPABILITIES];
+    GLenum blend_source;
+    GLenum blend_destination;
+    uint32_t frame_changes;
+    uint32_t frame_skipped;
+    uint32_t last_changes; // NOTE: of the last finished frame
+    uint32_t peak_changes;
+    uint64_t frames;
+    uint64_t changes;
+    uint64_t skipped;
 };
 
-struct Tile {
-public:
-    Tile(Vector3 position, Vector3 size, Vector3 velocity, Color color, Indices indices, Vertices vertices);
-    ~Tile();
+// NOTE: One cache for the one context the game renders with
+extern GLStateCache gl_state;
+
+// Shader hot reload. Programs are registered with the files they are built
+// from and a swap function of their owner; when the watch reports one of those
+// files changed, Poll rebuilds the program between frames and hands it to the
+// owner. A program that fails to compile or link, or that the owner refuses,
+// is dropped and the old one stays in use.
+#define SHADER_RELOAD_PATH_LENGTH 128
+
+// NOTE: Takes ownership of `program` and returns true, or returns false and leaves it to the caller
+typedef bool (*ProgramSwapFn)(void *owner, GLuint program);
+
+struct ShaderReloadEntry {
+    char first_path[SHADER_RELOAD_PATH_LENGTH];  // NOTE: vertex or compute shader
+    char second_path[SHADER_RELOAD_PATH_LENGTH]; // NOTE: fragment shader, empty for compute
+    void *owner;
+    ProgramSwapFn swap;
+};
+
+struct ShaderReloader {
+    ShaderReloader();
+    ~ShaderReloader();
+    bool Start(const char *dir);
+    void Add(const char *vertex_path, const char *fragment_path, void *owner, ProgramSwapFn swap);
+    void AddCompute(const char *compute_path, void *owner, ProgramSwapFn swap);
+    void Poll(); // NOTE: Between frames, one atomic load when nothing changed
     void stats() const;
-    void GenerateTile();
-    void RenderTile();
-    void UpdateTile();
 
-    Vector3 Position;
-    Vector3 Size;
-    Vector3 Velocity;
-    Color color;
-    Indices indices;
+    ShaderWatch watch;
+    ARRAY(ShaderReloadEntry) entries;
+    bool started;
+    uint64_t reloads;
+    uint64_t failures;
+};
+
+// Streaming upload ring for per-frame vertex and instance data.
+// One buffer holds STREAM_REGIONS regions; each frame writes into the next
+// region and fences it after the draws, so the CPU only waits if it gets
+// STREAM_REGIONS frames ahead of the GPU. With GL 4.4 the buffer is created
+// with glBufferStorage and stays persistently and coherently mapped, data is
+// written straight into it. Older contexts fall back to a CPU shadow of one
+// region that Commit uploads with glBufferSubData.
+#define STREAM_REGIONS 3
+#define STREAM_ALIGNMENT 64
+
+struct StreamBuffer {
+    StreamBuffer();
+    ~StreamBuffer();
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+    bool Init(uint32_t region_size);
+    void BeginFrame();
+    // NOTE: Growing recreates the buffer, so allocate everything a frame needs before writing any of it
+    void *Allocate(uint32_t size, GLintptr *offset);
+    void Commit(GLintptr offset, uint32_t size);
+    void EndFrame();
+    void stats() const;
+
+    bool Create(uint32_t size);
+    void Destroy();
+    void Wait(uint32_t index);
+
+    GLuint Buffer;
+    GLsync fences[STREAM_REGIONS];
+    uint8_t *mapped; // NOTE: whole ring when persistent, one region's shadow otherwise
+    uint32_t region_size;
+    uint32_t region;
+    uint32_t head; // NOTE: bytes used in the current region
+    bool persistent;
+    uint64_t frames;
+    uint64_t stalls;
+    uint64_t grows;
+};
+
+// NOTE: Collects every quad, sprite and circle of a frame into one growable vertex and
+// index buffer, uploaded once and drawn with one call no matter how many entities there
+// are. Sprites come from one atlas texture, plain quads sample its white texel.
+//
+// Retained quads live on the GPU between frames, one slot per entity. Setting a slot to
+// what it already holds is a no-op, changed slots go up as coalesced ranges with
+// glBufferSubData before the draw, so a frame where nothing moved uploads nothing.
+// Hidden slots are degenerate and draw no pixels.
+#define BATCH_CIRCLE_SEGMENTS 32
+#define BATCH_RETAINED_GAP 4 // NOTE: clean slots re-sent to save a separate upload
+
+struct BatchRenderer {
+    BatchRenderer();
+    ~BatchRenderer();
+    bool Init(GLuint program);
+    bool SwapProgram(GLuint program);
+    void WatchShaders(ShaderReloader *reloader, const char *vertex_path, const char *fragment_path);
+    bool SetAtlas(const Atlas *atlas);
+    void Begin();
+    void PushQuad(float x, float y, float w, float h, Color color);
+    void PushSprite(float x, float y, float w, float h, const AtlasSprite *sprite, Color tint);
+    void PushTexturedQuad(float x, float y, float w, float h, float u0, float v0, float u1, float v1, Color color);
+    void PushCircle(float x, float y, float radius, uint32_t segments, Color color);
+    void ResizeRetained(uint32_t count);
+    void SetRetainedQuad(uint32_t slot, float x, float y, float w, float h, const AtlasSprite *sprite, Color color);
+    void HideRetained(uint32_t slot);
+    void UploadRetained();
+    // NOTE: `model` places every quad of the batch, nullptr for identity
+    void Flush(float aspect_ratio, const Matrix4 *model);
+    void stats() const;
+
+    GLuint VAO;
+    GLuint ProgramId;
+    GLint aspectRatioLoc;
+    GLint modelLoc;
+    GLint atlasLoc;
+    GLuint AtlasTexture;
+    float white_u; // NOTE: center of the atlas' white texel
+    float white_v;
+    StreamBuffer stream; // NOTE: vertices, then indices
     Vertices vertices;
+    Indices indices;
+    GLuint RetainedVBO;
+    GLuint RetainedEBO;
+    Vertex *retained; // NOTE: CPU copy of the GPU buffer, 4 vertices per slot
+    uint32_t retained_count;
+    uint32_t retained_capacity;
+    DirtyTracker retained_dirty;
+    uint64_t frames;
+    uint64_t draw_calls;
+    uint32_t peak_vertices;
+    uint64_t streamed_bytes;
+    uint64_t retained_bytes;
+    uint64_t retained_uploads; // NOTE: glBufferSubData calls
+};
+
+// NOTE: Streams the whole particle pool into one buffer and draws it with one call
+struct ParticleRenderer {
+    ParticleRenderer();
+    ~ParticleRenderer();
+    bool Init(uint32_t capacity);
+    bool SwapProgram(GLuint program);
+    void WatchShaders(ShaderReloader *reloader);
+    void Draw(const ParticlePool *pool, float aspect_ratio);
+
+    GLuint VAO;
+    GLuint ProgramId;
+    GLint aspectRatioLoc;
+    StreamBuffer stream; // NOTE: FillVertices writes straight into it
+    uint32_t capacity;
+};
+
+// NOTE: Every ball is the same unit mesh, built once; a ball is a 16 byte instance.
+// BALL_SDF draws a 4 vertex quad and cuts the circle out in the fragment shader with
+// an anti-aliased signed distance, BALL_MESH draws the BALL_MESH_SEGMENTS triangle fan
+#define BALL_MESH_SEGMENTS 48
+
+enum BallMode : uint8_t {
+    BALL_SDF = 0,
+    BALL_MESH,
+};
+
+struct BallInstance {
+    float x;
+    float y;
+    float radius;
+    uint32_t color; // NOTE: pack_color, RGBA8
+};
+
+typedef ARRAY(BallInstance) BallInstances;
+
+struct BallRenderer {
+    BallRenderer();
+    ~BallRenderer();
+    bool Init(BallMode mode, float pixel_size);
+    bool SwapProgram(GLuint program);
+    void WatchShaders(ShaderReloader *reloader);
+    void Push(float x, float y, float radius, uint32_t color);
+    void Draw(float aspect_ratio);
+    void stats() const;
 
-    GLuint VBO;
     GLuint VAO;
+    GLuint MeshVBO;
     GLuint EBO;
+    GLuint ProgramId;
+    GLint aspectRatioLoc;
+    GLint aaMarginLoc;
+    GLint circleModeLoc;
+    BallMode mode;
+    float pixel_size; // NOTE: one pixel in playfield units, the SDF edge fades over it
+    uint32_t index_count;
+    uint32_t index_first;
+    StreamBuffer stream;
+    BallInstances instances;
+    BallInstances previous; // NOTE: last upload, redrawn in place when nothing moved
+    GLintptr previous_offset;
+    uint64_t uploaded_bytes;
+    uint64_t reused_frames;
+    uint64_t draw_calls;
 };
 
-struct Game {
-    Game();
-    void GameUpdate();
+// Optional GPU backend for stress runs with hundreds of thousands of balls.
+// Ball state lives in a shader storage buffer that a compute shader integrates
+// against the walls, the paddles and a grid of brick indices, and the point
+// sprite pass reads the same buffer, so nothing goes back to the CPU. The
+// balls break their own copy of the brick hit points, uploaded per level.
+// Needs GL 4.3, Mesa llvmpipe is enough (LIBGL_ALWAYS_SOFTWARE=1).
+#define GPU_BALL_GROUP_SIZE 256 // NOTE: local_size_x of shader/ball_physics.comp
+#define GPU_BRICK_GRID 512      // NOTE: cells per side over the whole playfield
 
-    Balls balls;
-    Tile tile;
+struct GpuBall {
+    float x;
+    float y;
+    float vx;
+    float vy;
 };
 
-void BallBounds(Ball *ball);
-void TileBounds(Tile *tile);
+struct GpuBalls {
+    GpuBalls();
+    ~GpuBalls();
+    bool Init(uint32_t capacity, float radius);
+    bool SwapComputeProgram(GLuint program);
+    bool SwapDrawProgram(GLuint program);
+    void WatchShaders(ShaderReloader *reloader);
+    void Spawn(uint32_t count, Rng *rng);
+    void UploadBricks(const Bricks *bricks);
+    void Step(const Game *game, uint32_t ticks);
+    void Draw(float aspect_ratio, float point_size);
+    void stats() const;
+
+    GLuint ComputeProgramId;
+    GLuint DrawProgramId;
+    GLuint VAO;
+    GLuint BallBuffer;
+    GLuint RectBuffer;
+    GLuint HpBuffer;
+    GLuint GridBuffer;
+    GLint ballCountLoc;
+    GLint ticksLoc;
+    GLint radiusLoc;
+    GLint dtLoc;
+    GLint gridSizeLoc;
+    GLint paddleCountLoc;
+    GLint paddlesLoc;
+    GLint aspectRatioLoc;
+    GLint pointSizeLoc;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t brick_count;
+    float radius;
+    uint64_t dispatches;
+    uint64_t ticks;
+};
 
 // Opengl Shader Related Functions
-char *read_file(const char *file_path, uint8_t *size);
 bool log_shader_error(GLuint Id);
 bool log_program_error(GLuint Id);
-GLuint compile_vertex(char *vertex_code);
-GLuint compile_fragment(char *fragment_code);
+GLuint compile_vertex(const char *vertex_code);
+GLuint compile_fragment(const char *fragment_code);
 GLuint LoadShader(const char *vertex_file_path, const char *fragment_file_path);
+GLuint compile_compute(const char *compute_code);
+GLuint LoadComputeShader(const char *compute_file_path);
+// NOTE: Linked programs are cached as driver binaries in `dir`, nullptr turns the cache off
+void SetShaderCacheDir(const char *dir);
+void ShaderCacheStats();
 void calculate_fps(double *last_time, double *frame_count);
 
 // Helper Functions
-static inline int randomNumber()
+static inline int randomNumber(Rng *rng)
 {
     int min = 1;
     int max = 3;
-    return (rand() % (max - min + 1)) + min;
+    return min + (int)rng->Below(max - min + 1);
 }
 
 
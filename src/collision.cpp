@@ -0,0 +1,362 @@
+#include "./collision.hpp"
+#include "./game.hpp"
+
+#include <cmath>
+#include <cassert>
+#include <cfloat>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define NO_CONTACT INFINITY
+
+static uint32_t aabb_pack_columns(AabbPack *pack, SoAColumn *out)
+{
+    out[0] = {(void**)&pack->min_x, sizeof(float)};
+    out[1] = {(void**)&pack->min_y, sizeof(float)};
+    out[2] = {(void**)&pack->max_x, sizeof(float)};
+    out[3] = {(void**)&pack->max_y, sizeof(float)};
+    out[4] = {(void**)&pack->ids, sizeof(uint32_t)};
+    return 5;
+}
+
+void aabb_pack_clear(AabbPack *pack)
+{
+    pack->count = 0;
+}
+
+void aabb_pack_push(AabbPack *pack, float min_x, float min_y, float max_x, float max_y, uint32_t id)
+{
+    if (pack->count >= pack->capacity) {
+        SoAColumn columns[5];
+        uint32_t n = aabb_pack_columns(pack, columns);
+        soa_reserve(columns, n, &pack->capacity, &pack->borrowed, pack->count, pack->count + 1);
+    }
+    uint32_t i = pack->count++;
+    pack->min_x[i] = min_x;
+    pack->min_y[i] = min_y;
+    pack->max_x[i] = max_x;
+    pack->max_y[i] = max_y;
+    pack->ids[i] = id;
+}
+
+void aabb_pack_free(AabbPack *pack)
+{
+    SoAColumn columns[5];
+    uint32_t n = aabb_pack_columns(pack, columns);
+    soa_free(columns, n, false);
+    *pack = {};
+}
+
+// NOTE: Same semantics as minps/maxps, so the scalar and SIMD paths round identically
+static inline float min_f(float a, float b) { return a < b ? a : b; }
+static inline float max_f(float a, float b) { return a > b ? a : b; }
+
+// NOTE: Sort key of one box: -depth for overlaps, t for swept hits, NO_CONTACT otherwise.
+// a = dx*dx + dy*dy and inv_d* = 1/d* are hoisted by the caller.
+// Every operation here is mirrored lane for lane in circle_vs_aabbs_sse.
+static inline float contact_key(float cx, float cy, float r, float r2, float dx, float dy,
+                                float a, float inv_dx, float inv_dy,
+                                float min_x, float min_y, float max_x, float max_y)
+{
+    float qx = min_f(max_f(cx, min_x), max_x);
+    float qy = min_f(max_f(cy, min_y), max_y);
+    float ex = cx - qx;
+    float ey = cy - qy;
+    float dist2 = ex*ex + ey*ey;
+    if (dist2 < r2) {
+        float depth;
+        if (dist2 > 0.0f) depth = r - sqrtf(dist2);
+        else depth = r + min_f(min_f(cx - min_x, max_x - cx), min_f(cy - min_y, max_y - cy));
+        return -depth;
+    }
+    if (!(a > 0.0f)) return NO_CONTACT;
+
+    // NOTE: Slabs of the box grown by r
+    float x0 = min_x - r;
+    float x1 = max_x + r;
+    float y0 = min_y - r;
+    float y1 = max_y + r;
+
+    float tx_enter = -INFINITY, tx_exit = INFINITY;
+    if (dx != 0.0f) {
+        float t0 = (x0 - cx) * inv_dx;
+        float t1 = (x1 - cx) * inv_dx;
+        tx_enter = min_f(t0, t1);
+        tx_exit = max_f(t0, t1);
+    } else if (cx < x0 || cx > x1) {
+        return NO_CONTACT;
+    }
+
+    float ty_enter = -INFINITY, ty_exit = INFINITY;
+    if (dy != 0.0f) {
+        float t0 = (y0 - cy) * inv_dy;
+        float t1 = (y1 - cy) * inv_dy;
+        ty_enter = min_f(t0, t1);
+        ty_exit = max_f(t0, t1);
+    } else if (cy < y0 || cy > y1) {
+        return NO_CONTACT;
+    }
+
+    float t_enter = max_f(tx_enter, ty_enter);
+    float t_exit = min_f(tx_exit, ty_exit);
+    if (!(t_enter <= t_exit) || t_exit < 0.0f || t_enter > 1.0f) return NO_CONTACT;
+    t_enter = max_f(t_enter, 0.0f);
+
+    // NOTE: Entering through a corner of the grown box only counts if the rounded corner is hit
+    float px = cx + t_enter*dx;
+    float py = cy + t_enter*dy;
+    bool corner = (px < min_x || px > max_x) && (py < min_y || py > max_y);
+    if (!corner) return t_enter;
+
+    float kx = px < min_x ? min_x : max_x;
+    float ky = py < min_y ? min_y : max_y;
+    float mx = cx - kx;
+    float my = cy - ky;
+    float b = mx*dx + my*dy;
+    float c = mx*mx + my*my - r2;
+    float disc = b*b - a*c;
+    if (!(disc >= 0.0f) || !(b < 0.0f)) return NO_CONTACT;
+    float t = (-b - sqrtf(disc)) / a;
+    if (t > 1.0f) return NO_CONTACT;
+    return max_f(t, 0.0f);
+}
+
+bool CircleVsAabb(float cx, float cy, float r, float dx, float dy,
+                  float min_x, float min_y, float max_x, float max_y, Contact *contact)
+{
+    float a = dx*dx + dy*dy;
+    float inv_dx = 1.0f / dx;
+    float inv_dy = 1.0f / dy;
+    float key = contact_key(cx, cy, r, r*r, dx, dy, a, inv_dx, inv_dy, min_x, min_y, max_x, max_y);
+    if (key == NO_CONTACT) return false;
+
+    contact->index = 0;
+    contact->id = 0;
+    if (key < 0.0f) {
+        // NOTE: Already overlapping
+        contact->t = 0.0f;
+        contact->depth = -key;
+        float ex = cx - min_f(max_f(cx, min_x), max_x);
+        float ey = cy - min_f(max_f(cy, min_y), max_y);
+        float dist2 = ex*ex + ey*ey;
+        if (dist2 > 0.0f) {
+            float dist = sqrtf(dist2);
+            contact->nx = ex / dist;
+            contact->ny = ey / dist;
+        } else {
+            // NOTE: Center inside the box, push out through the closest face
+            float left = cx - min_x, right = max_x - cx;
+            float bottom = cy - min_y, top = max_y - cy;
+            float best = min_f(min_f(left, right), min_f(bottom, top));
+            contact->nx = best == left ? -1.0f : (best == right ? 1.0f : 0.0f);
+            contact->ny = contact->nx != 0.0f ? 0.0f : (best == bottom ? -1.0f : 1.0f);
+        }
+        return true;
+    }
+
+    contact->t = key;
+    contact->depth = 0.0f;
+    float px = cx + key*dx;
+    float py = cy + key*dy;
+    bool corner = (px < min_x || px > max_x) && (py < min_y || py > max_y);
+    if (corner) {
+        float ex = px - (px < min_x ? min_x : max_x);
+        float ey = py - (py < min_y ? min_y : max_y);
+        float len = sqrtf(ex*ex + ey*ey);
+        contact->nx = ex / len;
+        contact->ny = ey / len;
+        return true;
+    }
+
+    // NOTE: Face hit, the normal is the axis whose slab was entered last
+    float tx = dx != 0.0f ? min_f((min_x - r - cx) * inv_dx, (max_x + r - cx) * inv_dx) : -INFINITY;
+    float ty = dy != 0.0f ? min_f((min_y - r - cy) * inv_dy, (max_y + r - cy) * inv_dy) : -INFINITY;
+    if (tx > ty) {
+        contact->nx = dx > 0.0f ? -1.0f : 1.0f;
+        contact->ny = 0.0f;
+    } else {
+        contact->nx = 0.0f;
+        contact->ny = dy > 0.0f ? -1.0f : 1.0f;
+    }
+    return true;
+}
+
+static bool finish_contact(float cx, float cy, float r, float dx, float dy, const AabbPack *pack,
+                           uint32_t best, float best_key, Contact *contact)
+{
+    if (best_key == NO_CONTACT) return false;
+    bool hit = CircleVsAabb(cx, cy, r, dx, dy, pack->min_x[best], pack->min_y[best],
+                            pack->max_x[best], pack->max_y[best], contact);
+    assert(hit);
+    contact->index = best;
+    contact->id = pack->ids[best];
+    return hit;
+}
+
+bool CircleVsAabbsScalar(float cx, float cy, float r, float dx, float dy, const AabbPack *pack, Contact *contact)
+{
+    float a = dx*dx + dy*dy;
+    float inv_dx = 1.0f / dx;
+    float inv_dy = 1.0f / dy;
+    float r2 = r*r;
+
+    float best_key = NO_CONTACT;
+    uint32_t best = 0;
+    for (uint32_t i = 0; i < pack->count; ++i) {
+        float key = contact_key(cx, cy, r, r2, dx, dy, a, inv_dx, inv_dy,
+                                pack->min_x[i], pack->min_y[i], pack->max_x[i], pack->max_y[i]);
+        if (key < best_key) {
+            best_key = key;
+            best = i;
+        }
+    }
+    return finish_contact(cx, cy, r, dx, dy, pack, best, best_key, contact);
+}
+
+#ifdef __SSE2__
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// NOTE: Four boxes per iteration, lane for lane the same operations as contact_key
+static void circle_vs_aabbs_sse(float cx, float cy, float r, float dx, float dy, const AabbPack *pack,
+                                uint32_t *best_out, float *best_key_out, uint32_t *done)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 inf = _mm_set1_ps(INFINITY);
+    const __m128 ninf = _mm_set1_ps(-INFINITY);
+    const __m128 vcx = _mm_set1_ps(cx);
+    const __m128 vcy = _mm_set1_ps(cy);
+    const __m128 vr = _mm_set1_ps(r);
+    const __m128 vr2 = _mm_set1_ps(r*r);
+    const __m128 vdx = _mm_set1_ps(dx);
+    const __m128 vdy = _mm_set1_ps(dy);
+    const float a = dx*dx + dy*dy;
+    const __m128 va = _mm_set1_ps(a);
+    const __m128 vinv_dx = _mm_set1_ps(1.0f / dx);
+    const __m128 vinv_dy = _mm_set1_ps(1.0f / dy);
+    const __m128 moving = a > 0.0f ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero;
+    const __m128 dx_zero = _mm_cmpeq_ps(vdx, zero);
+    const __m128 dy_zero = _mm_cmpeq_ps(vdy, zero);
+
+    __m128 best_key = inf;
+    __m128i best_index = _mm_setzero_si128();
+    __m128i index = _mm_set_epi32(3, 2, 1, 0);
+    const __m128i four = _mm_set1_epi32(4);
+
+    uint32_t i = 0;
+    for (; i + 4 <= pack->count; i += 4) {
+        __m128 min_x = _mm_load_ps(pack->min_x + i);
+        __m128 min_y = _mm_load_ps(pack->min_y + i);
+        __m128 max_x = _mm_load_ps(pack->max_x + i);
+        __m128 max_y = _mm_load_ps(pack->max_y + i);
+
+        // Static overlap
+        __m128 qx = _mm_min_ps(_mm_max_ps(vcx, min_x), max_x);
+        __m128 qy = _mm_min_ps(_mm_max_ps(vcy, min_y), max_y);
+        __m128 ex = _mm_sub_ps(vcx, qx);
+        __m128 ey = _mm_sub_ps(vcy, qy);
+        __m128 dist2 = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+        __m128 overlap = _mm_cmplt_ps(dist2, vr2);
+        __m128 depth_out = _mm_sub_ps(vr, _mm_sqrt_ps(dist2));
+        __m128 depth_in = _mm_add_ps(vr, _mm_min_ps(_mm_min_ps(_mm_sub_ps(vcx, min_x), _mm_sub_ps(max_x, vcx)),
+                                                    _mm_min_ps(_mm_sub_ps(vcy, min_y), _mm_sub_ps(max_y, vcy))));
+        __m128 depth = select_ps(_mm_cmpgt_ps(dist2, zero), depth_out, depth_in);
+        __m128 key_static = _mm_xor_ps(depth, sign);
+
+        // Swept, slabs of the box grown by r
+        __m128 x0 = _mm_sub_ps(min_x, vr);
+        __m128 x1 = _mm_add_ps(max_x, vr);
+        __m128 y0 = _mm_sub_ps(min_y, vr);
+        __m128 y1 = _mm_add_ps(max_y, vr);
+
+        __m128 tx0 = _mm_mul_ps(_mm_sub_ps(x0, vcx), vinv_dx);
+        __m128 tx1 = _mm_mul_ps(_mm_sub_ps(x1, vcx), vinv_dx);
+        __m128 tx_enter = select_ps(dx_zero, ninf, _mm_min_ps(tx0, tx1));
+        __m128 tx_exit = select_ps(dx_zero, inf, _mm_max_ps(tx0, tx1));
+        __m128 x_outside = _mm_and_ps(dx_zero, _mm_or_ps(_mm_cmplt_ps(vcx, x0), _mm_cmpgt_ps(vcx, x1)));
+
+        __m128 ty0 = _mm_mul_ps(_mm_sub_ps(y0, vcy), vinv_dy);
+        __m128 ty1 = _mm_mul_ps(_mm_sub_ps(y1, vcy), vinv_dy);
+        __m128 ty_enter = select_ps(dy_zero, ninf, _mm_min_ps(ty0, ty1));
+        __m128 ty_exit = select_ps(dy_zero, inf, _mm_max_ps(ty0, ty1));
+        __m128 y_outside = _mm_and_ps(dy_zero, _mm_or_ps(_mm_cmplt_ps(vcy, y0), _mm_cmpgt_ps(vcy, y1)));
+
+        __m128 t_enter = _mm_max_ps(tx_enter, ty_enter);
+        __m128 t_exit = _mm_min_ps(tx_exit, ty_exit);
+        __m128 swept = _mm_and_ps(moving, _mm_cmple_ps(t_enter, t_exit));
+        swept = _mm_andnot_ps(_mm_or_ps(x_outside, y_outside), swept);
+        swept = _mm_andnot_ps(_mm_or_ps(_mm_cmplt_ps(t_exit, zero), _mm_cmpgt_ps(t_enter, one)), swept);
+        t_enter = _mm_max_ps(t_enter, zero);
+
+        // Rounded corners
+        __m128 px = _mm_add_ps(vcx, _mm_mul_ps(t_enter, vdx));
+        __m128 py = _mm_add_ps(vcy, _mm_mul_ps(t_enter, vdy));
+        __m128 left = _mm_cmplt_ps(px, min_x);
+        __m128 below = _mm_cmplt_ps(py, min_y);
+        __m128 corner = _mm_and_ps(_mm_or_ps(left, _mm_cmpgt_ps(px, max_x)),
+                                   _mm_or_ps(below, _mm_cmpgt_ps(py, max_y)));
+        __m128 kx = select_ps(left, min_x, max_x);
+        __m128 ky = select_ps(below, min_y, max_y);
+        __m128 mx = _mm_sub_ps(vcx, kx);
+        __m128 my = _mm_sub_ps(vcy, ky);
+        __m128 b = _mm_add_ps(_mm_mul_ps(mx, vdx), _mm_mul_ps(my, vdy));
+        __m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(mx, mx), _mm_mul_ps(my, my)), vr2);
+        __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(va, c));
+        __m128 corner_hit = _mm_and_ps(_mm_cmpge_ps(disc, zero), _mm_cmplt_ps(b, zero));
+        __m128 tc = _mm_div_ps(_mm_sub_ps(_mm_xor_ps(b, sign), _mm_sqrt_ps(disc)), va);
+        corner_hit = _mm_andnot_ps(_mm_cmpgt_ps(tc, one), corner_hit);
+        tc = _mm_max_ps(tc, zero);
+
+        __m128 key_swept = select_ps(corner, select_ps(corner_hit, tc, inf), t_enter);
+        key_swept = select_ps(swept, key_swept, inf);
+        __m128 key = select_ps(overlap, key_static, key_swept);
+
+        __m128 better = _mm_cmplt_ps(key, best_key);
+        best_key = select_ps(better, key, best_key);
+        best_index = _mm_castps_si128(select_ps(better, _mm_castsi128_ps(index), _mm_castsi128_ps(best_index)));
+        index = _mm_add_epi32(index, four);
+    }
+
+    // NOTE: Horizontal reduction, smallest key then smallest index like the scalar loop
+    float keys[4];
+    uint32_t indices[4];
+    _mm_storeu_ps(keys, best_key);
+    _mm_storeu_si128((__m128i*)indices, best_index);
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        if (keys[lane] < *best_key_out || (keys[lane] == *best_key_out && keys[lane] != NO_CONTACT && indices[lane] < *best_out)) {
+            *best_key_out = keys[lane];
+            *best_out = indices[lane];
+        }
+    }
+    *done = i;
+}
+#endif
+
+bool CircleVsAabbs(float cx, float cy, float r, float dx, float dy, const AabbPack *pack, Contact *contact)
+{
+    float best_key = NO_CONTACT;
+    uint32_t best = 0;
+    uint32_t i = 0;
+#ifdef __SSE2__
+    circle_vs_aabbs_sse(cx, cy, r, dx, dy, pack, &best, &best_key, &i);
+#endif
+
+    float a = dx*dx + dy*dy;
+    float inv_dx = 1.0f / dx;
+    float inv_dy = 1.0f / dy;
+    float r2 = r*r;
+    for (; i < pack->count; ++i) {
+        float key = contact_key(cx, cy, r, r2, dx, dy, a, inv_dx, inv_dy,
+                                pack->min_x[i], pack->min_y[i], pack->max_x[i], pack->max_y[i]);
+        if (key < best_key) {
+            best_key = key;
+            best = i;
+        }
+    }
+    return finish_contact(cx, cy, r, dx, dy, pack, best, best_key, contact);
+}
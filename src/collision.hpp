@@ -0,0 +1,46 @@
+#ifndef COLLISION_H_
+#define COLLISION_H_
+
+#include <cstdint>
+
+// Circle vs AABB narrowphase.
+//
+// A ball (center c, radius r) moving by d over the step is tested against a
+// packed array of candidate boxes:
+//   - boxes the circle already overlaps are contacts at t = 0 with a
+//     penetration depth (deepest wins),
+//   - otherwise the earliest t in [0, 1] where the moving circle touches a
+//     box (faces and rounded corners are exact) wins, with depth 0.
+// Ties go to the lowest pack index. The SIMD kernel and the scalar reference
+// compute bit-identical sort keys, so they always pick the same box.
+
+struct AabbPack {
+    float *min_x;
+    float *min_y;
+    float *max_x;
+    float *max_y;
+    uint32_t *ids; // NOTE: caller defined, e.g. the brick index
+    uint32_t count;
+    uint32_t capacity;
+    bool borrowed; // NOTE: always false, needed by soa_reserve
+};
+
+struct Contact {
+    uint32_t index; // NOTE: index into the pack
+    uint32_t id;
+    float t;
+    float nx; // NOTE: unit normal pointing from the box towards the ball
+    float ny;
+    float depth;
+};
+
+void aabb_pack_clear(AabbPack *pack);
+void aabb_pack_push(AabbPack *pack, float min_x, float min_y, float max_x, float max_y, uint32_t id);
+void aabb_pack_free(AabbPack *pack);
+
+bool CircleVsAabb(float cx, float cy, float r, float dx, float dy,
+                  float min_x, float min_y, float max_x, float max_y, Contact *contact);
+bool CircleVsAabbsScalar(float cx, float cy, float r, float dx, float dy, const AabbPack *pack, Contact *contact);
+bool CircleVsAabbs(float cx, float cy, float r, float dx, float dy, const AabbPack *pack, Contact *contact);
+
+#endif // COLLISION_H_
@@ -0,0 +1,74 @@
+#include "./dirty.hpp"
+
+DirtyTracker::DirtyTracker():
+    bits(nullptr), count(0), low(1), high(0), ranges({nullptr, 0, 0})
+{}
+
+DirtyTracker::~DirtyTracker()
+{
+    free(bits);
+    array_delete(&ranges);
+}
+
+void DirtyTracker::Resize(uint32_t slots)
+{
+    uint32_t words = (slots + 63) / 64;
+    bits = (uint64_t*)realloc(bits, (words > 0 ? words : 1) * sizeof(uint64_t));
+    assert(bits != nullptr && "Memory Reallocation For Dirty Bits Failed.");
+    count = slots;
+    MarkAll();
+}
+
+void DirtyTracker::Mark(uint32_t slot)
+{
+    assert(slot < count);
+    bits[slot / 64] |= 1ull << (slot % 64);
+    if (!Dirty()) {
+        low = slot;
+        high = slot;
+    } else if (slot < low) {
+        low = slot;
+    } else if (slot > high) {
+        high = slot;
+    }
+}
+
+void DirtyTracker::MarkAll()
+{
+    if (count == 0) return;
+    uint32_t words = (count + 63) / 64;
+    memset(bits, 0xFF, words * sizeof(uint64_t));
+    // NOTE: Bits past the last slot stay clear so Collect never reports them
+    if (count % 64) bits[words - 1] = (1ull << (count % 64)) - 1;
+    low = 0;
+    high = count - 1;
+}
+
+uint32_t DirtyTracker::Collect(uint32_t max_gap)
+{
+    ranges.count = 0;
+    if (!Dirty()) return 0;
+
+    DirtyRange current = {0, 0};
+    bool open = false;
+    for (uint32_t word = low / 64; word <= high / 64; ++word) {
+        uint64_t w = bits[word];
+        bits[word] = 0;
+        while (w) {
+            uint32_t slot = word * 64 + (uint32_t)__builtin_ctzll(w);
+            w &= w - 1;
+            if (open && slot - (current.first + current.count) <= max_gap) {
+                current.count = slot - current.first + 1;
+            } else {
+                if (open) array_append(DirtyRange, &ranges, current);
+                current.first = slot;
+                current.count = 1;
+                open = true;
+            }
+        }
+    }
+    if (open) array_append(DirtyRange, &ranges, current);
+    low = 1;
+    high = 0;
+    return ranges.count;
+}
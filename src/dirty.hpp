@@ -0,0 +1,43 @@
+#ifndef DIRTY_H_
+#define DIRTY_H_
+
+#include <cstdint>
+
+#include "../util/array.h"
+
+// Per-entity change tracking for retained GPU buffers.
+//
+// Entities mark their slot when their data changes; Collect turns the marks
+// into sorted slot ranges, merging ranges separated by at most `max_gap`
+// clean slots, since one slightly larger upload is cheaper than two calls.
+// Marks live in a bitset bounded by the lowest and highest marked slot, so a
+// frame where nothing changed costs one branch.
+
+struct DirtyRange {
+    uint32_t first;
+    uint32_t count;
+};
+
+typedef ARRAY(DirtyRange) DirtyRanges;
+
+struct DirtyTracker {
+    DirtyTracker();
+    ~DirtyTracker();
+    DirtyTracker(const DirtyTracker&) = delete;
+    DirtyTracker& operator=(const DirtyTracker&) = delete;
+
+    void Resize(uint32_t count); // NOTE: every slot starts dirty
+    void Mark(uint32_t slot);
+    void MarkAll();
+    // NOTE: Fills `ranges` and clears the marks, returns the number of ranges
+    uint32_t Collect(uint32_t max_gap);
+    bool Dirty() const { return low <= high; }
+
+    uint64_t *bits;
+    uint32_t count;
+    uint32_t low;  // NOTE: lowest marked slot, > high when clean
+    uint32_t high;
+    DirtyRanges ranges;
+};
+
+#endif // DIRTY_H_
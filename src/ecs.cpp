@@ -0,0 +1,211 @@
+#include "./ecs.hpp"
+
+const uint32_t component_sizes[COMPONENT_COUNT] = {
+    sizeof(Transform),
+    sizeof(Velocity),
+    sizeof(Collider),
+    sizeof(Renderable),
+    sizeof(BrickHealth),
+};
+
+// NOTE: Column list of an archetype in component order, entity ids last
+static uint32_t archetype_columns(Archetype *archetype, SoAColumn *out)
+{
+    uint32_t n = 0;
+    for (uint32_t id = 0; id < COMPONENT_COUNT; ++id) {
+        if (archetype->mask & COMPONENT_BIT(id)) {
+            out[n++] = {&archetype->columns[id], component_sizes[id]};
+        }
+    }
+    out[n++] = {(void**)&archetype->entities, sizeof(Entity)};
+    return n;
+}
+
+static uint32_t find_archetype(World *world, ComponentMask mask)
+{
+    for (uint32_t i = 0; i < world->archetypes.count; ++i) {
+        if (world->archetypes.items[i].mask == mask) return i;
+    }
+
+    Archetype archetype = {};
+    archetype.mask = mask;
+    array_append(Archetype, &world->archetypes, archetype);
+    return world->archetypes.count - 1;
+}
+
+// NOTE: Appends an uninitialized row and returns its index
+static uint32_t archetype_push(Archetype *archetype, Entity entity)
+{
+    SoAColumn columns[COMPONENT_COUNT + 1];
+    uint32_t n = archetype_columns(archetype, columns);
+    soa_reserve(columns, n, &archetype->capacity, &archetype->borrowed, archetype->count, archetype->count + 1);
+
+    uint32_t row = archetype->count++;
+    archetype->entities[row] = entity;
+    for (uint32_t id = 0; id < COMPONENT_COUNT; ++id) {
+        if (archetype->columns[id]) {
+            memset((char*)archetype->columns[id] + (size_t)row * component_sizes[id], 0, component_sizes[id]);
+        }
+    }
+    return row;
+}
+
+// NOTE: Swap-remove, keeps the columns dense. Returns the entity moved into `row` (or ENTITY_NONE)
+static Entity archetype_remove(Archetype *archetype, uint32_t row)
+{
+    uint32_t last = --archetype->count;
+    if (row == last) return ENTITY_NONE;
+
+    for (uint32_t id = 0; id < COMPONENT_COUNT; ++id) {
+        if (archetype->columns[id]) {
+            uint32_t size = component_sizes[id];
+            char *column = (char*)archetype->columns[id];
+            memcpy(column + (size_t)row * size, column + (size_t)last * size, size);
+        }
+    }
+    archetype->entities[row] = archetype->entities[last];
+    return archetype->entities[row];
+}
+
+World::World():
+    archetypes(), records(), free_records(), alive_count(0)
+{}
+
+World::~World()
+{
+    for (uint32_t i = 0; i < archetypes.count; ++i) {
+        Archetype *archetype = &archetypes.items[i];
+        SoAColumn columns[COMPONENT_COUNT + 1];
+        uint32_t n = archetype_columns(archetype, columns);
+        soa_free(columns, n, false);
+    }
+    array_delete(&archetypes);
+    array_delete(&records);
+    array_delete(&free_records);
+}
+
+Entity World::Create(ComponentMask mask)
+{
+    uint32_t index;
+    if (free_records.count > 0) {
+        index = free_records.items[free_records.count - 1];
+        array_pop(&free_records);
+    } else {
+        assert(records.count < 0x00FFFFFFu && "Too many entities");
+        EntityRecord record = {};
+        array_append(EntityRecord, &records, record);
+        index = records.count - 1;
+    }
+
+    EntityRecord *record = &records.items[index];
+    Entity entity = ((Entity)record->generation << 24) | index;
+    record->archetype = find_archetype(this, mask);
+    record->row = archetype_push(&archetypes.items[record->archetype], entity);
+    record->alive = true;
+    alive_count++;
+    return entity;
+}
+
+bool World::Alive(Entity entity) const
+{
+    uint32_t index = ENTITY_INDEX(entity);
+    if (entity == ENTITY_NONE || index >= records.count) return false;
+    const EntityRecord *record = &records.items[index];
+    return record->alive && record->generation == ENTITY_GENERATION(entity);
+}
+
+void World::Destroy(Entity entity)
+{
+    if (!Alive(entity)) return;
+
+    EntityRecord *record = &records.items[ENTITY_INDEX(entity)];
+    Entity moved = archetype_remove(&archetypes.items[record->archetype], record->row);
+    if (moved != ENTITY_NONE) records.items[ENTITY_INDEX(moved)].row = record->row;
+
+    record->alive = false;
+    record->generation++;
+    array_append(uint32_t, &free_records, ENTITY_INDEX(entity));
+    alive_count--;
+}
+
+void *World::Get(Entity entity, ComponentId id)
+{
+    if (!Alive(entity)) return nullptr;
+    const EntityRecord *record = &records.items[ENTITY_INDEX(entity)];
+    char *column = (char*)archetypes.items[record->archetype].columns[id];
+    if (column == nullptr) return nullptr;
+    return column + (size_t)record->row * component_sizes[id];
+}
+
+void World::SetComponents(Entity entity, ComponentMask mask)
+{
+    if (!Alive(entity)) return;
+
+    EntityRecord *record = &records.items[ENTITY_INDEX(entity)];
+    if (archetypes.items[record->archetype].mask == mask) return;
+
+    // NOTE: find_archetype may grow the archetype array, look the source up afterwards
+    uint32_t target_index = find_archetype(this, mask);
+    Archetype *source = &archetypes.items[record->archetype];
+    Archetype *target = &archetypes.items[target_index];
+
+    uint32_t row = archetype_push(target, entity);
+    for (uint32_t id = 0; id < COMPONENT_COUNT; ++id) {
+        if (source->columns[id] && target->columns[id]) {
+            uint32_t size = component_sizes[id];
+            memcpy((char*)target->columns[id] + (size_t)row * size,
+                   (char*)source->columns[id] + (size_t)record->row * size, size);
+        }
+    }
+
+    Entity moved = archetype_remove(source, record->row);
+    if (moved != ENTITY_NONE) records.items[ENTITY_INDEX(moved)].row = record->row;
+    record->archetype = target_index;
+    record->row = row;
+}
+
+Query World::Each(ComponentMask mask)
+{
+    return {this, mask, 0};
+}
+
+// NOTE: Yields one chunk per non-empty archetype that has every component in the mask
+bool Query::Next(QueryChunk *chunk)
+{
+    while (archetype < world->archetypes.count) {
+        Archetype *current = &world->archetypes.items[archetype++];
+        if ((current->mask & mask) != mask || current->count == 0) continue;
+
+        for (uint32_t id = 0; id < COMPONENT_COUNT; ++id) {
+            chunk->columns[id] = (mask & COMPONENT_BIT(id)) ? current->columns[id] : nullptr;
+        }
+        chunk->entities = current->entities;
+        chunk->count = current->count;
+        return true;
+    }
+    return false;
+}
+
+void World::stats() const
+{
+    printf("World Info: \n");
+    printf("    Entities: %u (records %u, free %u)\n", alive_count, records.count, free_records.count);
+    for (uint32_t i = 0; i < archetypes.count; ++i) {
+        const Archetype *archetype = &archetypes.items[i];
+        printf("    Archetype 0x%02x: %u entities (capacity %u)\n", archetype->mask, archetype->count, archetype->capacity);
+    }
+}
+
+void IntegrateSystem(World *world, float dt)
+{
+    Query query = world->Each(COMPONENT_BIT(COMPONENT_TRANSFORM) | COMPONENT_BIT(COMPONENT_VELOCITY));
+    QueryChunk chunk;
+    while (query.Next(&chunk)) {
+        Transform *transforms = (Transform*)chunk.columns[COMPONENT_TRANSFORM];
+        const Velocity *velocities = (const Velocity*)chunk.columns[COMPONENT_VELOCITY];
+        for (uint32_t i = 0; i < chunk.count; ++i) {
+            transforms[i].x += velocities[i].x * dt;
+            transforms[i].y += velocities[i].y * dt;
+        }
+    }
+}
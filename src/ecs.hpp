@@ -0,0 +1,123 @@
+#ifndef ECS_H_
+#define ECS_H_
+
+#include "./game.hpp"
+#include "../util/array.h"
+
+// Archetype based entity storage. Entities with the same set of components
+// share an archetype, which keeps one contiguous column per component, so a
+// query only walks the columns it asks for.
+
+enum ComponentId {
+    COMPONENT_TRANSFORM,
+    COMPONENT_VELOCITY,
+    COMPONENT_COLLIDER,
+    COMPONENT_RENDERABLE,
+    COMPONENT_BRICK_HEALTH,
+    COMPONENT_COUNT
+};
+
+typedef uint32_t ComponentMask;
+#define COMPONENT_BIT(id) ((ComponentMask)1 << (id))
+
+struct Transform {
+    float x;
+    float y;
+    float rotation; // NOTE: degrees
+    float scale;
+};
+
+struct Velocity {
+    float x;
+    float y;
+};
+
+enum ColliderShape : uint8_t {
+    COLLIDER_CIRCLE,
+    COLLIDER_BOX,
+};
+
+struct Collider {
+    float half_w; // NOTE: radius for circles
+    float half_h;
+    ColliderShape shape;
+};
+
+struct Renderable {
+    float color[4];
+    uint32_t mesh;
+};
+
+struct BrickHealth {
+    uint8_t hp;
+    uint8_t type;
+};
+
+// NOTE: Low 24 bits index the record table, high 8 bits are the generation
+typedef uint32_t Entity;
+#define ENTITY_NONE 0xFFFFFFFFu
+#define ENTITY_INDEX(e) ((e) & 0x00FFFFFFu)
+#define ENTITY_GENERATION(e) ((e) >> 24)
+
+struct Archetype {
+    ComponentMask mask;
+    void *columns[COMPONENT_COUNT]; // NOTE: nullptr for components not in mask
+    Entity *entities;
+    uint32_t count;
+    uint32_t capacity;
+    bool borrowed; // NOTE: always false, needed by soa_reserve
+};
+
+struct EntityRecord {
+    uint32_t archetype;
+    uint32_t row;
+    uint8_t generation;
+    bool alive;
+};
+
+struct QueryChunk {
+    void *columns[COMPONENT_COUNT];
+    const Entity *entities;
+    uint32_t count;
+};
+
+struct World;
+
+struct Query {
+    bool Next(QueryChunk *chunk);
+
+    World *world;
+    ComponentMask mask;
+    uint32_t archetype;
+};
+
+typedef ARRAY(Archetype) Archetypes;
+typedef ARRAY(EntityRecord) EntityRecords;
+typedef ARRAY(uint32_t) RecordIndices;
+
+struct World {
+    World();
+    ~World();
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    Entity Create(ComponentMask mask);
+    void Destroy(Entity entity);
+    bool Alive(Entity entity) const;
+    void *Get(Entity entity, ComponentId id);
+    void SetComponents(Entity entity, ComponentMask mask); // NOTE: moves the entity to another archetype
+    Query Each(ComponentMask mask);
+    void stats() const;
+
+    Archetypes archetypes;
+    EntityRecords records;
+    RecordIndices free_records;
+    uint32_t alive_count;
+};
+
+extern const uint32_t component_sizes[COMPONENT_COUNT];
+
+// Systems
+void IntegrateSystem(World *world, float dt);
+
+#endif // ECS_H_
@@ -0,0 +1,157 @@
+#include "./events.hpp"
+
+#include <cstdio>
+
+EventSim::EventSim():
+    heap(), next_tick(), valid(false), last_tick(0), ball_ticks(0), events(0)
+{}
+
+EventSim::~EventSim()
+{
+    array_delete(&heap);
+    array_delete(&next_tick);
+}
+
+void EventSim::Invalidate()
+{
+    valid = false;
+}
+
+static inline bool event_before(const ImpactEvent *a, const ImpactEvent *b)
+{
+    return a->tick < b->tick || (a->tick == b->tick && a->ball < b->ball);
+}
+
+static void heap_push(ImpactHeap *heap, uint64_t tick, uint32_t ball)
+{
+    ImpactEvent event = {tick, ball};
+    array_append(ImpactEvent, heap, event);
+    uint32_t i = heap->count - 1;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!event_before(&heap->items[i], &heap->items[parent])) break;
+        ImpactEvent tmp = heap->items[i];
+        heap->items[i] = heap->items[parent];
+        heap->items[parent] = tmp;
+        i = parent;
+    }
+}
+
+static ImpactEvent heap_pop(ImpactHeap *heap)
+{
+    ImpactEvent top = heap->items[0];
+    heap->items[0] = heap->items[--heap->count];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t left = 2 * i + 1;
+        uint32_t right = left + 1;
+        uint32_t smallest = i;
+        if (left < heap->count && event_before(&heap->items[left], &heap->items[smallest])) smallest = left;
+        if (right < heap->count && event_before(&heap->items[right], &heap->items[smallest])) smallest = right;
+        if (smallest == i) break;
+        ImpactEvent tmp = heap->items[i];
+        heap->items[i] = heap->items[smallest];
+        heap->items[smallest] = tmp;
+        i = smallest;
+    }
+    return top;
+}
+
+static void schedule(EventSim *sim, uint32_t ball, uint64_t tick)
+{
+    sim->next_tick.items[ball] = tick;
+    heap_push(&sim->heap, tick, ball);
+}
+
+// NOTE: Ticks until `step` per tick covers `distance`, rounded down so the answer is never late
+static uint32_t ticks_until(float distance, float step)
+{
+    if (distance <= 0.0f) return 1;
+    if (!(step > 0.0f)) return EVENT_HORIZON;
+    float ticks = distance / step;
+    if (ticks >= (float)EVENT_HORIZON) return EVENT_HORIZON;
+    return ticks < 1.0f ? 1 : (uint32_t)ticks;
+}
+
+static inline uint32_t min_u32(uint32_t a, uint32_t b) { return a < b ? a : b; }
+
+uint32_t PredictImpact(const Game *game, uint32_t i)
+{
+    const Balls *balls = &game->balls;
+    float x = balls->x[i];
+    float y = balls->y[i];
+    float r = balls->radius[i] + EVENT_MARGIN;
+    float step_x = balls->vx[i] * DELTA_TIME;
+    float step_y = balls->vy[i] * DELTA_TIME;
+
+    // NOTE: Walls, mirrors BallBounds
+    if (x + r > 1.0f || x - r < -1.0f || y + r > 1.0f || y - r < -1.0f) return 1;
+    uint32_t ticks = EVENT_HORIZON;
+    if (step_x > 0.0f) ticks = min_u32(ticks, ticks_until(1.0f - r - x, step_x));
+    if (step_x < 0.0f) ticks = min_u32(ticks, ticks_until(x - r + 1.0f, -step_x));
+    if (step_y > 0.0f) ticks = min_u32(ticks, ticks_until(1.0f - r - y, step_y));
+    if (step_y < 0.0f) ticks = min_u32(ticks, ticks_until(y - r + 1.0f, -step_y));
+
+    // NOTE: Paddles only move horizontally, their reachable area is a band
+    for (uint32_t p = 0; p < game->paddle_count; ++p) {
+        const Paddle *paddle = &game->paddles[p];
+        float low = paddle->y - paddle->h * 0.5f - r;
+        float high = paddle->y + paddle->h * 0.5f + r;
+        if (y >= low && y <= high) return 1;
+        if (y > high && step_y < 0.0f) ticks = min_u32(ticks, ticks_until(y - high, -step_y));
+        if (y < low && step_y > 0.0f) ticks = min_u32(ticks, ticks_until(low - y, step_y));
+    }
+
+    // NOTE: One swept query over the horizon instead of one static query per tick
+    Contact contact;
+    float horizon = (float)EVENT_HORIZON;
+    if (CircleVsAabbs(x, y, r, step_x * horizon, step_y * horizon, &game->brick_pack, &contact)) {
+        if (contact.depth > 0.0f) return 1;
+        uint32_t brick_ticks = (uint32_t)(contact.t * horizon);
+        ticks = min_u32(ticks, brick_ticks < 1 ? 1 : brick_ticks);
+    }
+    return ticks;
+}
+
+void EventSim::Update(Game *game, const uint8_t *inputs)
+{
+    if (game->BeginTick(inputs)) valid = false;
+    if (next_tick.count != game->balls.count || last_tick != game->tick) valid = false;
+
+    Balls *balls = &game->balls;
+    for (uint32_t i = 0; i < balls->count; ++i) {
+        balls->x[i] += balls->vx[i] * DELTA_TIME;
+        balls->y[i] += balls->vy[i] * DELTA_TIME;
+    }
+    ball_ticks += balls->count;
+
+    // NOTE: Everything is due now, which is exactly a fixed step tick
+    if (!valid) {
+        array_clear(&heap);
+        array_clear(&next_tick);
+        for (uint32_t i = 0; i < balls->count; ++i) {
+            array_append(uint64_t, &next_tick, game->tick);
+            heap_push(&heap, game->tick, i);
+        }
+        valid = true;
+    }
+
+    while (heap.count > 0 && heap.items[0].tick <= game->tick) {
+        ImpactEvent event = heap_pop(&heap);
+        if (next_tick.items[event.ball] != event.tick) continue;
+        game->CollideBall(event.ball);
+        events++;
+        schedule(this, event.ball, game->tick + PredictImpact(game, event.ball));
+    }
+    game->tick++;
+    last_tick = game->tick;
+}
+
+void EventSim::stats() const
+{
+    printf("Event Sim Info: \n");
+    printf("    Pending: %u\n", heap.count);
+    printf("    Ball ticks: %lu\n", (unsigned long)ball_ticks);
+    printf("    Events: %lu (%.1f%% of ball ticks)\n", (unsigned long)events,
+           ball_ticks ? 100.0 * (double)events / (double)ball_ticks : 0.0);
+}
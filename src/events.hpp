@@ -0,0 +1,56 @@
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include "./game.hpp"
+
+// Event driven alternative to Game::GameUpdate.
+//
+// Every ball gets a conservative prediction of the first tick at which a wall,
+// paddle or brick could affect it. Predictions sit in a min-heap ordered by
+// (tick, ball), and only the balls whose event is due run the collision code;
+// all other balls just integrate. Since an event tick runs exactly the code a
+// normal tick would, the Game state is bit-identical to the fixed step mode at
+// every tick boundary.
+//
+// Predictions err early, never late: a brick that dies only removes an
+// obstacle, so a ball that wakes up for it finds nothing and is rescheduled.
+// Paddles move with input, so the whole horizontal band a paddle can reach
+// counts as an obstacle and balls inside it are processed every tick.
+
+// NOTE: Longest prediction in ticks, one swept narrowphase covers this far ahead
+#define EVENT_HORIZON 120
+// NOTE: Slack for the drift between x + n*dx and n repeated additions
+#define EVENT_MARGIN 1e-4f
+
+struct ImpactEvent {
+    uint64_t tick;
+    uint32_t ball;
+};
+
+typedef ARRAY(ImpactEvent) ImpactHeap;
+typedef ARRAY(uint64_t) EventTicks;
+
+struct EventSim {
+    EventSim();
+    ~EventSim();
+    EventSim(const EventSim&) = delete;
+    EventSim& operator=(const EventSim&) = delete;
+
+    // NOTE: Call after changing balls or paddles outside of Update (bricks are tracked through the pack)
+    void Invalidate();
+    void Update(Game *game, const uint8_t *inputs);
+    void stats() const;
+
+    ImpactHeap heap;
+    EventTicks next_tick; // NOTE: per ball, heap entries not matching it are stale
+    bool valid;
+    uint64_t last_tick; // NOTE: Game::tick after the last Update, a mismatch means the state was replaced
+
+    uint64_t ball_ticks; // NOTE: balls integrated
+    uint64_t events;     // NOTE: balls that ran the collision code
+};
+
+// NOTE: Ticks (>= 1) until ball i could next touch a wall, paddle band or brick, at most EVENT_HORIZON
+uint32_t PredictImpact(const Game *game, uint32_t i);
+
+#endif // EVENTS_H_
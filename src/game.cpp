@@ -0,0 +1,362 @@
+#include "./game.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <sys/mman.h>
+
+static inline size_t align_up(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+void soa_reserve(SoAColumn *columns, uint32_t column_count, uint32_t *capacity, bool *borrowed, uint32_t count, uint32_t needed)
+{
+    if (needed <= *capacity && !*borrowed) return;
+
+    uint32_t new_capacity = *capacity == 0 ? 256 : *capacity;
+    while (new_capacity < needed) new_capacity *= 2;
+
+    for (uint32_t i = 0; i < column_count; ++i) {
+        size_t bytes = align_up((size_t)new_capacity * columns[i].elem_size, SOA_ALIGNMENT);
+        void *items = aligned_alloc(SOA_ALIGNMENT, bytes);
+        assert(items != NULL && "Allocation of SoA column failed");
+        if (*columns[i].data) {
+            memcpy(items, *columns[i].data, (size_t)count * columns[i].elem_size);
+            if (!*borrowed) free(*columns[i].data);
+        }
+        *columns[i].data = items;
+    }
+    *capacity = new_capacity;
+    *borrowed = false;
+}
+
+void soa_free(SoAColumn *columns, uint32_t column_count, bool borrowed)
+{
+    for (uint32_t i = 0; i < column_count; ++i) {
+        if (!borrowed) free(*columns[i].data);
+        *columns[i].data = nullptr;
+    }
+}
+
+uint8_t soa_column_max(const uint8_t *column, uint32_t count)
+{
+    uint8_t max = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        max = column[i] > max ? column[i] : max;
+    }
+    return max;
+}
+
+void Balls::Columns(SoAColumn *out)
+{
+    out[0] = {(void**)&x, sizeof(*x)};
+    out[1] = {(void**)&y, sizeof(*y)};
+    out[2] = {(void**)&vx, sizeof(*vx)};
+    out[3] = {(void**)&vy, sizeof(*vy)};
+    out[4] = {(void**)&radius, sizeof(*radius)};
+}
+
+void Bricks::Columns(SoAColumn *out)
+{
+    out[0] = {(void**)&x, sizeof(*x)};
+    out[1] = {(void**)&y, sizeof(*y)};
+    out[2] = {(void**)&w, sizeof(*w)};
+    out[3] = {(void**)&h, sizeof(*h)};
+    out[4] = {(void**)&hp, sizeof(*hp)};
+    out[5] = {(void**)&type, sizeof(*type)};
+    out[6] = {(void**)&color, sizeof(*color)};
+}
+
+Game::Game():
+    balls(), bricks(), paddles(), paddle_count(0), tick(0), score(0),
+    brick_pack(), brick_pack_dirty(true), broken(),
+    mapping(nullptr), mapping_size(0),
+    level_mapping(nullptr), level_mapping_size(0)
+{}
+
+Game::~Game()
+{
+    Reset();
+    aabb_pack_free(&brick_pack);
+    array_delete(&broken);
+}
+
+// NOTE: Drops all entities and releases owned columns and any snapshot mapping
+void Game::Reset()
+{
+    SoAColumn columns[Bricks::column_count];
+    balls.Columns(columns);
+    soa_free(columns, Balls::column_count, balls.borrowed);
+    bricks.Columns(columns);
+    soa_free(columns, Bricks::column_count, bricks.borrowed);
+    balls = {};
+    bricks = {};
+    paddle_count = 0;
+    tick = 0;
+    score = 0;
+    brick_pack_dirty = true;
+    array_clear(&broken);
+
+    if (mapping) munmap(mapping, mapping_size);
+    mapping = nullptr;
+    mapping_size = 0;
+    if (level_mapping) munmap(level_mapping, level_mapping_size);
+    level_mapping = nullptr;
+    level_mapping_size = 0;
+}
+
+void Game::Clear()
+{
+    if (balls.borrowed || bricks.borrowed || mapping || level_mapping) {
+        Reset();
+        return;
+    }
+    balls.count = 0;
+    bricks.count = 0;
+    paddle_count = 0;
+    tick = 0;
+    score = 0;
+    brick_pack_dirty = true;
+    array_clear(&broken);
+}
+
+uint32_t Game::AddBall(float x, float y, float radius, float vx, float vy)
+{
+    SoAColumn columns[Balls::column_count];
+    balls.Columns(columns);
+    soa_reserve(columns, Balls::column_count, &balls.capacity, &balls.borrowed, balls.count, balls.count + 1);
+
+    uint32_t i = balls.count++;
+    balls.x[i] = x;
+    balls.y[i] = y;
+    balls.vx[i] = vx;
+    balls.vy[i] = vy;
+    balls.radius[i] = radius;
+    return i;
+}
+
+uint32_t Game::AddBrick(float x, float y, float w, float h, uint8_t hp, uint8_t type, uint8_t color)
+{
+    SoAColumn columns[Bricks::column_count];
+    bricks.Columns(columns);
+    soa_reserve(columns, Bricks::column_count, &bricks.capacity, &bricks.borrowed, bricks.count, bricks.count + 1);
+
+    uint32_t i = bricks.count++;
+    bricks.x[i] = x;
+    bricks.y[i] = y;
+    bricks.w[i] = w;
+    bricks.h[i] = h;
+    bricks.hp[i] = hp;
+    bricks.type[i] = type;
+    bricks.color[i] = color;
+    brick_pack_dirty = true;
+    return i;
+}
+
+uint32_t Game::AddPaddle(float x, float y, float w, float h, float speed)
+{
+    assert(paddle_count < MAX_PADDLES && "Too many paddles");
+    paddles[paddle_count] = {x, y, w, h, speed};
+    return paddle_count++;
+}
+
+#define BRICK_PARKED 1e30f
+
+static void build_brick_pack(Game *game)
+{
+    const Bricks *bricks = &game->bricks;
+    aabb_pack_clear(&game->brick_pack);
+    for (uint32_t i = 0; i < bricks->count; ++i) {
+        if (bricks->hp[i] == 0) {
+            aabb_pack_push(&game->brick_pack, BRICK_PARKED, BRICK_PARKED, BRICK_PARKED, BRICK_PARKED, i);
+            continue;
+        }
+        float hw = bricks->w[i] * 0.5f;
+        float hh = bricks->h[i] * 0.5f;
+        aabb_pack_push(&game->brick_pack, bricks->x[i] - hw, bricks->y[i] - hh,
+                       bricks->x[i] + hw, bricks->y[i] + hh, i);
+    }
+    game->brick_pack_dirty = false;
+}
+
+static void damage_brick(Game *game, uint32_t brick)
+{
+    uint8_t *hp = &game->bricks.hp[brick];
+    if (*hp == 0) return;
+    if (--*hp > 0) return;
+
+    AabbPack *pack = &game->brick_pack;
+    pack->min_x[brick] = pack->min_y[brick] = BRICK_PARKED;
+    pack->max_x[brick] = pack->max_y[brick] = BRICK_PARKED;
+    game->score++;
+    array_append(uint32_t, &game->broken, brick);
+}
+
+// NOTE: Paddles first, then at most one brick (the deepest) per ball and tick
+static void collide_ball(Game *game, uint32_t i)
+{
+    Balls *balls = &game->balls;
+    Contact contact;
+    for (uint32_t p = 0; p < game->paddle_count; ++p) {
+        const Paddle *paddle = &game->paddles[p];
+        float hw = paddle->w * 0.5f;
+        float hh = paddle->h * 0.5f;
+        if (CircleVsAabb(balls->x[i], balls->y[i], balls->radius[i], 0.0f, 0.0f,
+                         paddle->x - hw, paddle->y - hh, paddle->x + hw, paddle->y + hh, &contact)) {
+            ResolveContact(balls, i, &contact);
+        }
+    }
+
+    if (CircleVsAabbs(balls->x[i], balls->y[i], balls->radius[i], 0.0f, 0.0f, &game->brick_pack, &contact)) {
+        ResolveContact(balls, i, &contact);
+        damage_brick(game, contact.id);
+    }
+}
+
+// NOTE: Everything of a tick that happens before the balls move
+bool Game::BeginTick(const uint8_t *inputs)
+{
+    array_clear(&broken);
+    bool rebuilt = brick_pack_dirty || brick_pack.count != bricks.count;
+    if (rebuilt) build_brick_pack(this);
+
+    for (uint32_t i = 0; i < paddle_count; ++i) {
+        Paddle *paddle = &paddles[i];
+        uint8_t input = inputs ? inputs[i] : (uint8_t)INPUT_NONE;
+        if (input & INPUT_LEFT)  paddle->x -= paddle->speed * DELTA_TIME;
+        if (input & INPUT_RIGHT) paddle->x += paddle->speed * DELTA_TIME;
+        PaddleBounds(paddle);
+    }
+    return rebuilt;
+}
+
+void Game::CollideBall(uint32_t i)
+{
+    BallBounds(&balls, i);
+    collide_ball(this, i);
+}
+
+void Game::GameUpdate(const uint8_t *inputs)
+{
+    BeginTick(inputs);
+    for (uint32_t i = 0; i < balls.count; ++i) {
+        balls.x[i] += balls.vx[i] * DELTA_TIME;
+        balls.y[i] += balls.vy[i] * DELTA_TIME;
+        CollideBall(i);
+    }
+    tick++;
+}
+
+void Game::stats() const
+{
+    printf("Game Info: \n");
+    printf("    Tick: %lu\n", (unsigned long)tick);
+    printf("    Balls: %u (capacity %u)\n", balls.count, balls.capacity);
+    printf("    Bricks: %u (capacity %u)\n", bricks.count, bricks.capacity);
+    printf("    Paddles: %u\n", paddle_count);
+    printf("    Score: %u\n", score);
+    printf("    Mapped: %s\n", mapping ? "yes" : "no");
+}
+
+FrameState::FrameState():
+    ball_x(nullptr), ball_y(nullptr), ball_count(0), capacity(0),
+    paddle_x(), paddle_y(), paddle_count(0)
+{}
+
+FrameState::~FrameState()
+{
+    free(ball_x);
+    free(ball_y);
+}
+
+static void frame_state_reserve(FrameState *state, uint32_t needed)
+{
+    if (needed <= state->capacity) return;
+    SoAColumn columns[2] = {
+        {(void**)&state->ball_x, sizeof(float)},
+        {(void**)&state->ball_y, sizeof(float)},
+    };
+    bool borrowed = false;
+    soa_reserve(columns, 2, &state->capacity, &borrowed, state->ball_count, needed);
+}
+
+void FrameState::Capture(const Game *game)
+{
+    frame_state_reserve(this, game->balls.count);
+    ball_count = game->balls.count;
+    memcpy(ball_x, game->balls.x, ball_count * sizeof(float));
+    memcpy(ball_y, game->balls.y, ball_count * sizeof(float));
+
+    paddle_count = game->paddle_count;
+    for (uint32_t i = 0; i < paddle_count; ++i) {
+        paddle_x[i] = game->paddles[i].x;
+        paddle_y[i] = game->paddles[i].y;
+    }
+}
+
+// NOTE: alpha is the fraction of a tick the accumulator is past `current`, in [0, 1)
+void FrameState::Blend(const FrameState *previous, const Game *current, float alpha)
+{
+    frame_state_reserve(this, current->balls.count);
+    ball_count = current->balls.count;
+
+    // NOTE: Entities that did not exist in the previous tick are drawn at their current position
+    uint32_t blended = previous->ball_count < ball_count ? previous->ball_count : ball_count;
+    float beta = 1.0f - alpha;
+    for (uint32_t i = 0; i < blended; ++i) {
+        ball_x[i] = previous->ball_x[i] * beta + current->balls.x[i] * alpha;
+        ball_y[i] = previous->ball_y[i] * beta + current->balls.y[i] * alpha;
+    }
+    for (uint32_t i = blended; i < ball_count; ++i) {
+        ball_x[i] = current->balls.x[i];
+        ball_y[i] = current->balls.y[i];
+    }
+
+    paddle_count = current->paddle_count;
+    for (uint32_t i = 0; i < paddle_count; ++i) {
+        if (i < previous->paddle_count) {
+            paddle_x[i] = previous->paddle_x[i] * beta + current->paddles[i].x * alpha;
+            paddle_y[i] = previous->paddle_y[i] * beta + current->paddles[i].y * alpha;
+        } else {
+            paddle_x[i] = current->paddles[i].x;
+            paddle_y[i] = current->paddles[i].y;
+        }
+    }
+}
+
+void BallBounds(Balls *balls, uint32_t i)
+{
+    // Boundary checking (simple example)
+    if (balls->x[i] + balls->radius[i] > 1.0f || balls->x[i] - balls->radius[i] < -1.0f) {
+        balls->vx[i] *= -1.0f;
+    }
+
+    if (balls->y[i] + balls->radius[i] > 1.0f || balls->y[i] - balls->radius[i] < -1.0f) {
+        balls->vy[i] *= -1.0f;
+    }
+}
+
+// NOTE: Pushes the ball out along the normal and reflects it if it is moving into the box
+void ResolveContact(Balls *balls, uint32_t i, const Contact *contact)
+{
+    balls->x[i] += contact->nx * contact->depth;
+    balls->y[i] += contact->ny * contact->depth;
+
+    float vn = balls->vx[i] * contact->nx + balls->vy[i] * contact->ny;
+    if (vn < 0.0f) {
+        balls->vx[i] -= 2.0f * vn * contact->nx;
+        balls->vy[i] -= 2.0f * vn * contact->ny;
+    }
+}
+
+void PaddleBounds(Paddle *paddle)
+{
+    if (paddle->x > 1.0f) {
+        paddle->x = 1.0f;
+    }
+    if (paddle->x < -1.0f) {
+        paddle->x = -1.0f;
+    }
+}
@@ -0,0 +1,176 @@
+#ifndef GAME_H_
+#define GAME_H_
+
+#include <cstdint>
+#include <cstddef>
+
+#include "../util/array.h"
+#include "./collision.hpp"
+
+// NOTE: Simulation tick rate, independent of the display rate (e.g. -DFPS=30)
+#ifndef FPS
+#define FPS 60
+#endif
+#define DELTA_TIME   ((float) 1 / (float)FPS)
+
+// NOTE: Every SoA column is allocated (and stored in snapshots) on this boundary
+#define SOA_ALIGNMENT 64
+#define MAX_PADDLES 2
+
+// NOTE: Per paddle input for one tick
+enum GameInput : uint8_t {
+    INPUT_NONE  = 0,
+    INPUT_LEFT  = 1 << 0,
+    INPUT_RIGHT = 1 << 1,
+};
+
+// NOTE: Describes one column of a SoA container (used by reserve/free and the snapshot writer)
+struct SoAColumn {
+    void **data;
+    uint32_t elem_size;
+};
+
+struct Balls {
+    static const uint32_t column_count = 5;
+    void Columns(SoAColumn *out);
+
+    float *x;
+    float *y;
+    float *vx;
+    float *vy;
+    float *radius;
+    uint32_t count;
+    uint32_t capacity;
+    bool borrowed; // NOTE: columns point into a mapping and must not be freed
+};
+
+struct Bricks {
+    static const uint32_t column_count = 7;
+    void Columns(SoAColumn *out);
+
+    // NOTE: center and full size
+    float *x;
+    float *y;
+    float *w;
+    float *h;
+    uint8_t *hp; // NOTE: 0 means destroyed
+    uint8_t *type;
+    uint8_t *color;
+    uint32_t count;
+    uint32_t capacity;
+    bool borrowed;
+};
+
+typedef ARRAY(uint32_t) BrickIds;
+
+struct Paddle {
+    float x;
+    float y;
+    float w;
+    float h;
+    float speed;
+};
+
+struct Game {
+    Game();
+    ~Game();
+    Game(const Game&) = delete;
+    Game& operator=(const Game&) = delete;
+
+    void Reset();
+    void Clear(); // NOTE: Reset that keeps owned columns allocated for the next fill
+    uint32_t AddBall(float x, float y, float radius, float vx, float vy);
+    uint32_t AddBrick(float x, float y, float w, float h, uint8_t hp, uint8_t type, uint8_t color);
+    uint32_t AddPaddle(float x, float y, float w, float h, float speed);
+    void GameUpdate(const uint8_t *inputs); // NOTE: one fixed step of DELTA_TIME, inputs[paddle_count]
+    // NOTE: The pieces of GameUpdate, shared with the event driven mode (see events.hpp)
+    bool BeginTick(const uint8_t *inputs); // NOTE: returns true if the brick pack was rebuilt
+    void CollideBall(uint32_t i);
+    void stats() const;
+
+    Balls balls;
+    Bricks bricks;
+    Paddle paddles[MAX_PADDLES];
+    uint32_t paddle_count;
+    uint64_t tick;
+    uint32_t score; // NOTE: bricks destroyed
+
+    // NOTE: Derived from bricks, pack index == brick index, destroyed bricks are parked far away
+    AabbPack brick_pack;
+    bool brick_pack_dirty;
+    // NOTE: Bricks destroyed during the last GameUpdate
+    BrickIds broken;
+
+    // NOTE: set when the state was loaded from a snapshot, columns are borrowed from it
+    void *mapping;
+    size_t mapping_size;
+    // NOTE: set when the bricks were loaded from a level file
+    void *level_mapping;
+    size_t level_mapping_size;
+};
+
+// NOTE: Render-relevant positions of one tick, blended between the previous and current tick
+struct FrameState {
+    FrameState();
+    ~FrameState();
+    FrameState(const FrameState&) = delete;
+    FrameState& operator=(const FrameState&) = delete;
+
+    void Capture(const Game *game);
+    void Blend(const FrameState *previous, const Game *current, float alpha);
+
+    float *ball_x;
+    float *ball_y;
+    uint32_t ball_count;
+    uint32_t capacity;
+    float paddle_x[MAX_PADDLES];
+    float paddle_y[MAX_PADDLES];
+    uint32_t paddle_count;
+};
+
+// SoA Helpers
+void soa_reserve(SoAColumn *columns, uint32_t column_count, uint32_t *capacity, bool *borrowed, uint32_t count, uint32_t needed);
+void soa_free(SoAColumn *columns, uint32_t column_count, bool borrowed);
+// NOTE: Max reduction over a byte column, cheap enough to validate loaded type/color indices
+uint8_t soa_column_max(const uint8_t *column, uint32_t count);
+
+void BallBounds(Balls *balls, uint32_t i);
+void PaddleBounds(Paddle *paddle);
+void ResolveContact(Balls *balls, uint32_t i, const Contact *contact);
+
+// Snapshots
+#define SNAPSHOT_MAGIC "BRKSNAP"
+#define SNAPSHOT_VERSION 2
+
+bool SaveSnapshot(const Game *game, const char *file_path);
+bool LoadSnapshot(Game *game, const char *file_path);
+
+// NOTE: In-memory copy of the same state a snapshot holds, for rollback and desync checks
+struct StateBuffer {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+};
+
+void SaveState(const Game *game, StateBuffer *state);
+bool LoadState(Game *game, const StateBuffer *state);
+uint32_t StateChecksum(const StateBuffer *state);
+void state_buffer_free(StateBuffer *state);
+
+// Levels
+#define LEVEL_MAGIC "BRKLEVL"
+#define LEVEL_VERSION 1
+#define LEVEL_MAX_TYPES 8
+#define LEVEL_MAX_COLORS 16
+
+struct LevelInfo {
+    uint32_t cols;
+    uint32_t rows;
+    uint32_t brick_count;
+};
+
+bool SaveLevel(const Bricks *bricks, const LevelInfo *info, const char *file_path);
+// NOTE: Replaces the bricks of `game` with the level, balls and paddles are kept
+bool LoadLevel(Game *game, const char *file_path, LevelInfo *info);
+
+#endif // GAME_H_
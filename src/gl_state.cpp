@@ -0,0 +1,202 @@
+#include "./breakoutt.hpp"
+
+GLStateCache gl_state;
+
+static const GLenum cached_capabilities[STATE_CACHE_CAPABILITIES] = {GL_BLEND, GL_PROGRAM_POINT_SIZE};
+
+static int32_t buffer_target_slot(GLenum target)
+{
+    switch (target) {
+    case GL_ARRAY_BUFFER: return STATE_ARRAY_BUFFER;
+    case GL_ELEMENT_ARRAY_BUFFER: return STATE_ELEMENT_ARRAY_BUFFER;
+    case GL_COPY_WRITE_BUFFER: return STATE_COPY_WRITE_BUFFER;
+    case GL_SHADER_STORAGE_BUFFER: return STATE_SHADER_STORAGE_BUFFER;
+    default: return -1;
+    }
+}
+
+static int32_t capability_slot(GLenum capability)
+{
+    for (uint32_t i = 0; i < STATE_CACHE_CAPABILITIES; ++i) {
+        if (cached_capabilities[i] == capability) return (int32_t)i;
+    }
+    return -1;
+}
+
+GLStateCache::GLStateCache():
+    frame_changes(0), frame_skipped(0), last_changes(0), peak_changes(0),
+    frames(0), changes(0), skipped(0)
+{
+    Invalidate();
+}
+
+void GLStateCache::Invalidate()
+{
+    program = STATE_CACHE_UNKNOWN;
+    vao = STATE_CACHE_UNKNOWN;
+    for (uint32_t i = 0; i < STATE_BUFFER_TARGETS; ++i) buffers[i] = STATE_CACHE_UNKNOWN;
+    for (uint32_t i = 0; i < STATE_CACHE_STORAGE_BINDINGS; ++i) storage[i] = STATE_CACHE_UNKNOWN;
+    active_unit = STATE_CACHE_UNKNOWN;
+    for (uint32_t i = 0; i < STATE_CACHE_TEXTURE_UNITS; ++i) textures[i] = STATE_CACHE_UNKNOWN;
+    for (uint32_t i = 0; i < STATE_CACHE_CAPABILITIES; ++i) capabilities[i] = STATE_CACHE_UNKNOWN;
+    blend_source = STATE_CACHE_UNKNOWN;
+    blend_destination = STATE_CACHE_UNKNOWN;
+}
+
+void GLStateCache::UseProgram(GLuint id)
+{
+    if (program == id) {
+        frame_skipped++;
+        return;
+    }
+    glUseProgram(id);
+    program = id;
+    frame_changes++;
+}
+
+void GLStateCache::BindVertexArray(GLuint id)
+{
+    if (vao == id) {
+        frame_skipped++;
+        return;
+    }
+    glBindVertexArray(id);
+    vao = id;
+    buffers[STATE_ELEMENT_ARRAY_BUFFER] = STATE_CACHE_UNKNOWN;
+    frame_changes++;
+}
+
+void GLStateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+    int32_t slot = buffer_target_slot(target);
+    if (slot >= 0 && buffers[slot] == buffer) {
+        frame_skipped++;
+        return;
+    }
+    glBindBuffer(target, buffer);
+    if (slot >= 0) buffers[slot] = buffer;
+    frame_changes++;
+}
+
+// NOTE: Binding an indexed target also sets its generic binding
+void GLStateCache::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    bool cached = target == GL_SHADER_STORAGE_BUFFER && index < STATE_CACHE_STORAGE_BINDINGS;
+    if (cached && storage[index] == buffer) {
+        frame_skipped++;
+        return;
+    }
+    glBindBufferBase(target, index, buffer);
+    if (cached) storage[index] = buffer;
+    int32_t slot = buffer_target_slot(target);
+    if (slot >= 0) buffers[slot] = buffer;
+    frame_changes++;
+}
+
+void GLStateCache::BindTexture(GLuint unit, GLuint texture)
+{
+    assert(unit < STATE_CACHE_TEXTURE_UNITS);
+    if (textures[unit] == texture) {
+        frame_skipped++;
+        return;
+    }
+    if (active_unit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        active_unit = unit;
+        frame_changes++;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    textures[unit] = texture;
+    frame_changes++;
+}
+
+void GLStateCache::Enable(GLenum capability, bool enabled)
+{
+    int32_t slot = capability_slot(capability);
+    if (slot >= 0 && capabilities[slot] == (uint32_t)enabled) {
+        frame_skipped++;
+        return;
+    }
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+    if (slot >= 0) capabilities[slot] = (uint32_t)enabled;
+    frame_changes++;
+}
+
+void GLStateCache::BlendFunc(GLenum source, GLenum destination)
+{
+    if (blend_source == source && blend_destination == destination) {
+        frame_skipped++;
+        return;
+    }
+    glBlendFunc(source, destination);
+    blend_source = source;
+    blend_destination = destination;
+    frame_changes++;
+}
+
+// NOTE: A program in use is only flagged for deletion, the next UseProgram always goes through
+void GLStateCache::DeleteProgram(GLuint *id)
+{
+    if (*id == 0) return;
+    glDeleteProgram(*id);
+    if (program == *id) program = STATE_CACHE_UNKNOWN;
+    *id = 0;
+}
+
+// NOTE: Deleting a bound object unbinds it, and GL may hand out the same name again
+void GLStateCache::DeleteVertexArray(GLuint *id)
+{
+    if (*id == 0) return;
+    glDeleteVertexArrays(1, id);
+    if (vao == *id) {
+        vao = 0;
+        buffers[STATE_ELEMENT_ARRAY_BUFFER] = STATE_CACHE_UNKNOWN;
+    }
+    *id = 0;
+}
+
+void GLStateCache::DeleteBuffer(GLuint *id)
+{
+    if (*id == 0) return;
+    glDeleteBuffers(1, id);
+    for (uint32_t i = 0; i < STATE_BUFFER_TARGETS; ++i) {
+        if (buffers[i] == *id) buffers[i] = 0;
+    }
+    for (uint32_t i = 0; i < STATE_CACHE_STORAGE_BINDINGS; ++i) {
+        if (storage[i] == *id) storage[i] = 0;
+    }
+    *id = 0;
+}
+
+void GLStateCache::DeleteTexture(GLuint *id)
+{
+    if (*id == 0) return;
+    glDeleteTextures(1, id);
+    for (uint32_t i = 0; i < STATE_CACHE_TEXTURE_UNITS; ++i) {
+        if (textures[i] == *id) textures[i] = 0;
+    }
+    *id = 0;
+}
+
+void GLStateCache::EndFrame()
+{
+    frames++;
+    changes += frame_changes;
+    skipped += frame_skipped;
+    last_changes = frame_changes;
+    if (frame_changes > peak_changes) peak_changes = frame_changes;
+    frame_changes = 0;
+    frame_skipped = 0;
+}
+
+void GLStateCache::stats() const
+{
+    printf("GL State Info: \n");
+    printf("    Frames: %lu, State changes: %lu, Skipped as redundant: %lu\n",
+           (unsigned long)frames, (unsigned long)changes, (unsigned long)skipped);
+    if (frames > 0) {
+        printf("    Per frame: %.1f changes, %.1f skipped, last %u, peak %u\n",
+               (double)changes / frames, (double)skipped / frames, last_changes, peak_changes);
+    }
+}
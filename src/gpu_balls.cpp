@@ -0,0 +1,237 @@
+#include "./breakoutt.hpp"
+
+#define GPU_BALL_COMPUTE_SHADER "shader/ball_physics.comp"
+#define GPU_BALL_VERTEX_SHADER "shader/gpu_ball.vert"
+#define GPU_BALL_FRAGMENT_SHADER "shader/particle.frag"
+
+GpuBalls::GpuBalls():
+    ComputeProgramId(0), DrawProgramId(0), VAO(0),
+    BallBuffer(0), RectBuffer(0), HpBuffer(0), GridBuffer(0),
+    ballCountLoc(-1), ticksLoc(-1), radiusLoc(-1), dtLoc(-1), gridSizeLoc(-1),
+    paddleCountLoc(-1), paddlesLoc(-1), aspectRatioLoc(-1), pointSizeLoc(-1),
+    count(0), capacity(0), brick_count(0), radius(0.0f), dispatches(0), ticks(0)
+{}
+
+GpuBalls::~GpuBalls()
+{
+    gl_state.DeleteBuffer(&BallBuffer);
+    gl_state.DeleteBuffer(&RectBuffer);
+    gl_state.DeleteBuffer(&HpBuffer);
+    gl_state.DeleteBuffer(&GridBuffer);
+    gl_state.DeleteVertexArray(&VAO);
+    gl_state.DeleteProgram(&ComputeProgramId);
+    gl_state.DeleteProgram(&DrawProgramId);
+}
+
+bool GpuBalls::Init(uint32_t max_balls, float ball_radius)
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major < 4 || (major == 4 && minor < 3)) {
+        fprintf(stderr, "GPU balls need compute shaders (GL 4.3), got GL %d.%d.\n", major, minor);
+        return false;
+    }
+
+    GLuint compute = LoadComputeShader(GPU_BALL_COMPUTE_SHADER);
+    if (compute == 0) return false;
+    if (!SwapComputeProgram(compute)) {
+        glDeleteProgram(compute);
+        return false;
+    }
+    GLuint draw = LoadShader(GPU_BALL_VERTEX_SHADER, GPU_BALL_FRAGMENT_SHADER);
+    if (draw == 0) return false;
+    SwapDrawProgram(draw);
+
+    capacity = max_balls;
+    radius = ball_radius;
+
+    // NOTE: Positions come from the storage buffer by gl_VertexID, the VAO has no attributes
+    glGenVertexArrays(1, &VAO);
+
+    glGenBuffers(1, &BallBuffer);
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, BallBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)capacity * sizeof(GpuBall), nullptr, GL_DYNAMIC_COPY);
+
+    glGenBuffers(1, &RectBuffer);
+    glGenBuffers(1, &HpBuffer);
+    glGenBuffers(1, &GridBuffer);
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    Bricks empty = {};
+    UploadBricks(&empty);
+    return true;
+}
+
+// NOTE: Dispatch sizes assume GPU_BALL_GROUP_SIZE, a shader with another local size is refused
+bool GpuBalls::SwapComputeProgram(GLuint program)
+{
+    GLint group[3] = {};
+    glGetProgramiv(program, GL_COMPUTE_WORK_GROUP_SIZE, group);
+    if (group[0] != GPU_BALL_GROUP_SIZE || group[1] != 1 || group[2] != 1) {
+        fprintf(stderr, "Ball physics shader must use local_size_x = %d, got %dx%dx%d.\n",
+                GPU_BALL_GROUP_SIZE, group[0], group[1], group[2]);
+        return false;
+    }
+    gl_state.DeleteProgram(&ComputeProgramId);
+    ComputeProgramId = program;
+    ballCountLoc = glGetUniformLocation(ComputeProgramId, "ballCount");
+    ticksLoc = glGetUniformLocation(ComputeProgramId, "ticks");
+    radiusLoc = glGetUniformLocation(ComputeProgramId, "radius");
+    dtLoc = glGetUniformLocation(ComputeProgramId, "dt");
+    gridSizeLoc = glGetUniformLocation(ComputeProgramId, "gridSize");
+    paddleCountLoc = glGetUniformLocation(ComputeProgramId, "paddleCount");
+    paddlesLoc = glGetUniformLocation(ComputeProgramId, "paddles");
+    return true;
+}
+
+bool GpuBalls::SwapDrawProgram(GLuint program)
+{
+    gl_state.DeleteProgram(&DrawProgramId);
+    DrawProgramId = program;
+    aspectRatioLoc = glGetUniformLocation(DrawProgramId, "aspectRatio");
+    pointSizeLoc = glGetUniformLocation(DrawProgramId, "pointSize");
+    return true;
+}
+
+static bool swap_compute_program(void *owner, GLuint program)
+{
+    return ((GpuBalls*)owner)->SwapComputeProgram(program);
+}
+
+static bool swap_draw_program(void *owner, GLuint program)
+{
+    return ((GpuBalls*)owner)->SwapDrawProgram(program);
+}
+
+void GpuBalls::WatchShaders(ShaderReloader *reloader)
+{
+    reloader->AddCompute(GPU_BALL_COMPUTE_SHADER, this, swap_compute_program);
+    reloader->Add(GPU_BALL_VERTEX_SHADER, GPU_BALL_FRAGMENT_SHADER, this, swap_draw_program);
+}
+
+// NOTE: Spread over the lower half, launched upwards at random angles
+void GpuBalls::Spawn(uint32_t n, Rng *rng)
+{
+    if (n > capacity) n = capacity;
+    GpuBall *staging = (GpuBall*)malloc((size_t)n * sizeof(GpuBall));
+    if (staging == nullptr) {
+        fprintf(stderr, "Failed to Allocate GPU Ball Staging Buffer.\n");
+        return;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        float angle = rng->Range(0.15f, 0.85f) * (float)M_PI;
+        float speed = rng->Range(0.8f, 1.6f);
+        staging[i].x = rng->Range(-1.0f + radius, 1.0f - radius);
+        staging[i].y = rng->Range(-0.8f, -0.1f);
+        staging[i].vx = cosf(angle) * speed;
+        staging[i].vy = sinf(angle) * speed;
+    }
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, BallBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)n * sizeof(GpuBall), staging);
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    free(staging);
+    count = n;
+}
+
+static inline int32_t grid_cell(float v)
+{
+    int32_t cell = (int32_t)floorf((v * 0.5f + 0.5f) * GPU_BRICK_GRID);
+    return cell < 0 ? 0 : (cell >= GPU_BRICK_GRID ? GPU_BRICK_GRID - 1 : cell);
+}
+
+// NOTE: Every grid cell a brick overlaps points at it, the shader only tests that one brick
+void GpuBalls::UploadBricks(const Bricks *bricks)
+{
+    brick_count = bricks->count;
+    uint32_t n = brick_count > 0 ? brick_count : 1; // NOTE: zero sized storage buffers can't be bound
+    float *rects = (float*)calloc((size_t)n * 4, sizeof(float));
+    int32_t *hp = (int32_t*)calloc(n, sizeof(int32_t));
+    int32_t *grid = (int32_t*)malloc((size_t)GPU_BRICK_GRID * GPU_BRICK_GRID * sizeof(int32_t));
+    if (rects == nullptr || hp == nullptr || grid == nullptr) {
+        fprintf(stderr, "Failed to Allocate GPU Brick Staging Buffers.\n");
+        free(rects);
+        free(hp);
+        free(grid);
+        return;
+    }
+    memset(grid, 0xFF, (size_t)GPU_BRICK_GRID * GPU_BRICK_GRID * sizeof(int32_t));
+
+    for (uint32_t i = 0; i < brick_count; ++i) {
+        float hw = bricks->w[i] * 0.5f;
+        float hh = bricks->h[i] * 0.5f;
+        rects[i * 4 + 0] = bricks->x[i];
+        rects[i * 4 + 1] = bricks->y[i];
+        rects[i * 4 + 2] = hw;
+        rects[i * 4 + 3] = hh;
+        hp[i] = bricks->hp[i];
+        if (hp[i] == 0) continue;
+        int32_t x0 = grid_cell(bricks->x[i] - hw), x1 = grid_cell(bricks->x[i] + hw);
+        int32_t y0 = grid_cell(bricks->y[i] - hh), y1 = grid_cell(bricks->y[i] + hh);
+        for (int32_t y = y0; y <= y1; ++y) {
+            for (int32_t x = x0; x <= x1; ++x) grid[y * GPU_BRICK_GRID + x] = (int32_t)i;
+        }
+    }
+
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, RectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)n * 4 * sizeof(float), rects, GL_STATIC_DRAW);
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, HpBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)n * sizeof(int32_t), hp, GL_DYNAMIC_COPY);
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, GridBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)GPU_BRICK_GRID * GPU_BRICK_GRID * sizeof(int32_t), grid, GL_STATIC_DRAW);
+    gl_state.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    free(rects);
+    free(hp);
+    free(grid);
+}
+
+// NOTE: All ticks of the frame run inside one dispatch, the paddles are taken from the CPU game
+void GpuBalls::Step(const Game *game, uint32_t step_ticks)
+{
+    if (count == 0 || step_ticks == 0) return;
+    float paddles[MAX_PADDLES * 4] = {};
+    for (uint32_t i = 0; i < game->paddle_count; ++i) {
+        paddles[i * 4 + 0] = game->paddles[i].x;
+        paddles[i * 4 + 1] = game->paddles[i].y;
+        paddles[i * 4 + 2] = game->paddles[i].w * 0.5f;
+        paddles[i * 4 + 3] = game->paddles[i].h * 0.5f;
+    }
+
+    gl_state.UseProgram(ComputeProgramId);
+    glUniform1ui(ballCountLoc, count);
+    glUniform1ui(ticksLoc, step_ticks);
+    glUniform1f(radiusLoc, radius);
+    glUniform1f(dtLoc, DELTA_TIME);
+    glUniform2i(gridSizeLoc, GPU_BRICK_GRID, GPU_BRICK_GRID);
+    glUniform1ui(paddleCountLoc, game->paddle_count);
+    glUniform4fv(paddlesLoc, MAX_PADDLES, paddles);
+    gl_state.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, BallBuffer);
+    gl_state.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, RectBuffer);
+    gl_state.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, HpBuffer);
+    gl_state.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, GridBuffer);
+    glDispatchCompute((count + GPU_BALL_GROUP_SIZE - 1) / GPU_BALL_GROUP_SIZE, 1, 1);
+    // NOTE: The draw pass reads the positions through the storage buffer too
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    dispatches++;
+    ticks += step_ticks;
+}
+
+void GpuBalls::Draw(float aspect_ratio, float point_size)
+{
+    if (count == 0) return;
+    gl_state.UseProgram(DrawProgramId);
+    glUniform1f(aspectRatioLoc, aspect_ratio);
+    glUniform1f(pointSizeLoc, point_size);
+    gl_state.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, BallBuffer);
+    gl_state.Enable(GL_PROGRAM_POINT_SIZE, true);
+    gl_state.BindVertexArray(VAO);
+    glDrawArrays(GL_POINTS, 0, count);
+}
+
+void GpuBalls::stats() const
+{
+    printf("GPU Balls Info: \n");
+    printf("    Balls: %u (capacity %u), radius %.3f\n", count, capacity, radius);
+    printf("    Bricks: %u on a %ux%u grid\n", brick_count, GPU_BRICK_GRID, GPU_BRICK_GRID);
+    printf("    Dispatches: %lu for %lu ticks\n", (unsigned long)dispatches, (unsigned long)ticks);
+}
@@ -0,0 +1,96 @@
+#include "./blockfile.hpp"
+#include "./assets.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+
+// Levels are block files holding exactly the Bricks columns, so loading is a
+// mapping plus a validation pass; the bricks are used in place afterwards.
+// Levels held by a mounted asset pack are copied out of it instead.
+
+struct LevelHeader {
+    BlockFileHeader file;
+    uint32_t cols;
+    uint32_t rows;
+    uint32_t brick_count;
+    uint32_t reserved;
+};
+
+bool SaveLevel(const Bricks *bricks, const LevelInfo *info, const char *file_path)
+{
+    Bricks view = *bricks;
+    SoAColumn columns[Bricks::column_count];
+    uint32_t counts[Bricks::column_count];
+    view.Columns(columns);
+    for (uint32_t i = 0; i < Bricks::column_count; ++i) counts[i] = bricks->count;
+
+    LevelHeader header = {};
+    header.cols = info->cols;
+    header.rows = info->rows;
+    header.brick_count = bricks->count;
+
+    return blockfile_write(file_path, &header, sizeof(header), LEVEL_MAGIC, LEVEL_VERSION,
+                           columns, counts, Bricks::column_count);
+}
+
+bool LoadLevel(Game *game, const char *file_path, LevelInfo *info)
+{
+    SoAColumn columns[Bricks::column_count];
+    game->bricks.Columns(columns);
+
+    // NOTE: A packed level is copied, the simulation writes into the brick columns
+    size_t size = 0;
+    AssetView packed;
+    void *mapping = nullptr;
+    if (assets.FindPacked(file_path, &packed)) {
+        size = packed.size;
+        mapping = blockfile_copy(packed.data, packed.size, file_path, LEVEL_MAGIC, LEVEL_VERSION,
+                                 sizeof(LevelHeader), columns, Bricks::column_count);
+    } else {
+        mapping = blockfile_map(file_path, &size, LEVEL_MAGIC, LEVEL_VERSION,
+                                sizeof(LevelHeader), columns, Bricks::column_count);
+    }
+    if (mapping == nullptr) return false;
+
+    const LevelHeader *header = (const LevelHeader*)mapping;
+    const BlockFileBlock *blocks = blockfile_blocks(mapping);
+    bool valid = (uint64_t)header->brick_count <= (uint64_t)header->cols * header->rows;
+    for (uint32_t i = 0; i < Bricks::column_count; ++i) {
+        if (blocks[i].count != header->brick_count) valid = false;
+    }
+    if (!valid) {
+        fprintf(stderr, "%s: corrupt level header.\n", file_path);
+        munmap(mapping, size);
+        return false;
+    }
+
+    const uint8_t *type = (const uint8_t*)mapping + blocks[5].offset;
+    const uint8_t *color = (const uint8_t*)mapping + blocks[6].offset;
+    if (soa_column_max(type, header->brick_count) >= LEVEL_MAX_TYPES ||
+        soa_column_max(color, header->brick_count) >= LEVEL_MAX_COLORS) {
+        fprintf(stderr, "%s: brick type or color index out of range.\n", file_path);
+        munmap(mapping, size);
+        return false;
+    }
+
+    Bricks *bricks = &game->bricks;
+    soa_free(columns, Bricks::column_count, bricks->borrowed);
+    if (game->level_mapping) munmap(game->level_mapping, game->level_mapping_size);
+
+    bricks->count = bricks->capacity = header->brick_count;
+    bricks->borrowed = true;
+    for (uint32_t i = 0; i < Bricks::column_count; ++i) {
+        *columns[i].data = (char*)mapping + blocks[i].offset;
+    }
+    game->level_mapping = mapping;
+    game->level_mapping_size = size;
+    game->brick_pack_dirty = true;
+
+    if (info) {
+        info->cols = header->cols;
+        info->rows = header->rows;
+        info->brick_count = header->brick_count;
+    }
+    return true;
+}
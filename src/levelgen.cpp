@@ -0,0 +1,212 @@
+#include "./levelgen.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <sys/mman.h>
+
+// NOTE: Everything about a level that is rolled once from the seed, before the chunks split off
+struct LevelPlan {
+    uint8_t pattern;
+    uint32_t period;  // NOTE: cells per checker square, stripe or diamond ring
+    uint32_t palette; // NOTE: color offset into BrickPalette
+    bool vertical;    // NOTE: stripes run top to bottom
+    float phase;      // NOTE: waves
+};
+
+struct LevelJob {
+    const LevelGenConfig *config;
+    const LevelPlan *plan;
+    const Rng *streams;
+    uint32_t *counts;
+    uint32_t chunk_count;
+    uint64_t cell_count;
+    Bricks *bricks;
+    std::atomic<uint32_t> next;
+};
+
+LevelGenConfig DefaultLevelGen(uint64_t seed, uint32_t cols, uint32_t rows)
+{
+    LevelGenConfig config = {};
+    config.seed = seed;
+    config.cols = cols;
+    config.rows = rows;
+    config.cell_w = 1.9f / (float)cols;
+    config.cell_h = 0.7f / (float)rows;
+    config.origin_x = -0.95f + config.cell_w * 0.5f;
+    config.origin_y = 0.95f - config.cell_h * 0.5f;
+    config.brick_w = config.cell_w * 0.9f;
+    config.brick_h = config.cell_h * 0.8f;
+    config.density = 0.9f;
+    config.max_hp = 3;
+    return config;
+}
+
+static LevelPlan plan_level(const LevelGenConfig *config, Rng *rng)
+{
+    LevelPlan plan = {};
+    plan.pattern = (uint8_t)rng->Below(PATTERN_COUNT);
+    uint32_t smaller = config->cols < config->rows ? config->cols : config->rows;
+    uint32_t max_period = smaller / 4 > 1 ? smaller / 4 : 1;
+    plan.period = 1 + rng->Below(max_period);
+    plan.palette = rng->Below(LEVEL_MAX_COLORS);
+    plan.vertical = rng->Next() & 1u;
+    plan.phase = rng->Range(0.0f, 2.0f * (float)M_PI);
+    return plan;
+}
+
+static bool cell_kept(const LevelGenConfig *config, const LevelPlan *plan, uint32_t col, uint32_t row)
+{
+    uint32_t period = plan->period;
+    switch (plan->pattern) {
+    case PATTERN_CHECKER:
+        return ((col / period) + (row / period)) % 2 == 0;
+    case PATTERN_STRIPES:
+        return ((plan->vertical ? col : row) / period) % 2 == 0;
+    case PATTERN_DIAMONDS: {
+        int64_t dx = (int64_t)col - config->cols / 2;
+        int64_t dy = (int64_t)row - config->rows / 2;
+        uint64_t distance = (uint64_t)(dx < 0 ? -dx : dx) + (uint64_t)(dy < 0 ? -dy : dy);
+        return distance % (2 * period) < period;
+    }
+    case PATTERN_WAVES: {
+        float center = config->rows * (0.5f + 0.35f * sinf(plan->phase + col * (2.0f * (float)M_PI) / (config->cols * 0.5f + 1.0f)));
+        return fabsf((float)row - center) < (float)(period + 1) * 1.5f;
+    }
+    case PATTERN_NOISE:
+        return true; // NOTE: only the density roll, run at a lower density below
+    default:
+        return true;
+    }
+}
+
+// NOTE: Writes the chunk's bricks densely from the slot of its first cell on, returns how many
+static uint32_t generate_chunk(LevelJob *job, uint32_t chunk)
+{
+    const LevelGenConfig *config = job->config;
+    const LevelPlan *plan = job->plan;
+    Rng rng = job->streams[chunk];
+    Bricks *bricks = job->bricks;
+
+    uint64_t first = (uint64_t)chunk * LEVELGEN_CHUNK_CELLS;
+    uint64_t last = first + LEVELGEN_CHUNK_CELLS < job->cell_count ? first + LEVELGEN_CHUNK_CELLS : job->cell_count;
+    float density = plan->pattern == PATTERN_NOISE ? config->density * 0.6f : config->density;
+    uint32_t out = (uint32_t)first;
+    for (uint64_t cell = first; cell < last; ++cell) {
+        uint32_t col = (uint32_t)(cell % config->cols);
+        uint32_t row = (uint32_t)(cell / config->cols);
+        // NOTE: Every cell rolls the same number of values, kept or not, so streams stay aligned
+        float presence = rng.Float();
+        uint32_t bonus = rng.Below(8);
+        if (!cell_kept(config, plan, col, row) || presence >= density) continue;
+
+        // NOTE: Rows near the top are tougher, one in eight bricks gets an extra hit point
+        uint32_t hp = 1 + (uint32_t)((config->max_hp - 1) * (uint64_t)(config->rows - 1 - row) / config->rows);
+        if (bonus == 0 && hp < config->max_hp) hp++;
+
+        bricks->x[out] = config->origin_x + col * config->cell_w;
+        bricks->y[out] = config->origin_y - row * config->cell_h;
+        bricks->w[out] = config->brick_w;
+        bricks->h[out] = config->brick_h;
+        bricks->hp[out] = (uint8_t)hp;
+        bricks->type[out] = 0;
+        bricks->color[out] = (uint8_t)((plan->palette + (uint64_t)row * 8 / config->rows) % LEVEL_MAX_COLORS);
+        out++;
+    }
+    return out - (uint32_t)first;
+}
+
+static void levelgen_worker(LevelJob *job)
+{
+    for (;;) {
+        uint32_t chunk = job->next.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= job->chunk_count) break;
+        job->counts[chunk] = generate_chunk(job, chunk);
+    }
+}
+
+// NOTE: Generated bricks are owned, drop a level file mapping the bricks may still point into
+static void own_bricks(Game *game)
+{
+    Bricks *bricks = &game->bricks;
+    if (!bricks->borrowed) return;
+    SoAColumn columns[Bricks::column_count];
+    bricks->Columns(columns);
+    soa_free(columns, Bricks::column_count, true);
+    bricks->count = bricks->capacity = 0;
+    bricks->borrowed = false;
+    if (game->level_mapping) munmap(game->level_mapping, game->level_mapping_size);
+    game->level_mapping = nullptr;
+    game->level_mapping_size = 0;
+}
+
+bool GenerateLevel(Game *game, const LevelGenConfig *config, uint32_t thread_count, LevelInfo *info)
+{
+    uint64_t cell_count = (uint64_t)config->cols * config->rows;
+    if (cell_count == 0 || cell_count > UINT32_MAX / 2 || config->max_hp == 0 ||
+        config->density < 0.0f || config->density > 1.0f) {
+        fprintf(stderr, "Invalid level generator config: %ux%u cells, max hp %u, density %.2f.\n",
+                config->cols, config->rows, config->max_hp, config->density);
+        return false;
+    }
+
+    own_bricks(game);
+    Bricks *bricks = &game->bricks;
+    SoAColumn columns[Bricks::column_count];
+    bricks->Columns(columns);
+    bricks->count = 0;
+    soa_reserve(columns, Bricks::column_count, &bricks->capacity, &bricks->borrowed, 0, (uint32_t)cell_count);
+
+    Rng master(config->seed);
+    LevelPlan plan = plan_level(config, &master);
+    uint32_t chunk_count = (uint32_t)((cell_count + LEVELGEN_CHUNK_CELLS - 1) / LEVELGEN_CHUNK_CELLS);
+    Rng *streams = new Rng[chunk_count];
+    uint32_t *counts = new uint32_t[chunk_count];
+    for (uint32_t i = 0; i < chunk_count; ++i) streams[i] = master.Split();
+
+    LevelJob job;
+    job.config = config;
+    job.plan = &plan;
+    job.streams = streams;
+    job.counts = counts;
+    job.chunk_count = chunk_count;
+    job.cell_count = cell_count;
+    job.bricks = bricks;
+    job.next = 0;
+
+    if (thread_count == 0) thread_count = std::thread::hardware_concurrency();
+    if (thread_count == 0) thread_count = 1;
+    if (thread_count > chunk_count) thread_count = chunk_count;
+    std::thread *threads = new std::thread[thread_count];
+    for (uint32_t i = 1; i < thread_count; ++i) threads[i] = std::thread(levelgen_worker, &job);
+    levelgen_worker(&job);
+    for (uint32_t i = 1; i < thread_count; ++i) threads[i].join();
+    delete[] threads;
+
+    // NOTE: Chunks only ever move towards the front, in order, so memmove never overwrites unread bricks
+    uint32_t total = 0;
+    for (uint32_t chunk = 0; chunk < chunk_count; ++chunk) {
+        uint32_t first = chunk * LEVELGEN_CHUNK_CELLS;
+        if (total != first && counts[chunk] > 0) {
+            for (uint32_t c = 0; c < Bricks::column_count; ++c) {
+                char *data = (char*)*columns[c].data;
+                uint32_t size = columns[c].elem_size;
+                memmove(data + (size_t)total * size, data + (size_t)first * size, (size_t)counts[chunk] * size);
+            }
+        }
+        total += counts[chunk];
+    }
+    delete[] streams;
+    delete[] counts;
+
+    bricks->count = total;
+    game->brick_pack_dirty = true;
+    if (info) {
+        info->cols = config->cols;
+        info->rows = config->rows;
+        info->brick_count = total;
+    }
+    return true;
+}
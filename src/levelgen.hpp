@@ -0,0 +1,48 @@
+#ifndef LEVELGEN_H_
+#define LEVELGEN_H_
+
+#include "./game.hpp"
+#include "./random.hpp"
+
+// Procedural brick fields for endless mode.
+//
+// A seed picks a pattern (checker, stripes, diamonds, waves or noise) and a
+// palette offset, then every cell of the grid is rolled for presence, hit
+// points and color. The grid is cut into fixed chunks of LEVELGEN_CHUNK_CELLS
+// cells, each with its own split random stream, so chunks can be generated
+// by any number of threads in any order. Every chunk writes its bricks at the
+// offset of its first cell, then the chunks are compacted in order. The
+// result only depends on the config, not on the thread count.
+
+#define LEVELGEN_CHUNK_CELLS 4096
+
+enum LevelPattern : uint8_t {
+    PATTERN_FULL = 0,
+    PATTERN_CHECKER,
+    PATTERN_STRIPES,
+    PATTERN_DIAMONDS,
+    PATTERN_WAVES,
+    PATTERN_NOISE,
+    PATTERN_COUNT,
+};
+
+struct LevelGenConfig {
+    uint64_t seed;
+    uint32_t cols;
+    uint32_t rows;
+    float origin_x; // NOTE: center of the top left cell, like the level text format
+    float origin_y;
+    float cell_w;
+    float cell_h;
+    float brick_w;
+    float brick_h;
+    float density; // NOTE: chance that a cell the pattern keeps gets a brick
+    uint8_t max_hp;
+};
+
+// NOTE: cols x rows cells over the upper part of the playfield
+LevelGenConfig DefaultLevelGen(uint64_t seed, uint32_t cols, uint32_t rows);
+// NOTE: Replaces the bricks of `game`, balls and paddles are kept; thread_count 0 uses every core
+bool GenerateLevel(Game *game, const LevelGenConfig *config, uint32_t thread_count, LevelInfo *info);
+
+#endif // LEVELGEN_H_
@@ -0,0 +1,143 @@
+#include "./net.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cassert>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+UdpTransport::UdpTransport():
+    fd(-1), peer(), has_peer(false), delay(0), jitter(0), loss(0.0f), rng(0x1234567u),
+    delayed(), sent(0), dropped(0), received(0)
+{}
+
+UdpTransport::~UdpTransport()
+{
+    if (fd >= 0) close(fd);
+    array_delete(&delayed);
+}
+
+bool UdpTransport::Open(uint16_t port)
+{
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Could not create UDP socket: %s\n", strerror(errno));
+        return false;
+    }
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        fprintf(stderr, "Could not make UDP socket non-blocking: %s\n", strerror(errno));
+        return false;
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        fprintf(stderr, "Could not bind UDP port %u: %s\n", port, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool UdpTransport::SetPeer(const char *host, uint16_t port)
+{
+    peer = {};
+    peer.sin_family = AF_INET;
+    peer.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &peer.sin_addr) != 1) {
+        fprintf(stderr, "Invalid peer address %s\n", host);
+        return false;
+    }
+    has_peer = true;
+    return true;
+}
+
+static void transport_send_now(UdpTransport *transport, const void *data, size_t size)
+{
+    ssize_t n = sendto(transport->fd, data, size, 0, (const sockaddr*)&transport->peer, sizeof(transport->peer));
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        fprintf(stderr, "UDP send failed: %s\n", strerror(errno));
+    }
+}
+
+void UdpTransport::Send(const void *data, size_t size, uint64_t now)
+{
+    assert(size <= NET_MAX_PACKET && "Packet too large");
+    if (!has_peer || fd < 0) return;
+    sent++;
+    if (loss > 0.0f && rng.Float() < loss) {
+        dropped++;
+        return;
+    }
+    if (delay == 0 && jitter == 0) {
+        transport_send_now(this, data, size);
+        return;
+    }
+
+    DelayedPacket packet;
+    packet.due = now + delay + (uint64_t)(rng.Float() * (float)jitter);
+    packet.size = (uint32_t)size;
+    memcpy(packet.data, data, size);
+    array_append(DelayedPacket, &delayed, packet);
+    Flush(now);
+}
+
+// NOTE: Sends every delayed packet that is due, jitter may reorder them like a real network would
+void UdpTransport::Flush(uint64_t now)
+{
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < delayed.count; ++i) {
+        if (delayed.items[i].due <= now) {
+            transport_send_now(this, delayed.items[i].data, delayed.items[i].size);
+        } else {
+            delayed.items[kept++] = delayed.items[i];
+        }
+    }
+    delayed.count = kept;
+}
+
+int UdpTransport::Receive(void *data, size_t capacity, uint64_t now)
+{
+    Flush(now);
+    if (fd < 0) return 0;
+    sockaddr_in from = {};
+    socklen_t from_size = sizeof(from);
+    ssize_t n = recvfrom(fd, data, capacity, 0, (sockaddr*)&from, &from_size);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNREFUSED) {
+            fprintf(stderr, "UDP receive failed: %s\n", strerror(errno));
+        }
+        return 0;
+    }
+    // NOTE: Only the configured peer is listened to
+    if (has_peer && (from.sin_addr.s_addr != peer.sin_addr.s_addr || from.sin_port != peer.sin_port)) return 0;
+    received++;
+    return (int)n;
+}
+
+void UdpTransport::stats() const
+{
+    printf("UDP Transport Info: \n");
+    printf("    Sent: %lu (dropped %lu)\n", (unsigned long)sent, (unsigned long)dropped);
+    printf("    Received: %lu\n", (unsigned long)received);
+    printf("    Delay: %lu us (+%lu jitter), loss %.2f\n", (unsigned long)delay, (unsigned long)jitter, loss);
+}
+
+bool parse_address(const char *address, char *host, size_t host_capacity, uint16_t *port)
+{
+    const char *colon = strrchr(address, ':');
+    if (colon == nullptr || (size_t)(colon - address) >= host_capacity) return false;
+    memcpy(host, address, colon - address);
+    host[colon - address] = '\0';
+    char *end = nullptr;
+    long value = strtol(colon + 1, &end, 10);
+    if (*end != '\0' || value <= 0 || value > 65535) return false;
+    *port = (uint16_t)value;
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef NET_H_
+#define NET_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <netinet/in.h>
+
+#include "../util/array.h"
+#include "./random.hpp"
+
+// Non-blocking UDP socket to a single peer. For testing over loopback the
+// sender can hold packets back (delay) and drop them (loss); both are applied
+// on Send, and delayed packets go out on the next Send/Receive after they are
+// due. Times are in microseconds from any monotonic clock the caller likes.
+
+#define NET_MAX_PACKET 512
+
+struct DelayedPacket {
+    uint64_t due;
+    uint32_t size;
+    uint8_t data[NET_MAX_PACKET];
+};
+
+typedef ARRAY(DelayedPacket) DelayedPackets;
+
+struct UdpTransport {
+    UdpTransport();
+    ~UdpTransport();
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    bool Open(uint16_t port);
+    bool SetPeer(const char *host, uint16_t port);
+    void Send(const void *data, size_t size, uint64_t now);
+    int Receive(void *data, size_t capacity, uint64_t now); // NOTE: bytes read, 0 when nothing is pending
+    void Flush(uint64_t now);
+    void stats() const;
+
+    int fd;
+    sockaddr_in peer;
+    bool has_peer;
+
+    // NOTE: Fault injection, off by default
+    uint64_t delay;    // NOTE: microseconds
+    uint64_t jitter;   // NOTE: microseconds, uniform on top of delay
+    float loss;        // NOTE: probability in [0, 1]
+    Rng rng;
+    DelayedPackets delayed;
+
+    uint64_t sent;
+    uint64_t dropped;
+    uint64_t received;
+};
+
+// NOTE: "host:port", returns false on a malformed address
+bool parse_address(const char *address, char *host, size_t host_capacity, uint16_t *port);
+
+#endif // NET_H_
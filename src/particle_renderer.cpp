@@ -0,0 +1,79 @@
+#include "./breakoutt.hpp"
+
+#define PARTICLE_VERTEX_SHADER "shader/particle.vert"
+#define PARTICLE_FRAGMENT_SHADER "shader/particle.frag"
+
+ParticleRenderer::ParticleRenderer():
+    VAO(0), ProgramId(0), aspectRatioLoc(-1), capacity(0)
+{}
+
+ParticleRenderer::~ParticleRenderer()
+{
+    gl_state.DeleteVertexArray(&VAO);
+    gl_state.DeleteProgram(&ProgramId);
+}
+
+bool ParticleRenderer::Init(uint32_t max_particles)
+{
+    GLuint program = LoadShader(PARTICLE_VERTEX_SHADER, PARTICLE_FRAGMENT_SHADER);
+    if (program == 0) return false;
+    SwapProgram(program);
+
+    capacity = max_particles;
+    if (!stream.Init(capacity * sizeof(ParticleVertex))) return false;
+
+    glGenVertexArrays(1, &VAO);
+    gl_state.BindVertexArray(VAO);
+
+    glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, offsetof(ParticleVertex, x));
+    glVertexAttribBinding(0, 0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribFormat(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(ParticleVertex, color));
+    glVertexAttribBinding(1, 0);
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribFormat(2, 1, GL_FLOAT, GL_FALSE, offsetof(ParticleVertex, size));
+    glVertexAttribBinding(2, 0);
+    glEnableVertexAttribArray(2);
+
+    gl_state.BindVertexArray(0);
+    return true;
+}
+
+bool ParticleRenderer::SwapProgram(GLuint program)
+{
+    gl_state.DeleteProgram(&ProgramId);
+    ProgramId = program;
+    aspectRatioLoc = glGetUniformLocation(ProgramId, "aspectRatio");
+    return true;
+}
+
+static bool swap_particle_program(void *owner, GLuint program)
+{
+    return ((ParticleRenderer*)owner)->SwapProgram(program);
+}
+
+void ParticleRenderer::WatchShaders(ShaderReloader *reloader)
+{
+    reloader->Add(PARTICLE_VERTEX_SHADER, PARTICLE_FRAGMENT_SHADER, this, swap_particle_program);
+}
+
+void ParticleRenderer::Draw(const ParticlePool *pool, float aspect_ratio)
+{
+    if (pool->count == 0) return;
+    GLintptr offset = 0;
+    stream.BeginFrame();
+    ParticleVertex *dst = (ParticleVertex*)stream.Allocate(pool->count * sizeof(ParticleVertex), &offset);
+    if (dst == nullptr) return;
+    uint32_t count = pool->FillVertices(dst);
+    stream.Commit(offset, count * sizeof(ParticleVertex));
+
+    gl_state.UseProgram(ProgramId);
+    glUniform1f(aspectRatioLoc, aspect_ratio);
+    gl_state.Enable(GL_PROGRAM_POINT_SIZE, true);
+    gl_state.BindVertexArray(VAO);
+    glBindVertexBuffer(0, stream.Buffer, offset, sizeof(ParticleVertex));
+    glDrawArrays(GL_POINTS, 0, count);
+    stream.EndFrame();
+}
@@ -0,0 +1,140 @@
+#include "./particles.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cassert>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define PARTICLE_COLUMN_COUNT 8
+
+static uint32_t particle_columns(ParticlePool *pool, SoAColumn *out)
+{
+    out[0] = {(void**)&pool->x, sizeof(float)};
+    out[1] = {(void**)&pool->y, sizeof(float)};
+    out[2] = {(void**)&pool->vx, sizeof(float)};
+    out[3] = {(void**)&pool->vy, sizeof(float)};
+    out[4] = {(void**)&pool->life, sizeof(float)};
+    out[5] = {(void**)&pool->inv_max_life, sizeof(float)};
+    out[6] = {(void**)&pool->size, sizeof(float)};
+    out[7] = {(void**)&pool->color, sizeof(uint32_t)};
+    return PARTICLE_COLUMN_COUNT;
+}
+
+ParticlePool::ParticlePool(uint32_t capacity):
+    x(nullptr), y(nullptr), vx(nullptr), vy(nullptr), life(nullptr),
+    inv_max_life(nullptr), size(nullptr), color(nullptr),
+    count(0), capacity(0), rng()
+{
+    SoAColumn columns[PARTICLE_COLUMN_COUNT];
+    uint32_t n = particle_columns(this, columns);
+    bool borrowed = false;
+    soa_reserve(columns, n, &this->capacity, &borrowed, 0, capacity);
+    // NOTE: soa_reserve rounds up, never grow past the requested budget
+    this->capacity = capacity;
+}
+
+ParticlePool::~ParticlePool()
+{
+    SoAColumn columns[PARTICLE_COLUMN_COUNT];
+    uint32_t n = particle_columns(this, columns);
+    soa_free(columns, n, false);
+}
+
+bool ParticlePool::Spawn(float px, float py, float pvx, float pvy, float plife, uint32_t pcolor, float psize)
+{
+    if (count >= capacity) return false;
+    uint32_t i = count++;
+    x[i] = px;
+    y[i] = py;
+    vx[i] = pvx;
+    vy[i] = pvy;
+    life[i] = plife;
+    inv_max_life[i] = 1.0f / plife;
+    size[i] = psize;
+    color[i] = pcolor;
+    return true;
+}
+
+#define BURST_BATCH 64
+
+// NOTE: One Rng4 step per particle, its four lanes are the angle, speed, life and size
+void ParticlePool::SpawnBurst(float px, float py, uint32_t n, float speed, float plife, uint32_t pcolor)
+{
+    float r[BURST_BATCH * 4];
+    for (uint32_t base = 0; base < n; base += BURST_BATCH) {
+        uint32_t batch = n - base < BURST_BATCH ? n - base : BURST_BATCH;
+        rng.FillFloat(r, batch * 4);
+        for (uint32_t i = 0; i < batch; ++i) {
+            const float *v = &r[i * 4];
+            float angle = v[0] * 2.0f * (float)M_PI;
+            float s = speed * (0.25f + 0.75f * v[1]);
+            float l = plife * (0.5f + 0.5f * v[2]);
+            float sz = 2.0f + 3.0f * v[3];
+            if (!Spawn(px, py, cosf(angle) * s, sinf(angle) * s, l, pcolor, sz)) return;
+        }
+    }
+}
+
+// NOTE: Swap-remove, the particle at the end takes slot i
+void ParticlePool::Kill(uint32_t i)
+{
+    assert(i < count);
+    uint32_t last = --count;
+    x[i] = x[last];
+    y[i] = y[last];
+    vx[i] = vx[last];
+    vy[i] = vy[last];
+    life[i] = life[last];
+    inv_max_life[i] = inv_max_life[last];
+    size[i] = size[last];
+    color[i] = color[last];
+}
+
+void ParticlePool::Update(float dt)
+{
+    uint32_t i = 0;
+#ifdef __SSE2__
+    // NOTE: Columns are SOA_ALIGNMENT aligned, so 4-wide aligned loads are safe
+    const __m128 step = _mm_set1_ps(dt);
+    const __m128 gravity = _mm_set1_ps(PARTICLE_GRAVITY * dt);
+    for (; i + 4 <= count; i += 4) {
+        __m128 pvy = _mm_add_ps(_mm_load_ps(vy + i), gravity);
+        _mm_store_ps(vy + i, pvy);
+        _mm_store_ps(x + i, _mm_add_ps(_mm_load_ps(x + i), _mm_mul_ps(_mm_load_ps(vx + i), step)));
+        _mm_store_ps(y + i, _mm_add_ps(_mm_load_ps(y + i), _mm_mul_ps(pvy, step)));
+        _mm_store_ps(life + i, _mm_sub_ps(_mm_load_ps(life + i), step));
+    }
+#endif
+    for (; i < count; ++i) {
+        vy[i] += PARTICLE_GRAVITY * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        life[i] -= dt;
+    }
+
+    // NOTE: Walk backwards so every particle swapped in has already been checked
+    for (uint32_t j = count; j-- > 0;) {
+        if (life[j] <= 0.0f) Kill(j);
+    }
+}
+
+uint32_t ParticlePool::FillVertices(ParticleVertex *out) const
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        float fade = life[i] * inv_max_life[i];
+        uint32_t alpha = (uint32_t)((color[i] >> 24) * fade);
+        out[i].x = x[i];
+        out[i].y = y[i];
+        out[i].color = (color[i] & 0x00FFFFFFu) | (alpha << 24);
+        out[i].size = size[i];
+    }
+    return count;
+}
+
+void ParticlePool::stats() const
+{
+    printf("Particle Pool: %u / %u live\n", count, capacity);
+}
@@ -0,0 +1,54 @@
+#ifndef PARTICLES_H_
+#define PARTICLES_H_
+
+#include "./game.hpp"
+#include "./random.hpp"
+
+// Fixed capacity SoA particle pool for cosmetic effects (debris, sparks).
+// Spawn appends, kill swap-removes, so both are O(1) and the live particles
+// are always the dense prefix [0, count) of every column.
+
+#define PARTICLE_CAPACITY (128 * 1024)
+#define PARTICLE_GRAVITY -2.5f
+
+// NOTE: One streamed vertex per particle, drawn as a point sprite
+struct ParticleVertex {
+    float x;
+    float y;
+    uint32_t color; // NOTE: RGBA8, alpha already faded by remaining life
+    float size;
+};
+
+struct ParticlePool {
+    ParticlePool(uint32_t capacity);
+    ~ParticlePool();
+    ParticlePool(const ParticlePool&) = delete;
+    ParticlePool& operator=(const ParticlePool&) = delete;
+
+    bool Spawn(float x, float y, float vx, float vy, float life, uint32_t color, float size);
+    void SpawnBurst(float x, float y, uint32_t count, float speed, float life, uint32_t color);
+    void Kill(uint32_t i);
+    void Update(float dt);
+    uint32_t FillVertices(ParticleVertex *out) const;
+    void stats() const;
+
+    float *x;
+    float *y;
+    float *vx;
+    float *vy;
+    float *life;
+    float *inv_max_life;
+    float *size;
+    uint32_t *color;
+    uint32_t count;
+    uint32_t capacity;
+    Rng4 rng; // NOTE: burst directions, speeds, lifetimes and sizes
+};
+
+static inline uint32_t pack_color(float r, float g, float b, float a)
+{
+    return ((uint32_t)(r * 255.0f)) | ((uint32_t)(g * 255.0f) << 8) |
+           ((uint32_t)(b * 255.0f) << 16) | ((uint32_t)(a * 255.0f) << 24);
+}
+
+#endif // PARTICLES_H_
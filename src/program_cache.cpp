@@ -0,0 +1,132 @@
+#include "./program_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct ProgramCacheHeader {
+    BlockFileHeader file;
+    uint64_t key;
+    uint32_t format; // NOTE: GLenum binary format the driver reported
+    uint32_t reserved;
+};
+
+uint64_t ProgramCacheKey(const char *const *parts, uint32_t count)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t i = 0; i < count; ++i) {
+        const unsigned char *p = (const unsigned char*)(parts[i] ? parts[i] : "");
+        for (; *p; ++p) {
+            hash ^= *p;
+            hash *= 1099511628211ull;
+        }
+        hash ^= 0xFF; // NOTE: never part of valid UTF-8 text
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool ProgramCachePath(char *path, size_t size, const char *dir, uint64_t key)
+{
+    int n = snprintf(path, size, "%s/%016llx.prog", dir, (unsigned long long)key);
+    return n > 0 && (size_t)n < size;
+}
+
+static bool make_dirs(const char *dir)
+{
+    char path[PROGRAM_CACHE_PATH_LENGTH];
+    size_t len = strlen(dir);
+    if (len == 0 || len >= sizeof(path)) return false;
+    memcpy(path, dir, len + 1);
+    for (size_t i = 1; i <= len; ++i) {
+        if (path[i] != '/' && path[i] != '\0') continue;
+        char saved = path[i];
+        path[i] = '\0';
+        if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+            fprintf(stderr, "Failed to create %s: %s.\n", path, strerror(errno));
+            return false;
+        }
+        path[i] = saved;
+    }
+    return true;
+}
+
+bool SaveProgramBinary(const char *dir, uint64_t key, uint32_t format, const void *binary, uint32_t size)
+{
+    char path[PROGRAM_CACHE_PATH_LENGTH];
+    char temp[PROGRAM_CACHE_PATH_LENGTH + 32];
+    if (!ProgramCachePath(path, sizeof(path), dir, key) || !make_dirs(dir)) return false;
+    snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long)getpid());
+
+    void *data = (void*)binary;
+    SoAColumn column = {&data, 1};
+    ProgramCacheHeader header = {};
+    header.key = key;
+    header.format = format;
+    if (!blockfile_write(temp, &header, sizeof(header), PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, &column, &size, 1)) {
+        unlink(temp);
+        return false;
+    }
+    if (rename(temp, path) < 0) {
+        fprintf(stderr, "Failed to move %s into place: %s.\n", path, strerror(errno));
+        unlink(temp);
+        return false;
+    }
+    return true;
+}
+
+ProgramBinary::ProgramBinary():
+    format(0), data(nullptr), size(0), mapping(nullptr), mapping_size(0)
+{}
+
+ProgramBinary::~ProgramBinary()
+{
+    Reset();
+}
+
+void ProgramBinary::Reset()
+{
+    if (mapping) munmap(mapping, mapping_size);
+    format = 0;
+    data = nullptr;
+    size = 0;
+    mapping = nullptr;
+    mapping_size = 0;
+}
+
+bool LoadProgramBinary(const char *dir, uint64_t key, ProgramBinary *binary)
+{
+    char path[PROGRAM_CACHE_PATH_LENGTH];
+    if (!ProgramCachePath(path, sizeof(path), dir, key) || access(path, R_OK) != 0) return false;
+
+    void *data = nullptr;
+    SoAColumn column = {&data, 1};
+    size_t size = 0;
+    void *mapping = blockfile_map(path, &size, PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, sizeof(ProgramCacheHeader), &column, 1);
+    if (mapping == nullptr) return false;
+
+    const ProgramCacheHeader *header = (const ProgramCacheHeader*)mapping;
+    const BlockFileBlock *blocks = blockfile_blocks(mapping);
+    if (header->key != key || blocks[0].count == 0) {
+        fprintf(stderr, "%s: stored under another key or empty.\n", path);
+        munmap(mapping, size);
+        return false;
+    }
+
+    binary->Reset();
+    binary->format = header->format;
+    binary->data = (const char*)mapping + blocks[0].offset;
+    binary->size = blocks[0].count;
+    binary->mapping = mapping;
+    binary->mapping_size = size;
+    return true;
+}
+
+void RemoveProgramBinary(const char *dir, uint64_t key)
+{
+    char path[PROGRAM_CACHE_PATH_LENGTH];
+    if (ProgramCachePath(path, sizeof(path), dir, key)) unlink(path);
+}
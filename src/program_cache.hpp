@@ -0,0 +1,46 @@
+#ifndef PROGRAM_CACHE_H_
+#define PROGRAM_CACHE_H_
+
+#include "./blockfile.hpp"
+
+// On-disk cache of linked shader program binaries (glGetProgramBinary).
+//
+// An entry is keyed by a 64 bit FNV-1a hash over every shader source of the
+// program and the driver's vendor, renderer, version and GLSL version
+// strings, so a shader edit or a driver update misses instead of feeding the
+// driver a binary it may not take. Each entry is a block file named after its
+// key, written to a temporary name and renamed into place so a crash or a
+// second instance never leaves half an entry behind. The GL side lives in
+// shaders.cpp; this part only hashes, stores and maps bytes.
+
+#define PROGRAM_CACHE_MAGIC "BRKPROG"
+#define PROGRAM_CACHE_VERSION 1
+#define PROGRAM_CACHE_PATH_LENGTH 512
+
+// NOTE: `parts` are NUL terminated, a separator is hashed between them so moving text across parts changes the key
+uint64_t ProgramCacheKey(const char *const *parts, uint32_t count);
+bool ProgramCachePath(char *path, size_t size, const char *dir, uint64_t key);
+// NOTE: Creates `dir` and its parents if needed
+bool SaveProgramBinary(const char *dir, uint64_t key, uint32_t format, const void *binary, uint32_t size);
+
+struct ProgramBinary {
+    ProgramBinary();
+    ~ProgramBinary();
+    ProgramBinary(const ProgramBinary&) = delete;
+    ProgramBinary& operator=(const ProgramBinary&) = delete;
+
+    void Reset();
+
+    uint32_t format;
+    const void *data; // NOTE: points into the mapping
+    uint32_t size;
+    void *mapping;
+    size_t mapping_size;
+};
+
+// NOTE: A missing entry is a quiet miss, a corrupt one or one stored under another key is reported
+bool LoadProgramBinary(const char *dir, uint64_t key, ProgramBinary *binary);
+// NOTE: Drops an entry the driver rejected so the next launch does not try it again
+void RemoveProgramBinary(const char *dir, uint64_t key);
+
+#endif // PROGRAM_CACHE_H_
@@ -0,0 +1,208 @@
+#include "./random.hpp"
+
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+Rng::Rng():
+    s()
+{
+    Seed(0);
+}
+
+Rng::Rng(uint64_t seed):
+    s()
+{
+    Seed(seed);
+}
+
+// NOTE: splitmix64 spreads small user seeds (0, 1, 2...) over the whole state
+void Rng::Seed(uint64_t seed)
+{
+    uint64_t x = seed;
+    uint64_t a = splitmix64(&x);
+    uint64_t b = splitmix64(&x);
+    s[0] = (uint32_t)a;
+    s[1] = (uint32_t)(a >> 32);
+    s[2] = (uint32_t)b;
+    s[3] = (uint32_t)(b >> 32);
+    if ((s[0] | s[1] | s[2] | s[3]) == 0) s[0] = 1; // NOTE: the all zero state is a fixed point
+}
+
+static void rng_jump(Rng *rng, const uint32_t *table)
+{
+    uint32_t t[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+        for (int b = 0; b < 32; ++b) {
+            if (table[i] & (1u << b)) {
+                t[0] ^= rng->s[0];
+                t[1] ^= rng->s[1];
+                t[2] ^= rng->s[2];
+                t[3] ^= rng->s[3];
+            }
+            rng->Next();
+        }
+    }
+    memcpy(rng->s, t, sizeof(t));
+}
+
+void Rng::Jump()
+{
+    static const uint32_t table[4] = {0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b};
+    rng_jump(this, table);
+}
+
+void Rng::LongJump()
+{
+    static const uint32_t table[4] = {0xb523952e, 0x0b6f099f, 0xccf5a0ef, 0x1c580662};
+    rng_jump(this, table);
+}
+
+Rng Rng::Split()
+{
+    Rng child = *this;
+    Jump();
+    return child;
+}
+
+// NOTE: Lemire's multiply-shift, the rare biased low products are rejected
+uint32_t Rng::Below(uint32_t bound)
+{
+    if (bound == 0) return 0;
+    uint64_t m = (uint64_t)Next() * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (uint64_t)Next() * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+void Rng::Fill(uint32_t *out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) out[i] = Next();
+}
+
+Rng4::Rng4():
+    s()
+{
+    Rng source;
+    *this = Rng4(&source);
+}
+
+Rng4::Rng4(Rng *source):
+    s()
+{
+    for (int lane = 0; lane < 4; ++lane) {
+        Rng stream = source->Split();
+        for (int word = 0; word < 4; ++word) s[word][lane] = stream.s[word];
+    }
+}
+
+#ifdef __SSE2__
+static inline __m128i rotl4(__m128i x, int k)
+{
+    return _mm_or_si128(_mm_slli_epi32(x, k), _mm_srli_epi32(x, 32 - k));
+}
+
+// NOTE: One xoshiro128++ step of all four lanes, same math as Rng::Next
+static inline __m128i rng4_next(__m128i *s0, __m128i *s1, __m128i *s2, __m128i *s3)
+{
+    __m128i result = _mm_add_epi32(rotl4(_mm_add_epi32(*s0, *s3), 7), *s0);
+    __m128i t = _mm_slli_epi32(*s1, 9);
+    *s2 = _mm_xor_si128(*s2, *s0);
+    *s3 = _mm_xor_si128(*s3, *s1);
+    *s1 = _mm_xor_si128(*s1, *s2);
+    *s0 = _mm_xor_si128(*s0, *s3);
+    *s2 = _mm_xor_si128(*s2, t);
+    *s3 = rotl4(*s3, 11);
+    return result;
+}
+
+void Rng4::Fill(uint32_t *out, size_t count)
+{
+    __m128i s0 = _mm_load_si128((const __m128i*)s[0]);
+    __m128i s1 = _mm_load_si128((const __m128i*)s[1]);
+    __m128i s2 = _mm_load_si128((const __m128i*)s[2]);
+    __m128i s3 = _mm_load_si128((const __m128i*)s[3]);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(out + i), rng4_next(&s0, &s1, &s2, &s3));
+    }
+    if (i < count) {
+        alignas(16) uint32_t tail[4];
+        _mm_store_si128((__m128i*)tail, rng4_next(&s0, &s1, &s2, &s3));
+        memcpy(out + i, tail, (count - i) * sizeof(uint32_t));
+    }
+    _mm_store_si128((__m128i*)s[0], s0);
+    _mm_store_si128((__m128i*)s[1], s1);
+    _mm_store_si128((__m128i*)s[2], s2);
+    _mm_store_si128((__m128i*)s[3], s3);
+}
+
+void Rng4::FillFloat(float *out, size_t count)
+{
+    __m128i s0 = _mm_load_si128((const __m128i*)s[0]);
+    __m128i s1 = _mm_load_si128((const __m128i*)s[1]);
+    __m128i s2 = _mm_load_si128((const __m128i*)s[2]);
+    __m128i s3 = _mm_load_si128((const __m128i*)s[3]);
+    const __m128 scale = _mm_set1_ps(1.0f / 16777216.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i bits = _mm_srli_epi32(rng4_next(&s0, &s1, &s2, &s3), 8);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(bits), scale));
+    }
+    if (i < count) {
+        alignas(16) float tail[4];
+        __m128i bits = _mm_srli_epi32(rng4_next(&s0, &s1, &s2, &s3), 8);
+        _mm_store_ps(tail, _mm_mul_ps(_mm_cvtepi32_ps(bits), scale));
+        memcpy(out + i, tail, (count - i) * sizeof(float));
+    }
+    _mm_store_si128((__m128i*)s[0], s0);
+    _mm_store_si128((__m128i*)s[1], s1);
+    _mm_store_si128((__m128i*)s[2], s2);
+    _mm_store_si128((__m128i*)s[3], s3);
+}
+#else
+static inline void rng4_next(uint32_t s[4][4], uint32_t *out)
+{
+    for (int lane = 0; lane < 4; ++lane) {
+        Rng stream;
+        for (int word = 0; word < 4; ++word) stream.s[word] = s[word][lane];
+        out[lane] = stream.Next();
+        for (int word = 0; word < 4; ++word) s[word][lane] = stream.s[word];
+    }
+}
+
+void Rng4::Fill(uint32_t *out, size_t count)
+{
+    uint32_t group[4];
+    for (size_t i = 0; i < count; i += 4) {
+        rng4_next(s, group);
+        size_t n = count - i < 4 ? count - i : 4;
+        memcpy(out + i, group, n * sizeof(uint32_t));
+    }
+}
+
+void Rng4::FillFloat(float *out, size_t count)
+{
+    uint32_t group[4];
+    for (size_t i = 0; i < count; i += 4) {
+        rng4_next(s, group);
+        size_t n = count - i < 4 ? count - i : 4;
+        for (size_t k = 0; k < n; ++k) out[i + k] = (group[k] >> 8) * (1.0f / 16777216.0f);
+    }
+}
+#endif
@@ -0,0 +1,62 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <cstdint>
+#include <cstddef>
+
+// Seedable xoshiro128++ generator, 16 bytes of state per stream.
+//
+// Every subsystem owns its own Rng instead of sharing rand()'s hidden global,
+// so results are reproducible across libc versions and safe across threads.
+// Independent streams come from Split(): the child gets the current state and
+// the parent jumps 2^64 values ahead, so streams handed to threads, envs or
+// level chunks never overlap.
+//
+// Rng4 steps four such streams side by side (SSE2 when available, the scalar
+// path gives the same values) for bulk fills.
+
+struct Rng {
+    Rng();
+    Rng(uint64_t seed);
+
+    void Seed(uint64_t seed);
+    void Jump();      // NOTE: 2^64 values ahead
+    void LongJump();  // NOTE: 2^96 values ahead, for splitting off whole groups of streams
+    Rng Split();
+
+    inline uint32_t Next()
+    {
+        uint32_t result = rotl(s[0] + s[3], 7) + s[0];
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+
+    // NOTE: [0, 1) with 24 bits, every value exactly representable
+    inline float Float() { return (Next() >> 8) * (1.0f / 16777216.0f); }
+    inline float Range(float min, float max) { return min + (max - min) * Float(); }
+    uint32_t Below(uint32_t bound); // NOTE: unbiased [0, bound)
+    void Fill(uint32_t *out, size_t count);
+
+    static inline uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+    uint32_t s[4];
+};
+
+struct Rng4 {
+    Rng4();
+    Rng4(Rng *source); // NOTE: the four lanes are split off source
+
+    // NOTE: Interleaved, out[4*i + lane] is the i-th value of lane, a partial last group still steps all lanes
+    void Fill(uint32_t *out, size_t count);
+    void FillFloat(float *out, size_t count);
+
+    alignas(16) uint32_t s[4][4]; // NOTE: s[word][lane], one lane per SSE element
+};
+
+#endif // RANDOM_H_
@@ -0,0 +1,159 @@
+#include "./rollback.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+#define RING_SLOT(tick) ((tick) & (ROLLBACK_RING - 1))
+#define NO_TICK UINT64_MAX
+
+RollbackSession::RollbackSession(uint32_t local_player, uint32_t input_delay):
+    local_player(local_player),
+    input_delay(input_delay > ROLLBACK_MAX_INPUT_DELAY ? ROLLBACK_MAX_INPUT_DELAY : input_delay),
+    current(0), local_next(0), remote_confirmed(0), remote_ack(0), rollback_from(NO_TICK),
+    local_inputs(), remote_inputs(), remote_tick(), predicted(), states(), state_tick(),
+    peer_checksum_tick(NO_TICK), peer_checksum(0),
+    rollbacks(0), resimulated(0), max_resimulated(0), stalls(0), desyncs(0)
+{
+    assert(local_player < 2 && "Rollback sessions are for two players");
+    for (uint32_t i = 0; i < ROLLBACK_RING; ++i) {
+        remote_tick[i] = NO_TICK;
+        state_tick[i] = NO_TICK;
+    }
+    // NOTE: The first input_delay ticks have no local input, they are sent as INPUT_NONE
+    while (local_next < this->input_delay) local_inputs[RING_SLOT(local_next++)] = INPUT_NONE;
+}
+
+RollbackSession::~RollbackSession()
+{
+    for (uint32_t i = 0; i < ROLLBACK_RING; ++i) state_buffer_free(&states[i]);
+}
+
+bool RollbackSession::AddLocalInput(uint8_t input)
+{
+    if (local_next > current + input_delay) return false;
+    if (local_next - remote_ack >= ROLLBACK_RING) return false;
+    local_inputs[RING_SLOT(local_next++)] = input;
+    return true;
+}
+
+void RollbackSession::AddRemoteInput(uint64_t tick, uint8_t input)
+{
+    if (tick < remote_confirmed || tick >= remote_confirmed + ROLLBACK_RING) return;
+    remote_inputs[RING_SLOT(tick)] = input;
+    remote_tick[RING_SLOT(tick)] = tick;
+
+    while (remote_tick[RING_SLOT(remote_confirmed)] == remote_confirmed) {
+        uint64_t confirmed = remote_confirmed++;
+        if (confirmed < current && predicted[RING_SLOT(confirmed)] != remote_inputs[RING_SLOT(confirmed)]) {
+            if (confirmed < rollback_from) rollback_from = confirmed;
+        }
+    }
+}
+
+static void simulate_tick(RollbackSession *session, Game *game, uint64_t tick)
+{
+    uint32_t slot = RING_SLOT(tick);
+    SaveState(game, &session->states[slot]);
+    session->state_tick[slot] = tick;
+
+    uint8_t remote = INPUT_NONE;
+    if (tick < session->remote_confirmed) remote = session->remote_inputs[slot];
+    else if (session->remote_confirmed > 0) remote = session->remote_inputs[RING_SLOT(session->remote_confirmed - 1)];
+    session->predicted[slot] = remote;
+
+    uint8_t inputs[MAX_PADDLES] = {};
+    inputs[session->local_player] = session->local_inputs[slot];
+    inputs[1 - session->local_player] = remote;
+    game->GameUpdate(inputs);
+}
+
+// NOTE: Compares against the peer once our own state for that tick is final
+static void check_peer_checksum(RollbackSession *session)
+{
+    uint64_t tick = session->peer_checksum_tick;
+    if (tick == NO_TICK || tick > session->remote_confirmed || tick > session->current) return;
+    session->peer_checksum_tick = NO_TICK;
+    uint32_t slot = RING_SLOT(tick);
+    if (session->state_tick[slot] != tick) return;
+    if (StateChecksum(&session->states[slot]) != session->peer_checksum) {
+        if (session->desyncs++ == 0) fprintf(stderr, "WARNING: Rollback desync at tick %lu\n", (unsigned long)tick);
+    }
+}
+
+bool RollbackSession::AdvanceFrame(Game *game)
+{
+    if (rollback_from < current) {
+        uint64_t from = rollback_from;
+        assert(state_tick[RING_SLOT(from)] == from && "Rollback past the state ring");
+        LoadState(game, &states[RING_SLOT(from)]);
+        for (uint64_t tick = from; tick < current; ++tick) simulate_tick(this, game, tick);
+
+        uint32_t count = (uint32_t)(current - from);
+        rollbacks++;
+        resimulated += count;
+        if (count > max_resimulated) max_resimulated = count;
+    }
+    rollback_from = NO_TICK;
+    check_peer_checksum(this);
+
+    if (current >= local_next) return false;
+    if (current >= remote_confirmed + ROLLBACK_MAX_PREDICTION) {
+        stalls++;
+        return false;
+    }
+    simulate_tick(this, game, current++);
+    return true;
+}
+
+size_t RollbackSession::BuildPacket(RollbackPacket *packet)
+{
+    packet->magic = ROLLBACK_MAGIC;
+    packet->start = remote_ack;
+    packet->count = (uint32_t)(local_next - remote_ack);
+    packet->ack = remote_confirmed;
+    for (uint32_t i = 0; i < packet->count; ++i) {
+        packet->inputs[i] = local_inputs[RING_SLOT(remote_ack + i)];
+    }
+
+    // NOTE: Newest state that only depends on confirmed input and is not waiting for a rollback
+    uint64_t tick = remote_confirmed < current ? remote_confirmed : current;
+    if (rollback_from < tick) tick = rollback_from;
+    if (tick > 0 && state_tick[RING_SLOT(tick)] != tick) tick--;
+    packet->checksum_tick = NO_TICK;
+    packet->checksum = 0;
+    if (state_tick[RING_SLOT(tick)] == tick) {
+        packet->checksum_tick = tick;
+        packet->checksum = StateChecksum(&states[RING_SLOT(tick)]);
+    }
+    packet->reserved = 0;
+    return offsetof(RollbackPacket, inputs) + packet->count;
+}
+
+bool RollbackSession::ReadPacket(const void *data, size_t size)
+{
+    RollbackPacket packet;
+    if (size < offsetof(RollbackPacket, inputs) || size > sizeof(packet)) return false;
+    memcpy(&packet, data, size);
+    if (packet.magic != ROLLBACK_MAGIC || packet.count > ROLLBACK_RING ||
+        offsetof(RollbackPacket, inputs) + packet.count != size) return false;
+
+    if (packet.ack > remote_ack && packet.ack <= local_next) remote_ack = packet.ack;
+    for (uint32_t i = 0; i < packet.count; ++i) AddRemoteInput(packet.start + i, packet.inputs[i]);
+    if (packet.checksum_tick != NO_TICK) {
+        peer_checksum_tick = packet.checksum_tick;
+        peer_checksum = packet.checksum;
+    }
+    return true;
+}
+
+void RollbackSession::stats() const
+{
+    printf("Rollback Info: \n");
+    printf("    Player: %u, input delay %u\n", local_player, input_delay);
+    printf("    Tick: %lu (remote confirmed %lu)\n", (unsigned long)current, (unsigned long)remote_confirmed);
+    printf("    Rollbacks: %lu, resimulated %lu ticks, longest %u\n",
+           (unsigned long)rollbacks, (unsigned long)resimulated, max_resimulated);
+    printf("    Stalls: %lu\n", (unsigned long)stalls);
+    printf("    Desyncs: %lu\n", (unsigned long)desyncs);
+}
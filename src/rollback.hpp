@@ -0,0 +1,75 @@
+#ifndef ROLLBACK_H_
+#define ROLLBACK_H_
+
+#include "./game.hpp"
+
+// Rollback session for two players, one paddle each (player index ==
+// paddle index).
+//
+// Local input is applied after `input_delay` ticks and never waits for the
+// network. The remote input of a tick that has not arrived yet is predicted
+// as the last confirmed one. Every simulated tick saves the state it started
+// from into a ring; when a confirmed remote input turns out to differ from
+// the prediction, the state of that tick is restored and the ticks up to the
+// present are simulated again. The simulation stalls instead of predicting
+// more than ROLLBACK_MAX_PREDICTION ticks ahead of the remote input.
+//
+// Sessions exchange RollbackPackets, each one carrying every local input the
+// peer has not acknowledged yet, so lost packets are covered by the next one.
+// Both peers must start from the same Game state.
+
+#define ROLLBACK_MAX_PREDICTION 8
+#define ROLLBACK_MAX_INPUT_DELAY 4
+#define ROLLBACK_RING 64 // NOTE: power of two, covers unacknowledged inputs of both peers
+#define ROLLBACK_MAGIC 0x4E4B5242u // NOTE: "BRKN"
+
+struct RollbackPacket {
+    uint32_t magic;
+    uint32_t count;         // NOTE: inputs carried
+    uint64_t start;         // NOTE: tick of inputs[0]
+    uint64_t ack;           // NOTE: the sender has the receiver's inputs for ticks < ack
+    uint64_t checksum_tick; // NOTE: UINT64_MAX when no confirmed state is available
+    uint32_t checksum;
+    uint32_t reserved;
+    uint8_t inputs[ROLLBACK_RING];
+};
+
+struct RollbackSession {
+    RollbackSession(uint32_t local_player, uint32_t input_delay);
+    ~RollbackSession();
+    RollbackSession(const RollbackSession&) = delete;
+    RollbackSession& operator=(const RollbackSession&) = delete;
+
+    bool AddLocalInput(uint8_t input); // NOTE: false while the input queue is full
+    void AddRemoteInput(uint64_t tick, uint8_t input);
+    bool AdvanceFrame(Game *game);     // NOTE: false while stalled on input
+    size_t BuildPacket(RollbackPacket *packet);
+    bool ReadPacket(const void *data, size_t size);
+    void stats() const;
+
+    uint32_t local_player;
+    uint32_t input_delay;
+    uint64_t current;          // NOTE: next tick to simulate
+    uint64_t local_next;       // NOTE: local inputs are known for ticks < local_next
+    uint64_t remote_confirmed; // NOTE: remote inputs are known for ticks < remote_confirmed
+    uint64_t remote_ack;       // NOTE: the peer has our inputs for ticks < remote_ack
+    uint64_t rollback_from;    // NOTE: earliest mispredicted tick, UINT64_MAX if none
+
+    uint8_t local_inputs[ROLLBACK_RING];
+    uint8_t remote_inputs[ROLLBACK_RING];
+    uint64_t remote_tick[ROLLBACK_RING]; // NOTE: tick held by each remote_inputs slot
+    uint8_t predicted[ROLLBACK_RING];    // NOTE: remote input a tick was last simulated with
+    StateBuffer states[ROLLBACK_RING];
+    uint64_t state_tick[ROLLBACK_RING];
+
+    uint64_t peer_checksum_tick;
+    uint32_t peer_checksum;
+
+    uint64_t rollbacks;
+    uint64_t resimulated; // NOTE: ticks simulated again
+    uint32_t max_resimulated;
+    uint64_t stalls;
+    uint64_t desyncs;
+};
+
+#endif // ROLLBACK_H_
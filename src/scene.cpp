@@ -0,0 +1,101 @@
+#include "./scene.hpp"
+
+SceneGraph::SceneGraph():
+    updates(0), rebuilt(0)
+{
+    array_new(&nodes, SceneNode);
+    array_new(&world, Matrix4);
+    array_new(&dirty, uint8_t);
+}
+
+SceneGraph::~SceneGraph()
+{
+    array_delete(&nodes);
+    array_delete(&world);
+    array_delete(&dirty);
+}
+
+uint32_t SceneGraph::AddNode(uint32_t parent, float x, float y)
+{
+    assert((parent == SCENE_NO_PARENT || parent < nodes.count) && "Parent must be added before its children");
+    SceneNode node = {parent, x, y, 0.0f, 1.0f, 1.0f};
+    Matrix4 identity = Matrix4().identity();
+    uint8_t is_dirty = 1;
+    array_append(SceneNode, &nodes, node);
+    array_append(Matrix4, &world, identity);
+    array_append(uint8_t, &dirty, is_dirty);
+    return nodes.count - 1;
+}
+
+void SceneGraph::SetPosition(uint32_t node, float x, float y)
+{
+    assert(node < nodes.count);
+    SceneNode *n = &nodes.items[node];
+    if (n->x == x && n->y == y) return;
+    n->x = x;
+    n->y = y;
+    dirty.items[node] = 1;
+}
+
+void SceneGraph::SetRotation(uint32_t node, float degrees)
+{
+    assert(node < nodes.count);
+    if (nodes.items[node].rotation == degrees) return;
+    nodes.items[node].rotation = degrees;
+    dirty.items[node] = 1;
+}
+
+void SceneGraph::SetScale(uint32_t node, float scale_x, float scale_y)
+{
+    assert(node < nodes.count);
+    SceneNode *n = &nodes.items[node];
+    if (n->scale_x == scale_x && n->scale_y == scale_y) return;
+    n->scale_x = scale_x;
+    n->scale_y = scale_y;
+    dirty.items[node] = 1;
+}
+
+// NOTE: T * R * S, scale first so a scaled brick still rotates about its own center
+static Matrix4 local_matrix(const SceneNode *node)
+{
+    Matrix4 m = Matrix4().translate(Vector4(node->x, node->y, 0.0f, Vector4Type::Point));
+    if (node->rotation != 0.0f) m = m * Matrix4().rotate_z(node->rotation);
+    if (node->scale_x != 1.0f || node->scale_y != 1.0f) {
+        m = m * Matrix4().scale(Vector4(node->scale_x, node->scale_y, 1.0f, Vector4Type::Direction));
+    }
+    return m;
+}
+
+uint32_t SceneGraph::Update()
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < nodes.count; ++i) {
+        const SceneNode *node = &nodes.items[i];
+        // NOTE: The parent is already final for this pass, its flag says whether it moved
+        if (node->parent != SCENE_NO_PARENT && dirty.items[node->parent]) dirty.items[i] = 1;
+        if (!dirty.items[i]) continue;
+
+        Matrix4 local = local_matrix(node);
+        world.items[i] = node->parent == SCENE_NO_PARENT ? local : world.items[node->parent] * local;
+        count++;
+    }
+    memset(dirty.items, 0, dirty.count);
+    updates++;
+    rebuilt += count;
+    return count;
+}
+
+const Matrix4 *SceneGraph::World(uint32_t node) const
+{
+    assert(node < nodes.count);
+    return &world.items[node];
+}
+
+void SceneGraph::stats() const
+{
+    printf("Scene Graph Info: \n");
+    printf("    Nodes: %u\n", nodes.count);
+    printf("    Updates: %lu\n", (unsigned long)updates);
+    printf("    World matrices rebuilt: %lu (%.2f per update)\n", (unsigned long)rebuilt,
+           updates ? (double)rebuilt / (double)updates : 0.0);
+}
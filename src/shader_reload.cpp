@@ -0,0 +1,93 @@
+#include "./breakoutt.hpp"
+
+ShaderReloader::ShaderReloader():
+    entries({nullptr, 0, 0}), started(false), reloads(0), failures(0)
+{}
+
+ShaderReloader::~ShaderReloader()
+{
+    watch.Stop();
+    array_delete(&entries);
+}
+
+bool ShaderReloader::Start(const char *dir)
+{
+    started = watch.Start(dir);
+    if (started) printf("Watching %s for shader changes\n", dir);
+    return started;
+}
+
+static void add_entry(ShaderReloader *reloader, const char *first_path, const char *second_path,
+                      void *owner, ProgramSwapFn swap)
+{
+    ShaderReloadEntry entry = {};
+    if (strlen(first_path) >= SHADER_RELOAD_PATH_LENGTH ||
+        (second_path && strlen(second_path) >= SHADER_RELOAD_PATH_LENGTH)) {
+        fprintf(stderr, "Shader path too long to watch: %s.\n", first_path);
+        return;
+    }
+    strcpy(entry.first_path, first_path);
+    if (second_path) strcpy(entry.second_path, second_path);
+    entry.owner = owner;
+    entry.swap = swap;
+    if (reloader->entries.items == nullptr) array_new(&reloader->entries, ShaderReloadEntry);
+    array_append(ShaderReloadEntry, &reloader->entries, entry);
+}
+
+void ShaderReloader::Add(const char *vertex_path, const char *fragment_path, void *owner, ProgramSwapFn swap)
+{
+    add_entry(this, vertex_path, fragment_path, owner, swap);
+}
+
+void ShaderReloader::AddCompute(const char *compute_path, void *owner, ProgramSwapFn swap)
+{
+    add_entry(this, compute_path, nullptr, owner, swap);
+}
+
+// NOTE: The watch reports bare file names, programs name their files by path
+static bool path_changed(const char *path, const ShaderWatchChanges *changes)
+{
+    if (path[0] == '\0') return false;
+    if (changes->all) return true;
+    const char *slash = strrchr(path, '/');
+    const char *name = slash ? slash + 1 : path;
+    for (uint32_t i = 0; i < changes->count; ++i) {
+        if (strcmp(changes->names[i], name) == 0) return true;
+    }
+    return false;
+}
+
+void ShaderReloader::Poll()
+{
+    if (!started || !watch.Pending()) return;
+    ShaderWatchChanges changes;
+    watch.TakeChanges(&changes);
+
+    for (uint32_t i = 0; i < entries.count; ++i) {
+        const ShaderReloadEntry *entry = &entries.items[i];
+        if (!path_changed(entry->first_path, &changes) && !path_changed(entry->second_path, &changes)) continue;
+
+        printf("Reloading %s%s%s\n", entry->first_path, entry->second_path[0] ? " + " : "", entry->second_path);
+        GLuint program = entry->second_path[0] ? LoadShader(entry->first_path, entry->second_path)
+                                               : LoadComputeShader(entry->first_path);
+        if (program != 0 && entry->swap(entry->owner, program)) {
+            reloads++;
+            continue;
+        }
+        // NOTE: The old program was never touched, it keeps drawing
+        if (program != 0) glDeleteProgram(program);
+        fprintf(stderr, "Keeping the previous program for %s.\n", entry->first_path);
+        failures++;
+    }
+}
+
+void ShaderReloader::stats() const
+{
+    printf("Shader Reload Info: \n");
+    if (!started) {
+        printf("    Not watching\n");
+        return;
+    }
+    printf("    Programs: %u, Reloads: %lu, Failures: %lu, Events: %lu\n",
+           entries.count, (unsigned long)reloads, (unsigned long)failures, (unsigned long)watch.events);
+}
@@ -0,0 +1,108 @@
+#include "./shader_watch.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+ShaderWatch::ShaderWatch():
+    inotify_fd(-1), wake_fd(-1), pending(false), collected(), events(0)
+{}
+
+ShaderWatch::~ShaderWatch()
+{
+    Stop();
+}
+
+static void collect_change(ShaderWatchChanges *changes, const struct inotify_event *event)
+{
+    if (event->mask & IN_Q_OVERFLOW) {
+        changes->all = true;
+        return;
+    }
+    if (event->len == 0 || event->mask & IN_ISDIR) return;
+    if (strlen(event->name) >= SHADER_WATCH_NAME_LENGTH) return; // NOTE: can't be a watched shader
+    for (uint32_t i = 0; i < changes->count; ++i) {
+        if (strcmp(changes->names[i], event->name) == 0) return;
+    }
+    if (changes->count == SHADER_WATCH_MAX_CHANGED) {
+        changes->all = true;
+        return;
+    }
+    strcpy(changes->names[changes->count++], event->name);
+}
+
+static void watch_worker(ShaderWatch *watch)
+{
+    alignas(struct inotify_event) char buffer[4096];
+    struct pollfd fds[2] = {{watch->inotify_fd, POLLIN, 0}, {watch->wake_fd, POLLIN, 0}};
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Shader watch poll failed: %s.\n", strerror(errno));
+            return;
+        }
+        if (fds[1].revents & POLLIN) return;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        ssize_t n = read(watch->inotify_fd, buffer, sizeof(buffer));
+        if (n <= 0) continue;
+        std::lock_guard<std::mutex> guard(watch->lock);
+        for (ssize_t offset = 0; offset < n;) {
+            const struct inotify_event *event = (const struct inotify_event*)(buffer + offset);
+            collect_change(&watch->collected, event);
+            offset += sizeof(struct inotify_event) + event->len;
+            watch->events++;
+        }
+        if (watch->collected.count > 0 || watch->collected.all) watch->pending.store(true, std::memory_order_release);
+    }
+}
+
+bool ShaderWatch::Start(const char *dir)
+{
+    Stop();
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        fprintf(stderr, "Failed to initialize inotify: %s.\n", strerror(errno));
+        return false;
+    }
+    if (inotify_add_watch(inotify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        fprintf(stderr, "Failed to watch %s: %s.\n", dir, strerror(errno));
+        Stop();
+        return false;
+    }
+    wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (wake_fd < 0) {
+        fprintf(stderr, "Failed to create shader watch eventfd: %s.\n", strerror(errno));
+        Stop();
+        return false;
+    }
+    worker = std::thread(watch_worker, this);
+    return true;
+}
+
+void ShaderWatch::Stop()
+{
+    if (worker.joinable()) {
+        uint64_t one = 1;
+        ssize_t written = write(wake_fd, &one, sizeof(one));
+        (void)written;
+        worker.join();
+    }
+    if (inotify_fd >= 0) close(inotify_fd);
+    if (wake_fd >= 0) close(wake_fd);
+    inotify_fd = -1;
+    wake_fd = -1;
+}
+
+void ShaderWatch::TakeChanges(ShaderWatchChanges *changes)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    *changes = collected;
+    collected.count = 0;
+    collected.all = false;
+    pending.store(false, std::memory_order_release);
+}
@@ -0,0 +1,46 @@
+#ifndef SHADER_WATCH_H_
+#define SHADER_WATCH_H_
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Watches one directory with inotify for files that were written or moved in
+// (editors either rewrite in place or rename a temporary over the original).
+// A worker thread blocks on the inotify descriptor and collects the changed
+// names, so the frame loop only reads one atomic flag while nothing changes.
+// Names are deduplicated; too many changes, or an inotify queue overflow,
+// report everything as changed instead.
+
+#define SHADER_WATCH_NAME_LENGTH 64
+#define SHADER_WATCH_MAX_CHANGED 32
+
+struct ShaderWatchChanges {
+    char names[SHADER_WATCH_MAX_CHANGED][SHADER_WATCH_NAME_LENGTH];
+    uint32_t count;
+    bool all;
+};
+
+struct ShaderWatch {
+    ShaderWatch();
+    ~ShaderWatch();
+    ShaderWatch(const ShaderWatch&) = delete;
+    ShaderWatch& operator=(const ShaderWatch&) = delete;
+
+    bool Start(const char *dir);
+    void Stop();
+    bool Pending() const { return pending.load(std::memory_order_acquire); }
+    // NOTE: Moves the changes collected so far into `changes` and clears them
+    void TakeChanges(ShaderWatchChanges *changes);
+
+    int inotify_fd;
+    int wake_fd; // NOTE: eventfd that tells the worker to exit
+    std::thread worker;
+    std::mutex lock;
+    std::atomic<bool> pending;
+    ShaderWatchChanges collected; // NOTE: guarded by lock
+    std::atomic<uint64_t> events;
+};
+
+#endif // SHADER_WATCH_H_
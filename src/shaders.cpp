@@ -1,40 +1,11 @@
 #include "./breakoutt.hpp"
+#include "./program_cache.hpp"
 
-char *read_file(const char *file_path, uint8_t *size)
-{
-    FILE *fp = fopen(file_path, "rb");
-    if (fp == nullptr)
-    {
-        fprintf(stderr, "Failed to open file %s: %s.\n", file_path, strerror(errno));
-        return nullptr;
-    }
-
-    fseek(fp, 0, SEEK_END);
-    uint32_t len = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    char *buffer = (char*)calloc(len+1, sizeof(char));
-    if (buffer == nullptr)
-    {
-        fprintf(stderr, "Failed to Allocate Memory For Buffer.\n");
-        return nullptr;
-    }
-
-    size_t n = fread(buffer, 1, len, fp);
-    assert(n == (size_t) len);
-
-    if (ferror(fp) < 0)
-    {
-        fprintf(stderr, "fread failed!.\n");
-        return nullptr;
-    }
-
-    buffer[len] = '\0';
-    *size = len;
-
-    fclose(fp);
-    return buffer;
-}
+static const char *shader_cache_dir = nullptr;
+static uint32_t shader_cache_hits = 0;
+static uint32_t shader_cache_misses = 0;
+static uint32_t shader_cache_rejects = 0;
+static uint32_t shader_cache_stores = 0;
 
 bool log_shader_error(GLuint Id)
 {
@@ -72,7 +43,7 @@ bool log_program_error(GLuint Id)
     return result == GL_TRUE;
 }
 
-GLuint compile_vertex(char *vertex_code)
+GLuint compile_vertex(const char *vertex_code)
 {
     GLuint VertexShaderId = glCreateShader(GL_VERTEX_SHADER);
     if (vertex_code == nullptr) {
@@ -92,7 +63,7 @@ GLuint compile_vertex(char *vertex_code)
     return VertexShaderId;
 }
 
-GLuint compile_fragment(char *fragment_code)
+GLuint compile_fragment(const char *fragment_code)
 {
     GLuint FragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
     if (fragment_code == nullptr) {
@@ -112,15 +83,110 @@ GLuint compile_fragment(char *fragment_code)
     return FragmentShaderId;
 }
 
+void SetShaderCacheDir(const char *dir)
+{
+    shader_cache_dir = dir;
+}
+
+// NOTE: 0 when the cache is off or the driver can't hand out program binaries
+static uint64_t program_cache_key(const char *stage, const char *first_code, const char *second_code)
+{
+    if (shader_cache_dir == nullptr || first_code == nullptr) return 0;
+    GLint formats = 0, major = 0, minor = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) return 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    char context_version[32];
+    snprintf(context_version, sizeof(context_version), "%d.%d", major, minor);
+
+    const char *parts[8] = {
+        stage, first_code, second_code,
+        (const char*)glGetString(GL_VENDOR),
+        (const char*)glGetString(GL_RENDERER),
+        (const char*)glGetString(GL_VERSION),
+        (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION),
+        context_version,
+    };
+    return ProgramCacheKey(parts, 8);
+}
+
+static GLuint load_cached_program(uint64_t key)
+{
+    if (key == 0) return 0;
+    ProgramBinary binary;
+    if (!LoadProgramBinary(shader_cache_dir, key, &binary)) {
+        shader_cache_misses++;
+        return 0;
+    }
+
+    GLuint ProgramId = glCreateProgram();
+    glProgramBinary(ProgramId, binary.format, binary.data, binary.size);
+    GLint linked = GL_FALSE;
+    glGetProgramiv(ProgramId, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        // NOTE: Drivers may refuse their own binaries after an update the version strings don't show
+        fprintf(stderr, "Cached program binary %016llx was rejected, compiling from source.\n", (unsigned long long)key);
+        glDeleteProgram(ProgramId);
+        RemoveProgramBinary(shader_cache_dir, key);
+        shader_cache_rejects++;
+        return 0;
+    }
+    printf("Loaded cached program binary %016llx (%u bytes).\n", (unsigned long long)key, binary.size);
+    shader_cache_hits++;
+    return ProgramId;
+}
+
+static void store_program(GLuint ProgramId, uint64_t key)
+{
+    if (key == 0) return;
+    GLint length = 0;
+    glGetProgramiv(ProgramId, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    void *binary = malloc(length);
+    if (binary == nullptr) return;
+
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(ProgramId, length, &written, &format, binary);
+    if (written > 0 && SaveProgramBinary(shader_cache_dir, key, format, binary, (uint32_t)written)) {
+        printf("Stored program binary %016llx (%d bytes).\n", (unsigned long long)key, written);
+        shader_cache_stores++;
+    }
+    free(binary);
+}
+
+void ShaderCacheStats()
+{
+    printf("Shader Cache Info: \n");
+    if (shader_cache_dir == nullptr) {
+        printf("    Disabled\n");
+        return;
+    }
+    printf("    Directory: %s\n", shader_cache_dir);
+    printf("    Hits: %u, Misses: %u, Rejected: %u, Stored: %u\n",
+           shader_cache_hits, shader_cache_misses, shader_cache_rejects, shader_cache_stores);
+}
+
 GLuint LoadShader(const char *vertex_file_path, const char *fragment_file_path)
 {
-    uint8_t v_len, f_len = 0;
-    char *vertex_code = read_file(vertex_file_path, &v_len);
-    char *fragment_code = read_file(fragment_file_path, &f_len);
+    // NOTE: Sources are read in place from the mapped files, views end in '\0'
+    const Asset *vertex = assets.Acquire(vertex_file_path);
+    const Asset *fragment = assets.Acquire(fragment_file_path);
+    const char *vertex_code = vertex ? vertex->view.data : nullptr;
+    const char *fragment_code = fragment ? fragment->view.data : nullptr;
 
     // Debug print the shader sources
-    printf("Vertex shader source (%u bytes)\n", v_len);
-    printf("Fragment shader source (%u bytes)\n", f_len);
+    printf("Vertex shader source (%zu bytes)\n", vertex ? vertex->view.size : 0);
+    printf("Fragment shader source (%zu bytes)\n", fragment ? fragment->view.size : 0);
+
+    uint64_t key = fragment_code ? program_cache_key("vertex+fragment", vertex_code, fragment_code) : 0;
+    GLuint CachedId = load_cached_program(key);
+    if (CachedId != 0) {
+        assets.Release(vertex);
+        assets.Release(fragment);
+        return CachedId;
+    }
 
     GLuint FragmentShaderId = compile_fragment(fragment_code);
     GLuint VertexShaderId = compile_vertex(vertex_code);
@@ -129,8 +195,8 @@ GLuint LoadShader(const char *vertex_file_path, const char *fragment_file_path)
     {
         if (VertexShaderId) glDeleteShader(VertexShaderId);
         if (FragmentShaderId) glDeleteShader(FragmentShaderId);
-        free(vertex_code);
-        free(fragment_code);
+        assets.Release(vertex);
+        assets.Release(fragment);
         return 0;
     }
 
@@ -139,14 +205,15 @@ GLuint LoadShader(const char *vertex_file_path, const char *fragment_file_path)
     GLuint ProgramId = glCreateProgram();
     glAttachShader(ProgramId, VertexShaderId);
     glAttachShader(ProgramId, FragmentShaderId);
+    if (key != 0) glProgramParameteri(ProgramId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ProgramId);
 
     // Check the Program
     if (!log_program_error(ProgramId))
     {
         fprintf(stderr, "Program Linking Failed.\n");
-        free(vertex_code);
-        free(fragment_code);
+        assets.Release(vertex);
+        assets.Release(fragment);
         glDeleteProgram(ProgramId);
         ProgramId = 0;
         return 0;
@@ -163,13 +230,66 @@ GLuint LoadShader(const char *vertex_file_path, const char *fragment_file_path)
     glDeleteShader(FragmentShaderId);
     printf("SuccessFully Detached and Deleted the Shaders.\n");
 
-    // Free the shader buffers
-    free(vertex_code);
-    free(fragment_code);
-    printf("SuccessFully Freed the Shader Buffers\n");
+    // Release the shader sources
+    assets.Release(vertex);
+    assets.Release(fragment);
+    printf("SuccessFully Released the Shader Sources\n");
+    store_program(ProgramId, key);
     return ProgramId; // return program id
 }
 
+GLuint compile_compute(const char *compute_code)
+{
+    GLuint ComputeShaderId = glCreateShader(GL_COMPUTE_SHADER);
+    if (compute_code == nullptr) {
+        fprintf(stderr, "Compute Shader Source is nullptr.\n");
+        return 0;
+    }
+    printf("Compiling Compute Shader Program...\n");
+    glShaderSource(ComputeShaderId, 1, (const GLchar* const*)&compute_code, nullptr);
+    glCompileShader(ComputeShaderId);
+
+    // Check compute Shader
+    if (!log_shader_error(ComputeShaderId)) {
+        glDeleteShader(ComputeShaderId);
+        return 0;
+    }
+    printf("SuccessFully Compiled Compute Shader.\n");
+    return ComputeShaderId;
+}
+
+GLuint LoadComputeShader(const char *compute_file_path)
+{
+    const Asset *compute = assets.Acquire(compute_file_path);
+    const char *compute_code = compute ? compute->view.data : nullptr;
+    uint64_t key = program_cache_key("compute", compute_code, nullptr);
+    GLuint CachedId = load_cached_program(key);
+    if (CachedId != 0) {
+        assets.Release(compute);
+        return CachedId;
+    }
+    GLuint ComputeShaderId = compile_compute(compute_code);
+    assets.Release(compute);
+    if (ComputeShaderId == 0) return 0;
+
+    printf("Linking Compute Program...\n");
+    GLuint ProgramId = glCreateProgram();
+    glAttachShader(ProgramId, ComputeShaderId);
+    if (key != 0) glProgramParameteri(ProgramId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(ProgramId);
+    glDetachShader(ProgramId, ComputeShaderId);
+    glDeleteShader(ComputeShaderId);
+
+    if (!log_program_error(ProgramId)) {
+        fprintf(stderr, "Compute Program Linking Failed.\n");
+        glDeleteProgram(ProgramId);
+        return 0;
+    }
+    printf("SuccessFully Linked Compute Program.\n");
+    store_program(ProgramId, key);
+    return ProgramId;
+}
+
 void calculate_fps(double *last_time, double *frame_count)
 {
     double current_time = (double) SDL_GetTicks() * 0.001f;
@@ -0,0 +1,207 @@
+#include "./blockfile.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <sys/mman.h>
+
+// Snapshots are block files with every Balls column followed by every Bricks
+// column. Loading maps the file copy-on-write and points the SoA columns
+// straight at the blocks, so nothing is parsed or copied until the simulation
+// writes to it.
+
+#define SNAPSHOT_BLOCK_COUNT (Balls::column_count + Bricks::column_count)
+
+struct SnapshotHeader {
+    BlockFileHeader file;
+    uint64_t tick;
+    uint32_t ball_count;
+    uint32_t brick_count;
+    uint32_t paddle_count;
+    uint32_t score;
+    Paddle paddles[MAX_PADDLES];
+};
+
+static void snapshot_columns(Game *game, SoAColumn *columns, uint32_t *counts)
+{
+    game->balls.Columns(columns);
+    game->bricks.Columns(columns + Balls::column_count);
+    for (uint32_t i = 0; i < SNAPSHOT_BLOCK_COUNT; ++i) {
+        counts[i] = i < Balls::column_count ? game->balls.count : game->bricks.count;
+    }
+}
+
+bool SaveSnapshot(const Game *game, const char *file_path)
+{
+    SoAColumn columns[SNAPSHOT_BLOCK_COUNT];
+    uint32_t counts[SNAPSHOT_BLOCK_COUNT];
+    snapshot_columns(const_cast<Game*>(game), columns, counts);
+
+    SnapshotHeader header = {};
+    header.tick = game->tick;
+    header.ball_count = game->balls.count;
+    header.brick_count = game->bricks.count;
+    header.paddle_count = game->paddle_count;
+    header.score = game->score;
+    memcpy(header.paddles, game->paddles, sizeof(header.paddles));
+
+    return blockfile_write(file_path, &header, sizeof(header), SNAPSHOT_MAGIC, SNAPSHOT_VERSION,
+                           columns, counts, SNAPSHOT_BLOCK_COUNT);
+}
+
+bool LoadSnapshot(Game *game, const char *file_path)
+{
+    SoAColumn columns[SNAPSHOT_BLOCK_COUNT];
+    uint32_t counts[SNAPSHOT_BLOCK_COUNT];
+    snapshot_columns(game, columns, counts);
+
+    size_t size = 0;
+    void *mapping = blockfile_map(file_path, &size, SNAPSHOT_MAGIC, SNAPSHOT_VERSION,
+                                  sizeof(SnapshotHeader), columns, SNAPSHOT_BLOCK_COUNT);
+    if (mapping == nullptr) return false;
+
+    const SnapshotHeader *header = (const SnapshotHeader*)mapping;
+    const BlockFileBlock *blocks = blockfile_blocks(mapping);
+    bool valid = header->paddle_count <= MAX_PADDLES;
+    for (uint32_t i = 0; i < SNAPSHOT_BLOCK_COUNT; ++i) {
+        uint32_t expected = i < Balls::column_count ? header->ball_count : header->brick_count;
+        if (blocks[i].count != expected) valid = false;
+    }
+    if (!valid) {
+        fprintf(stderr, "%s: corrupt snapshot header.\n", file_path);
+        munmap(mapping, size);
+        return false;
+    }
+
+    // NOTE: Renderers index sprite and palette tables with these, same check as LoadLevel
+    const uint8_t *type = (const uint8_t*)mapping + blocks[Balls::column_count + 5].offset;
+    const uint8_t *color = (const uint8_t*)mapping + blocks[Balls::column_count + 6].offset;
+    if (soa_column_max(type, header->brick_count) >= LEVEL_MAX_TYPES ||
+        soa_column_max(color, header->brick_count) >= LEVEL_MAX_COLORS) {
+        fprintf(stderr, "%s: brick type or color index out of range.\n", file_path);
+        munmap(mapping, size);
+        return false;
+    }
+
+    game->Reset();
+    game->balls.count = game->balls.capacity = header->ball_count;
+    game->bricks.count = game->bricks.capacity = header->brick_count;
+    game->balls.borrowed = game->bricks.borrowed = true;
+    game->paddle_count = header->paddle_count;
+    game->tick = header->tick;
+    game->score = header->score;
+    memcpy(game->paddles, header->paddles, sizeof(game->paddles));
+
+    snapshot_columns(game, columns, counts);
+    for (uint32_t i = 0; i < SNAPSHOT_BLOCK_COUNT; ++i) {
+        *columns[i].data = (char*)mapping + blocks[i].offset;
+    }
+    game->mapping = mapping;
+    game->mapping_size = size;
+    return true;
+}
+
+// NOTE: Header followed by the snapshot columns packed back to back, no alignment needed for memcpy
+struct StateHeader {
+    uint64_t tick;
+    uint32_t ball_count;
+    uint32_t brick_count;
+    uint32_t paddle_count;
+    uint32_t score;
+    Paddle paddles[MAX_PADDLES];
+};
+
+void SaveState(const Game *game, StateBuffer *state)
+{
+    SoAColumn columns[SNAPSHOT_BLOCK_COUNT];
+    uint32_t counts[SNAPSHOT_BLOCK_COUNT];
+    snapshot_columns(const_cast<Game*>(game), columns, counts);
+
+    size_t size = sizeof(StateHeader);
+    for (uint32_t i = 0; i < SNAPSHOT_BLOCK_COUNT; ++i) size += (size_t)counts[i] * columns[i].elem_size;
+    if (size > state->capacity) {
+        free(state->data);
+        state->data = (uint8_t*)malloc(size);
+        assert(state->data != NULL && "Allocation of state buffer failed");
+        state->capacity = size;
+    }
+
+    StateHeader header = {};
+    header.tick = game->tick;
+    header.ball_count = game->balls.count;
+    header.brick_count = game->bricks.count;
+    header.paddle_count = game->paddle_count;
+    header.score = game->score;
+    memcpy(header.paddles, game->paddles, sizeof(header.paddles));
+    memcpy(state->data, &header, sizeof(header));
+
+    size_t offset = sizeof(StateHeader);
+    for (uint32_t i = 0; i < SNAPSHOT_BLOCK_COUNT; ++i) {
+        size_t bytes = (size_t)counts[i] * columns[i].elem_size;
+        memcpy(state->data + offset, *columns[i].data, bytes);
+        offset += bytes;
+    }
+    state->size = size;
+}
+
+// NOTE: Reuses the columns of `game` when they are owned and large enough, so a restore does not allocate
+bool LoadState(Game *game, const StateBuffer *state)
+{
+    if (state->size < sizeof(StateHeader)) return false;
+    StateHeader header;
+    memcpy(&header, state->data, sizeof(header));
+    if (header.paddle_count > MAX_PADDLES) return false;
+
+    SoAColumn columns[SNAPSHOT_BLOCK_COUNT];
+    uint32_t counts[SNAPSHOT_BLOCK_COUNT];
+    snapshot_columns(game, columns, counts);
+    size_t size = sizeof(StateHeader);
+    for (uint32_t i = 0; i < SNAPSHOT_BLOCK_COUNT; ++i) {
+        uint32_t count = i < Balls::column_count ? header.ball_count : header.brick_count;
+        size += (size_t)count * columns[i].elem_size;
+    }
+    if (size != state->size) return false;
+
+    game->balls.count = 0;
+    game->bricks.count = 0;
+    game->balls.Columns(columns);
+    soa_reserve(columns, Balls::column_count, &game->balls.capacity, &game->balls.borrowed, 0, header.ball_count);
+    game->bricks.Columns(columns);
+    soa_reserve(columns, Bricks::column_count, &game->bricks.capacity, &game->bricks.borrowed, 0, header.brick_count);
+
+    game->balls.count = header.ball_count;
+    game->bricks.count = header.brick_count;
+    snapshot_columns(game, columns, counts);
+    size_t offset = sizeof(StateHeader);
+    for (uint32_t i = 0; i < SNAPSHOT_BLOCK_COUNT; ++i) {
+        size_t bytes = (size_t)counts[i] * columns[i].elem_size;
+        memcpy(*columns[i].data, state->data + offset, bytes);
+        offset += bytes;
+    }
+
+    game->tick = header.tick;
+    game->score = header.score;
+    game->paddle_count = header.paddle_count;
+    memcpy(game->paddles, header.paddles, sizeof(game->paddles));
+    game->brick_pack_dirty = true;
+    array_clear(&game->broken);
+    return true;
+}
+
+// NOTE: FNV-1a, only used to compare states between peers
+uint32_t StateChecksum(const StateBuffer *state)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < state->size; ++i) {
+        hash ^= state->data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void state_buffer_free(StateBuffer *state)
+{
+    free(state->data);
+    *state = {};
+}
@@ -0,0 +1,271 @@
+#include "./soak.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+Autoplayer::Autoplayer(uint32_t seed):
+    rng(seed), aim(), approaching()
+{}
+
+bool PredictBallX(const Game *game, uint32_t i, float y, float *x, float *t)
+{
+    const Balls *balls = &game->balls;
+    float vy = balls->vy[i];
+    float dy = y - balls->y[i];
+    if (vy == 0.0f || dy / vy < 0.0f) return false;
+    *t = dy / vy;
+
+    // NOTE: Unfold the bounces between the walls into a straight line, then fold the end point back
+    float r = balls->radius[i];
+    float low = -1.0f + r;
+    float width = 2.0f - 2.0f * r;
+    if (width <= 0.0f) {
+        *x = 0.0f;
+        return true;
+    }
+    float unfolded = balls->x[i] + balls->vx[i] * *t - low;
+    float period = 2.0f * width;
+    float m = fmodf(unfolded, period);
+    if (m < 0.0f) m += period;
+    *x = low + (m < width ? m : period - m);
+    return true;
+}
+
+uint8_t Autoplayer::Input(const Game *game, uint32_t p)
+{
+    const Paddle *paddle = &game->paddles[p];
+    float side = paddle->y < 0.0f ? 1.0f : -1.0f; // NOTE: which side of the paddle the balls come from
+
+    float target = paddle->x;
+    float best_t = INFINITY;
+    for (uint32_t i = 0; i < game->balls.count; ++i) {
+        // NOTE: A ball that got past the paddle would get trapped behind it, step aside instead
+        float behind = side * (game->balls.y[i] - paddle->y);
+        if (behind < 0.0f) {
+            float clearance = paddle->w * 0.5f + game->balls.radius[i] + 0.05f;
+            float offset = paddle->x - game->balls.x[i];
+            if (fabsf(offset) < clearance) {
+                float away = offset >= 0.0f ? 1.0f : -1.0f;
+                if (fabsf(game->balls.x[i] + away * clearance) > 1.0f) away = -away;
+                target = game->balls.x[i] + away * clearance;
+                best_t = 0.0f;
+            }
+            continue;
+        }
+        float contact_y = paddle->y + side * (paddle->h * 0.5f + game->balls.radius[i]);
+        if (side * (game->balls.y[i] - contact_y) < 0.0f && side * game->balls.vy[i] < 0.0f) {
+            // NOTE: Already touching, chasing it now would push the ball sideways off the corner
+            target = paddle->x;
+            best_t = 0.0f;
+            continue;
+        }
+        float x, t;
+        if (PredictBallX(game, i, contact_y, &x, &t) && t < best_t) {
+            best_t = t;
+            target = x;
+        }
+    }
+
+    bool now_approaching = best_t != INFINITY;
+    if (!now_approaching && game->balls.count > 0) {
+        // NOTE: Nothing incoming, wait under the first ball
+        target = game->balls.x[0];
+    }
+    if (approaching[p] && !now_approaching) {
+        // NOTE: The ball just turned around, pick a new part of the paddle for the next hit.
+        // Past 0.9 half widths the step size can land it on the corner and knock it down
+        aim[p] = rng.Range(-0.9f, 0.9f);
+    }
+    approaching[p] = now_approaching;
+    if (now_approaching && best_t > 0.0f) target -= aim[p] * paddle->w * 0.5f;
+
+    float dead_zone = paddle->speed * DELTA_TIME * 0.5f; // NOTE: half a step, so it settles within one
+    float dx = target - paddle->x;
+    if (dx > dead_zone) return INPUT_RIGHT;
+    if (dx < -dead_zone) return INPUT_LEFT;
+    return INPUT_NONE;
+}
+
+bool read_memory_usage(size_t *rss_bytes, size_t *virtual_bytes)
+{
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (file == NULL) return false;
+    unsigned long size = 0, resident = 0;
+    int n = fscanf(file, "%lu %lu", &size, &resident);
+    fclose(file);
+    if (n != 2) return false;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    if (rss_bytes) *rss_bytes = resident * page;
+    if (virtual_bytes) *virtual_bytes = size * page;
+    return true;
+}
+
+SoakMonitor::SoakMonitor(double interval, FILE *log):
+    interval(interval > 0.0 ? interval : 10.0), last_report(0.0), log(log),
+    histogram(), frames(0), total(0.0), max(0.0),
+    clears(0), misses(0), rss_start(0), rss_peak(0)
+{
+    read_memory_usage(&rss_start, nullptr);
+    rss_peak = rss_start;
+}
+
+void SoakMonitor::Frame(double seconds)
+{
+    double ms = seconds * 1000.0;
+    uint32_t bucket = (uint32_t)(ms / SOAK_HISTOGRAM_STEP_MS);
+    if (bucket >= SOAK_HISTOGRAM_BUCKETS) bucket = SOAK_HISTOGRAM_BUCKETS - 1;
+    histogram[bucket]++;
+    frames++;
+    total += ms;
+    if (ms > max) max = ms;
+}
+
+bool SoakMonitor::Due(double elapsed) const
+{
+    return elapsed - last_report >= interval;
+}
+
+static double histogram_percentile(const SoakMonitor *monitor, double fraction)
+{
+    uint64_t wanted = (uint64_t)ceil((double)monitor->frames * fraction);
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < SOAK_HISTOGRAM_BUCKETS; ++i) {
+        seen += monitor->histogram[i];
+        if (seen >= wanted && seen > 0) return (i + 1) * SOAK_HISTOGRAM_STEP_MS;
+    }
+    return 0.0;
+}
+
+void SoakMonitor::Report(const Game *game, double elapsed)
+{
+    size_t rss = 0, virt = 0;
+    read_memory_usage(&rss, &virt);
+    if (rss > rss_peak) rss_peak = rss;
+
+    if (log) {
+        fprintf(log, "SOAK t=%.1fs tick=%lu clears=%u misses=%u score=%u | frames=%lu avg=%.3fms p50=%.2fms p99=%.2fms max=%.3fms"
+                     " | rss=%zuKiB (%+ldKiB) peak=%zuKiB virt=%zuKiB\n",
+                elapsed, (unsigned long)game->tick, clears, misses, game->score,
+                (unsigned long)frames, frames ? total / (double)frames : 0.0,
+                histogram_percentile(this, 0.5), histogram_percentile(this, 0.99), max,
+                rss / 1024, (long)(rss / 1024) - (long)(rss_start / 1024), rss_peak / 1024, virt / 1024);
+        fflush(log);
+    }
+
+    memset(histogram, 0, sizeof(histogram));
+    frames = 0;
+    total = 0.0;
+    max = 0.0;
+    last_report = elapsed;
+}
+
+// NOTE: Launches every ball at a seeded angle with its original speed, at least 30 degrees off horizontal
+void SoakSeedGame(Game *game, uint32_t seed)
+{
+    // NOTE: Its own stream, the autoplayer seeded with the same value must not mirror it
+    Rng rng(seed);
+    rng.LongJump();
+    for (uint32_t i = 0; i < game->balls.count; ++i) {
+        float speed = sqrtf(game->balls.vx[i] * game->balls.vx[i] + game->balls.vy[i] * game->balls.vy[i]);
+        float angle = rng.Range(1.0f / 6.0f, 5.0f / 6.0f) * (float)M_PI;
+        if (rng.Next() & 1u) angle = -angle;
+        game->balls.vx[i] = cosf(angle) * speed;
+        game->balls.vy[i] = sinf(angle) * speed;
+    }
+}
+
+bool SoakLevelCleared(const Game *game)
+{
+    if (game->bricks.count == 0) return false;
+    for (uint32_t i = 0; i < game->bricks.count; ++i) {
+        if (game->bricks.hp[i] > 0) return false;
+    }
+    return true;
+}
+
+// NOTE: 10x5 wall in the upper half, used when no level file is given
+static void build_wall(Game *game)
+{
+    game->bricks.count = 0;
+    for (uint32_t row = 0; row < 5; ++row) {
+        for (uint32_t col = 0; col < 10; ++col) {
+            game->AddBrick(-0.9f + col * 0.2f, 0.35f + row * 0.1f, 0.18f, 0.08f, 1, 0, (uint8_t)row);
+        }
+    }
+}
+
+bool SoakRefill(Game *game, const SoakConfig *config)
+{
+    if (config->generator) {
+        config->generator->seed++;
+        return GenerateLevel(game, config->generator, 0, nullptr);
+    }
+    if (config->level_path) return LoadLevel(game, config->level_path, nullptr);
+    build_wall(game);
+    return true;
+}
+
+bool SoakDone(const SoakConfig *config, const SoakMonitor *monitor, double elapsed)
+{
+    if (config->duration > 0.0 && elapsed >= config->duration) return true;
+    if (config->clears > 0 && monitor->clears >= config->clears) return true;
+    return false;
+}
+
+// NOTE: Balls past the bottom edge, and past the top one when a second paddle defends it
+uint32_t SoakCountMisses(const Game *game)
+{
+    uint32_t misses = 0;
+    for (uint32_t i = 0; i < game->balls.count; ++i) {
+        float r = game->balls.radius[i];
+        if (game->balls.y[i] - r < -1.0f) misses++;
+        if (game->paddle_count > 1 && game->balls.y[i] + r > 1.0f) misses++;
+    }
+    return misses;
+}
+
+static double seconds_now(void)
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int RunHeadlessSoak(Game *game, const SoakConfig *config, FILE *log)
+{
+    if (config->duration <= 0.0 && config->clears == 0) {
+        fprintf(stderr, "Headless soak needs a duration or a number of clears.\n");
+        return -1;
+    }
+    if (game->paddle_count == 0) {
+        fprintf(stderr, "Headless soak needs at least one paddle.\n");
+        return -1;
+    }
+    if (game->bricks.count == 0 && !SoakRefill(game, config)) return -1;
+
+    Autoplayer autoplayer(config->seed);
+    SoakMonitor monitor(config->stats_interval, log);
+    uint64_t start_tick = game->tick;
+    double elapsed = 0.0;
+    while (!SoakDone(config, &monitor, elapsed)) {
+        uint8_t inputs[MAX_PADDLES] = {};
+        for (uint32_t p = 0; p < game->paddle_count; ++p) inputs[p] = autoplayer.Input(game, p);
+
+        double begin = seconds_now();
+        game->GameUpdate(inputs);
+        monitor.Frame(seconds_now() - begin);
+
+        monitor.misses += SoakCountMisses(game);
+        if (SoakLevelCleared(game)) {
+            monitor.clears++;
+            if (!SoakRefill(game, config)) return -1;
+        }
+
+        elapsed = (double)(game->tick - start_tick) * DELTA_TIME;
+        if (monitor.Due(elapsed)) monitor.Report(game, elapsed);
+    }
+    monitor.Report(game, elapsed);
+    return (int)monitor.clears;
+}
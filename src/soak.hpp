@@ -0,0 +1,78 @@
+#ifndef SOAK_H_
+#define SOAK_H_
+
+#include "./game.hpp"
+#include "./random.hpp"
+#include "./levelgen.hpp"
+
+#include <cstdio>
+
+// Autoplayer and soak test harness.
+//
+// The autoplayer produces paddle inputs from the predicted crossing point of
+// the next ball heading for the paddle, with wall bounces folded in; bricks
+// are ignored and handled by re-predicting every tick. A seeded aim offset
+// makes it hit the ball with different parts of the paddle.
+//
+// A soak run plays until a duration or a number of level clears is reached,
+// refilling the bricks on every clear, and logs frame times and memory use at
+// a fixed interval. The same seed gives the same run.
+
+#define SOAK_HISTOGRAM_BUCKETS 1000
+#define SOAK_HISTOGRAM_STEP_MS 0.05 // NOTE: 0.05 ms buckets, the last one collects everything above 50 ms
+
+struct Autoplayer {
+    Autoplayer(uint32_t seed);
+
+    uint8_t Input(const Game *game, uint32_t paddle);
+
+    Rng rng;
+    float aim[MAX_PADDLES];          // NOTE: offset from the paddle center, in half widths
+    bool approaching[MAX_PADDLES];   // NOTE: a ball was heading for the paddle on the last Input
+};
+
+// NOTE: x where ball i reaches height y, folding wall bounces, false if it is moving away
+bool PredictBallX(const Game *game, uint32_t i, float y, float *x, float *t);
+
+struct SoakConfig {
+    double duration;       // NOTE: seconds, 0 for no limit (simulated time when headless)
+    uint32_t clears;       // NOTE: level clears, 0 for no limit
+    uint32_t seed;
+    double stats_interval; // NOTE: seconds between log lines
+    const char *level_path; // NOTE: refilled from here on a clear, a default wall otherwise
+    LevelGenConfig *generator; // NOTE: endless mode, every clear generates the next seed instead
+};
+
+struct SoakMonitor {
+    SoakMonitor(double interval, FILE *log);
+
+    void Frame(double seconds);
+    bool Due(double elapsed) const;
+    void Report(const Game *game, double elapsed);
+
+    double interval;
+    double last_report;
+    FILE *log;
+
+    // NOTE: Frame times since the last report
+    uint32_t histogram[SOAK_HISTOGRAM_BUCKETS];
+    uint64_t frames;
+    double total;
+    double max;
+
+    uint32_t clears;
+    uint32_t misses;
+    size_t rss_start;
+    size_t rss_peak;
+};
+
+bool read_memory_usage(size_t *rss_bytes, size_t *virtual_bytes);
+void SoakSeedGame(Game *game, uint32_t seed);
+bool SoakLevelCleared(const Game *game);
+bool SoakRefill(Game *game, const SoakConfig *config);
+uint32_t SoakCountMisses(const Game *game);
+bool SoakDone(const SoakConfig *config, const SoakMonitor *monitor, double elapsed);
+// NOTE: Ticks as fast as possible, returns the number of clears or -1 on failure
+int RunHeadlessSoak(Game *game, const SoakConfig *config, FILE *log);
+
+#endif // SOAK_H_
@@ -0,0 +1,125 @@
+#include "./breakoutt.hpp"
+
+StreamBuffer::StreamBuffer():
+    Buffer(0), mapped(nullptr), region_size(0), region(0), head(0),
+    persistent(false), frames(0), stalls(0), grows(0)
+{
+    for (uint32_t i = 0; i < STREAM_REGIONS; ++i) fences[i] = nullptr;
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    Destroy();
+}
+
+bool StreamBuffer::Init(uint32_t size)
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    persistent = major > 4 || (major == 4 && minor >= 4);
+    return Create(size);
+}
+
+bool StreamBuffer::Create(uint32_t size)
+{
+    region_size = (size + STREAM_ALIGNMENT - 1) & ~(uint32_t)(STREAM_ALIGNMENT - 1);
+    GLsizeiptr total = (GLsizeiptr)region_size * STREAM_REGIONS;
+    region = 0;
+    head = 0;
+
+    glGenBuffers(1, &Buffer);
+    gl_state.BindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+    if (persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, total, nullptr, flags);
+        mapped = (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags);
+    } else {
+        glBufferData(GL_COPY_WRITE_BUFFER, total, nullptr, GL_STREAM_DRAW);
+        mapped = (uint8_t*)malloc(region_size);
+    }
+    gl_state.BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (mapped == nullptr) {
+        fprintf(stderr, "Failed to Map Stream Buffer of %ld bytes.\n", (long)total);
+        return false;
+    }
+    return true;
+}
+
+void StreamBuffer::Destroy()
+{
+    for (uint32_t i = 0; i < STREAM_REGIONS; ++i) Wait(i);
+    if (Buffer && persistent && mapped) {
+        gl_state.BindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        gl_state.BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    } else {
+        free(mapped);
+    }
+    mapped = nullptr;
+    gl_state.DeleteBuffer(&Buffer);
+    Buffer = 0;
+}
+
+// NOTE: Blocks until the GPU is done with the draws that read the region
+void StreamBuffer::Wait(uint32_t index)
+{
+    if (fences[index] == nullptr) return;
+    GLenum status = glClientWaitSync(fences[index], 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        stalls++;
+        do {
+            status = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fences[index]);
+    fences[index] = nullptr;
+}
+
+void StreamBuffer::BeginFrame()
+{
+    region = (region + 1) % STREAM_REGIONS;
+    head = 0;
+    Wait(region);
+    frames++;
+}
+
+void *StreamBuffer::Allocate(uint32_t size, GLintptr *offset)
+{
+    uint32_t start = (head + STREAM_ALIGNMENT - 1) & ~(uint32_t)(STREAM_ALIGNMENT - 1);
+    if ((uint64_t)start + size > region_size) {
+        // NOTE: Immutable storage can't be resized, start over with a ring twice as large
+        uint32_t grown = region_size > 0 ? region_size : STREAM_ALIGNMENT;
+        while (grown < size) grown *= 2;
+        grown *= 2;
+        Destroy();
+        if (!Create(grown)) return nullptr;
+        grows++;
+        start = 0;
+    }
+    head = start + size;
+    *offset = (GLintptr)region * region_size + start;
+    return persistent ? mapped + *offset : mapped + start;
+}
+
+// NOTE: Coherent mappings are visible to the GPU as they are written, only the shadow needs an upload
+void StreamBuffer::Commit(GLintptr offset, uint32_t size)
+{
+    if (persistent || size == 0) return;
+    gl_state.BindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, mapped + (offset - (GLintptr)region * region_size));
+}
+
+// NOTE: Call after the last draw that reads this frame's region
+void StreamBuffer::EndFrame()
+{
+    if (fences[region]) glDeleteSync(fences[region]);
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::stats() const
+{
+    printf("    Stream: %u x %u bytes, %s, %lu frames, %lu stalls, %lu grows\n",
+           STREAM_REGIONS, region_size, persistent ? "persistent mapped" : "shadow copy",
+           (unsigned long)frames, (unsigned long)stalls, (unsigned long)grows);
+}
@@ -0,0 +1,205 @@
+#include "./vecenv.hpp"
+
+#include <cstdio>
+#include <cmath>
+
+#define VECENV_COLUMN_COUNT 10
+
+static void vecenv_columns(VecEnv *env, SoAColumn *out)
+{
+    out[0] = {(void**)&env->ball_x, sizeof(float)};
+    out[1] = {(void**)&env->ball_y, sizeof(float)};
+    out[2] = {(void**)&env->ball_vx, sizeof(float)};
+    out[3] = {(void**)&env->ball_vy, sizeof(float)};
+    out[4] = {(void**)&env->paddle_x, sizeof(float)};
+    out[5] = {(void**)&env->bricks_left, sizeof(float)};
+    out[6] = {(void**)&env->reward, sizeof(float)};
+    out[7] = {(void**)&env->done, sizeof(uint8_t)};
+    out[8] = {(void**)&env->rngs, sizeof(Rng)};
+    out[9] = {(void**)&env->brick_total, sizeof(uint32_t)};
+}
+
+// NOTE: 10x6 wall of 1 hp bricks, one paddle and one ball launched upwards at a random angle
+void DefaultEnvSetup(Game *game, Rng *rng)
+{
+    game->AddPaddle(0.0f, -0.9f, 0.4f, 0.05f, 2.0f);
+    for (uint32_t row = 0; row < 6; ++row) {
+        for (uint32_t col = 0; col < 10; ++col) {
+            game->AddBrick(-0.9f + col * 0.2f, 0.3f + row * 0.1f, 0.18f, 0.08f, 1, 0, (uint8_t)row);
+        }
+    }
+    float angle = rng->Range(0.25f, 0.75f) * (float)M_PI;
+    float speed = 1.2f;
+    game->AddBall(0.0f, -0.5f, 0.03f, cosf(angle) * speed, sinf(angle) * speed);
+}
+
+static void env_reset(VecEnv *env, uint32_t i)
+{
+    Game *game = &env->games[i];
+    game->Clear();
+    env->setup(game, &env->rngs[i]);
+    uint32_t total = 0;
+    for (uint32_t b = 0; b < game->bricks.count; ++b) total += game->bricks.hp[b] > 0;
+    env->brick_total[i] = total;
+}
+
+static void env_observe(VecEnv *env, uint32_t i)
+{
+    const Game *game = &env->games[i];
+    bool has_ball = game->balls.count > 0;
+    env->ball_x[i] = has_ball ? game->balls.x[0] : 0.0f;
+    env->ball_y[i] = has_ball ? game->balls.y[0] : 0.0f;
+    env->ball_vx[i] = has_ball ? game->balls.vx[0] : 0.0f;
+    env->ball_vy[i] = has_ball ? game->balls.vy[0] : 0.0f;
+    env->paddle_x[i] = game->paddle_count > 0 ? game->paddles[0].x : 0.0f;
+    uint32_t total = env->brick_total[i];
+    uint32_t left = total > game->score ? total - game->score : 0;
+    env->bricks_left[i] = total ? (float)left / (float)total : 0.0f;
+}
+
+// NOTE: Steps envs [begin, end), counts finished episodes and simulated ticks
+static void env_step_range(VecEnv *env, const uint8_t *actions, uint32_t begin, uint32_t end,
+                           uint64_t *episodes, uint64_t *ticks)
+{
+    for (uint32_t i = begin; i < end; ++i) {
+        Game *game = &env->games[i];
+        uint8_t inputs[MAX_PADDLES] = {actions[i]};
+        float reward = 0.0f;
+        bool done = false;
+        for (uint32_t k = 0; k < env->frame_skip && !done; ++k) {
+            uint32_t score = game->score;
+            game->GameUpdate(inputs);
+            (*ticks)++;
+            reward += (float)(game->score - score);
+            if (game->balls.count > 0 && game->balls.y[0] - game->balls.radius[0] < -1.0f) {
+                reward += ENV_MISS_REWARD;
+                done = true;
+            }
+            if (game->score >= env->brick_total[i] || game->tick >= ENV_MAX_TICKS) done = true;
+        }
+        env->reward[i] = reward;
+        env->done[i] = done;
+        if (done) {
+            env_reset(env, i);
+            (*episodes)++;
+        }
+        env_observe(env, i);
+    }
+}
+
+static void env_range(const VecEnv *env, uint32_t worker, uint32_t *begin, uint32_t *end)
+{
+    *begin = (uint32_t)((uint64_t)env->count * worker / env->thread_count);
+    *end = (uint32_t)((uint64_t)env->count * (worker + 1) / env->thread_count);
+}
+
+static void env_worker(VecEnv *env, uint32_t worker)
+{
+    uint64_t seen = 0;
+    for (;;) {
+        const uint8_t *actions;
+        {
+            std::unique_lock<std::mutex> lock(env->mutex);
+            env->start.wait(lock, [&] { return env->quit || env->generation != seen; });
+            if (env->quit) return;
+            seen = env->generation;
+            actions = env->pending_actions;
+        }
+
+        uint32_t begin, end;
+        env_range(env, worker, &begin, &end);
+        uint64_t episodes = 0, ticks = 0;
+        env_step_range(env, actions, begin, end, &episodes, &ticks);
+
+        std::lock_guard<std::mutex> lock(env->mutex);
+        env->episodes += episodes;
+        env->ticks += ticks;
+        if (--env->running == 0) env->finished.notify_one();
+    }
+}
+
+VecEnv::VecEnv(uint32_t count, uint32_t thread_count, uint32_t frame_skip, uint32_t seed, EnvSetup setup):
+    games(nullptr), count(count), frame_skip(frame_skip ? frame_skip : 1),
+    setup(setup ? setup : DefaultEnvSetup), rngs(nullptr),
+    ball_x(nullptr), ball_y(nullptr), ball_vx(nullptr), ball_vy(nullptr), paddle_x(nullptr),
+    bricks_left(nullptr), reward(nullptr), done(nullptr), brick_total(nullptr), capacity(0),
+    ticks(0), episodes(0), threads(nullptr),
+    thread_count(thread_count == 0 ? 1 : (thread_count > count && count > 0 ? count : thread_count)),
+    generation(0), running(0), pending_actions(nullptr), quit(false)
+{
+    games = new Game[count];
+
+    SoAColumn columns[VECENV_COLUMN_COUNT];
+    vecenv_columns(this, columns);
+    bool borrowed = false;
+    soa_reserve(columns, VECENV_COLUMN_COUNT, &capacity, &borrowed, 0, count);
+
+    // NOTE: Env i gets the i-th split of the seed, independent of the thread count
+    Rng master(seed);
+    for (uint32_t i = 0; i < count; ++i) {
+        rngs[i] = master.Split();
+    }
+
+    threads = new std::thread[this->thread_count];
+    for (uint32_t i = 1; i < this->thread_count; ++i) {
+        threads[i] = std::thread(env_worker, this, i);
+    }
+    Reset();
+}
+
+VecEnv::~VecEnv()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    start.notify_all();
+    for (uint32_t i = 1; i < thread_count; ++i) threads[i].join();
+    delete[] threads;
+    delete[] games;
+
+    SoAColumn columns[VECENV_COLUMN_COUNT];
+    vecenv_columns(this, columns);
+    soa_free(columns, VECENV_COLUMN_COUNT, false);
+}
+
+void VecEnv::Reset()
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        env_reset(this, i);
+        env_observe(this, i);
+        reward[i] = 0.0f;
+        done[i] = 0;
+    }
+}
+
+void VecEnv::Step(const uint8_t *actions)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending_actions = actions;
+        running = thread_count - 1;
+        generation++;
+    }
+    if (thread_count > 1) start.notify_all();
+
+    uint32_t begin, end;
+    env_range(this, 0, &begin, &end);
+    uint64_t stepped_episodes = 0, stepped_ticks = 0;
+    env_step_range(this, actions, begin, end, &stepped_episodes, &stepped_ticks);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return running == 0; });
+    episodes += stepped_episodes;
+    ticks += stepped_ticks;
+}
+
+void VecEnv::stats() const
+{
+    printf("VecEnv Info: \n");
+    printf("    Envs: %u\n", count);
+    printf("    Threads: %u\n", thread_count);
+    printf("    Frame skip: %u\n", frame_skip);
+    printf("    Ticks: %lu\n", (unsigned long)ticks);
+    printf("    Episodes: %lu\n", (unsigned long)episodes);
+}
@@ -0,0 +1,74 @@
+#ifndef VECENV_H_
+#define VECENV_H_
+
+#include "./game.hpp"
+#include "./random.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Batched headless environment for controller training and balance runs.
+//
+// N independent games are stepped in lockstep: one action per game goes in,
+// one observation, reward and done flag per game come out, each as a SoA
+// column indexed by environment. The games are split into contiguous ranges,
+// one per worker thread, and a game is always stepped by the same thread, so
+// results do not depend on the thread count.
+//
+// Rewards: +1 per destroyed brick, -1 when ball 0 reaches the bottom wall.
+// An episode ends on a miss, a cleared board or ENV_MAX_TICKS, and the game
+// is reset from its environment's own random stream inside the same Step.
+
+#define ENV_MAX_TICKS (FPS * 60 * 5)
+#define ENV_MISS_REWARD -1.0f
+
+// NOTE: Builds the initial state of one episode, `rng` is advanced by the callee
+typedef void (*EnvSetup)(Game *game, Rng *rng);
+void DefaultEnvSetup(Game *game, Rng *rng);
+
+struct VecEnv {
+    VecEnv(uint32_t count, uint32_t thread_count, uint32_t frame_skip, uint32_t seed, EnvSetup setup);
+    ~VecEnv();
+    VecEnv(const VecEnv&) = delete;
+    VecEnv& operator=(const VecEnv&) = delete;
+
+    void Reset();
+    void Step(const uint8_t *actions); // NOTE: actions[count], GameInput bits for paddle 0
+    void stats() const;
+
+    Game *games;
+    uint32_t count;
+    uint32_t frame_skip; // NOTE: ticks per Step, the action is repeated
+    EnvSetup setup;
+    Rng *rngs; // NOTE: one stream per env, split off the constructor seed
+
+    // NOTE: Observations, valid after Reset and every Step
+    float *ball_x;
+    float *ball_y;
+    float *ball_vx;
+    float *ball_vy;
+    float *paddle_x;
+    float *bricks_left; // NOTE: fraction of the episode's bricks still standing
+    // NOTE: Outcome of the last Step, an env with done set has already been reset
+    float *reward;
+    uint8_t *done;
+    uint32_t *brick_total;
+    uint32_t capacity;
+
+    uint64_t ticks;    // NOTE: game ticks over all envs
+    uint64_t episodes; // NOTE: finished episodes over all envs
+
+    // NOTE: Worker pool, thread 0 is the caller
+    std::thread *threads;
+    uint32_t thread_count;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable finished;
+    uint64_t generation;
+    uint32_t running;
+    const uint8_t *pending_actions;
+    bool quit;
+};
+
+#endif // VECENV_H_
@@ -0,0 +1,40 @@
+// assetpack: packs files into the asset pack format (see src/asset_pack.hpp)
+// that the game embeds. Each file is stored under the path it was given, so
+// run it from the directory the game resolves asset paths against.
+//
+// Usage: assetpack <output.pak> <file>...
+
+#include "../src/asset_pack.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <output.pak> <file>...\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t count = (uint32_t)(argc - 2);
+    const Asset **files = (const Asset**)calloc(count + 1, sizeof(const Asset*));
+    AssetView *contents = (AssetView*)calloc(count + 1, sizeof(AssetView));
+    bool ok = files != nullptr && contents != nullptr;
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; ok && i < count; ++i) {
+        files[i] = assets.Acquire(argv[i + 2]);
+        ok = files[i] != nullptr;
+        if (ok) {
+            contents[i] = files[i]->view;
+            bytes += contents[i].size;
+        }
+    }
+    ok = ok && WriteAssetPack(argv[1], (const char *const*)argv + 2, contents, count);
+    for (uint32_t i = 0; files && i < count; ++i) assets.Release(files[i]);
+    free(files);
+    free(contents);
+    if (!ok) return 1;
+
+    printf("%s: %u assets, %lu bytes\n", argv[1], count, (unsigned long)bytes);
+    return 0;
+}
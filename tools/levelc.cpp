@@ -0,0 +1,140 @@
+// levelc: compiles the text level format (see levels/level1.txt) to the binary
+// level format loaded by LoadLevel.
+//
+// Usage: levelc <input.txt> <output.lvl>
+
+#include "../src/game.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+#define LINE_MAX_LENGTH 4096
+
+struct LegendEntry {
+    bool defined;
+    uint8_t hp;
+    uint8_t type;
+    uint8_t color;
+};
+
+struct LevelSource {
+    uint32_t cols;
+    uint32_t rows;
+    float origin_x;
+    float origin_y;
+    float cell_w;
+    float cell_h;
+    float brick_w;
+    float brick_h;
+    LegendEntry legend[256];
+};
+
+static char *trim(char *line)
+{
+    while (isspace((unsigned char)*line)) line++;
+    char *comment = strchr(line, '#');
+    if (comment) *comment = '\0';
+    size_t len = strlen(line);
+    while (len > 0 && isspace((unsigned char)line[len - 1])) line[--len] = '\0';
+    return line;
+}
+
+static bool parse_directive(LevelSource *source, const char *line, const char *path, int line_number)
+{
+    char c;
+    unsigned hp, type, color;
+    if (sscanf(line, "size %u %u", &source->cols, &source->rows) == 2) return true;
+    if (sscanf(line, "origin %f %f", &source->origin_x, &source->origin_y) == 2) return true;
+    if (sscanf(line, "cell %f %f", &source->cell_w, &source->cell_h) == 2) return true;
+    if (sscanf(line, "brick %f %f", &source->brick_w, &source->brick_h) == 2) return true;
+    if (sscanf(line, "legend %c %u %u %u", &c, &hp, &type, &color) == 4) {
+        if (c == '.' || hp == 0 || hp > 255 || type >= LEVEL_MAX_TYPES || color >= LEVEL_MAX_COLORS) {
+            fprintf(stderr, "%s:%d: invalid legend entry.\n", path, line_number);
+            return false;
+        }
+        source->legend[(unsigned char)c] = {true, (uint8_t)hp, (uint8_t)type, (uint8_t)color};
+        return true;
+    }
+    fprintf(stderr, "%s:%d: unknown directive \"%s\".\n", path, line_number, line);
+    return false;
+}
+
+static bool compile_level(FILE *fp, const char *path, Game *game, LevelInfo *info)
+{
+    LevelSource source = {};
+    char buffer[LINE_MAX_LENGTH];
+    int line_number = 0;
+    bool in_grid = false;
+    uint32_t row = 0;
+
+    while (fgets(buffer, sizeof(buffer), fp)) {
+        line_number++;
+        char *line = trim(buffer);
+        if (*line == '\0') continue;
+
+        if (!in_grid) {
+            if (strcmp(line, "grid") == 0) {
+                if (source.cols == 0 || source.rows == 0) {
+                    fprintf(stderr, "%s:%d: grid before size.\n", path, line_number);
+                    return false;
+                }
+                in_grid = true;
+            } else if (!parse_directive(&source, line, path, line_number)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (row >= source.rows || strlen(line) != source.cols) {
+            fprintf(stderr, "%s:%d: grid row does not match size %ux%u.\n", path, line_number, source.cols, source.rows);
+            return false;
+        }
+        for (uint32_t col = 0; col < source.cols; ++col) {
+            unsigned char c = line[col];
+            if (c == '.') continue;
+            const LegendEntry *entry = &source.legend[c];
+            if (!entry->defined) {
+                fprintf(stderr, "%s:%d: '%c' is not in the legend.\n", path, line_number, c);
+                return false;
+            }
+            float x = source.origin_x + col * source.cell_w;
+            float y = source.origin_y - row * source.cell_h;
+            game->AddBrick(x, y, source.brick_w, source.brick_h, entry->hp, entry->type, entry->color);
+        }
+        row++;
+    }
+
+    if (row != source.rows) {
+        fprintf(stderr, "%s: expected %u grid rows, got %u.\n", path, source.rows, row);
+        return false;
+    }
+    info->cols = source.cols;
+    info->rows = source.rows;
+    info->brick_count = game->bricks.count;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input.txt> <output.lvl>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *fp = fopen(argv[1], "r");
+    if (fp == nullptr) {
+        fprintf(stderr, "Failed to open %s.\n", argv[1]);
+        return 1;
+    }
+
+    Game game;
+    LevelInfo info = {};
+    bool ok = compile_level(fp, argv[1], &game, &info);
+    fclose(fp);
+    if (!ok || !SaveLevel(&game.bricks, &info, argv[2])) return 1;
+
+    printf("%s: %ux%u grid, %u bricks\n", argv[2], info.cols, info.rows, info.brick_count);
+    return 0;
+}
@@ -0,0 +1,130 @@
+// netplay: headless rollback peer for testing two processes over loopback.
+//
+// Both peers play a scripted input sequence for --ticks ticks at 60 Hz, then
+// wait until every remote input is confirmed and print a checksum of the
+// final state, which must match between the two processes.
+//
+// Usage: netplay --player <0|1> --port <local port> --peer <host:port>
+//                [--ticks n] [--input-delay n] [--delay ms] [--jitter ms] [--loss p] [--level file.lvl]
+//
+//   ./build/netplay --player 0 --port 7000 --peer 127.0.0.1:7001 --delay 40 --loss 0.1 &
+//   ./build/netplay --player 1 --port 7001 --peer 127.0.0.1:7000 --delay 40 --loss 0.1
+
+#include "../src/rollback.hpp"
+#include "../src/net.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+#define LINGER_TICKS (2 * FPS) // NOTE: keep answering so the peer can confirm our last inputs
+
+static uint64_t now_us(void)
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint8_t script_input(uint32_t player, uint64_t tick)
+{
+    uint32_t x = (uint32_t)(tick / 11) * 2654435761u + player * 40503u + 12345u;
+    x ^= x >> 15;
+    x *= 2246822519u;
+    x ^= x >> 13;
+    return (uint8_t)(x % 3);
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s --player <0|1> --port <local port> --peer <host:port> [--ticks n] [--input-delay n]\n"
+                    "          [--delay ms] [--jitter ms] [--loss p] [--level file.lvl]\n", program);
+}
+
+int main(int argc, char **argv)
+{
+    int player = -1;
+    long port = 0;
+    const char *peer = nullptr;
+    const char *level_path = nullptr;
+    uint64_t ticks = 600;
+    uint32_t input_delay = 2;
+    double delay_ms = 0.0, jitter_ms = 0.0, loss = 0.0;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) { usage(argv[0]); return 1; }
+        const char *value = argv[++i];
+        if (strcmp(argv[i - 1], "--player") == 0) player = atoi(value);
+        else if (strcmp(argv[i - 1], "--port") == 0) port = strtol(value, nullptr, 10);
+        else if (strcmp(argv[i - 1], "--peer") == 0) peer = value;
+        else if (strcmp(argv[i - 1], "--ticks") == 0) ticks = strtoull(value, nullptr, 10);
+        else if (strcmp(argv[i - 1], "--input-delay") == 0) input_delay = (uint32_t)atoi(value);
+        else if (strcmp(argv[i - 1], "--delay") == 0) delay_ms = atof(value);
+        else if (strcmp(argv[i - 1], "--jitter") == 0) jitter_ms = atof(value);
+        else if (strcmp(argv[i - 1], "--loss") == 0) loss = atof(value);
+        else if (strcmp(argv[i - 1], "--level") == 0) level_path = value;
+        else { usage(argv[0]); return 1; }
+    }
+    char host[64];
+    uint16_t peer_port = 0;
+    if ((player != 0 && player != 1) || port <= 0 || port > 65535 || peer == nullptr ||
+        !parse_address(peer, host, sizeof(host), &peer_port)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    UdpTransport transport;
+    if (!transport.Open((uint16_t)port) || !transport.SetPeer(host, peer_port)) return 1;
+    transport.delay = (uint64_t)(delay_ms * 1000.0);
+    transport.jitter = (uint64_t)(jitter_ms * 1000.0);
+    transport.loss = (float)loss;
+    transport.rng.Seed(0x9E3779B9u + (uint32_t)player);
+
+    Game game;
+    game.AddBall(0.0f, 0.0f, 0.05f, 1.0f, 1.0f);
+    game.AddPaddle(0.0f, -0.9f, 0.4f, 0.05f, 2.0f);
+    game.AddPaddle(0.0f, 0.9f, 0.4f, 0.05f, 2.0f);
+    if (level_path && !LoadLevel(&game, level_path, nullptr)) return 1;
+
+    RollbackSession session((uint32_t)player, input_delay);
+    const uint64_t tick_us = 1000000u / FPS;
+    uint64_t next = now_us();
+    uint64_t linger = 0;
+    uint64_t worst_frame_us = 0;
+    uint8_t buffer[NET_MAX_PACKET];
+    while (linger < LINGER_TICKS) {
+        uint64_t now = now_us();
+        if (now < next) {
+            usleep((useconds_t)(next - now));
+            continue;
+        }
+        next += tick_us;
+
+        int size;
+        while ((size = transport.Receive(buffer, sizeof(buffer), now)) > 0) session.ReadPacket(buffer, (size_t)size);
+
+        if (session.local_next < ticks) session.AddLocalInput(script_input((uint32_t)player, session.local_next));
+        uint64_t start = now_us();
+        session.AdvanceFrame(&game);
+        uint64_t frame_us = now_us() - start;
+        if (frame_us > worst_frame_us) worst_frame_us = frame_us;
+
+        RollbackPacket packet;
+        size_t packet_size = session.BuildPacket(&packet);
+        transport.Send(&packet, packet_size, now);
+
+        bool settled = session.current == ticks && session.remote_confirmed >= ticks &&
+                       session.rollback_from == UINT64_MAX && session.remote_ack >= ticks;
+        if (settled) linger++;
+    }
+
+    StateBuffer state = {};
+    SaveState(&game, &state);
+    printf("player %d: tick %lu score %u checksum %08x\n", player, (unsigned long)game.tick, game.score, StateChecksum(&state));
+    printf("    Slowest frame (including rollbacks): %.3f ms\n", worst_frame_us / 1000.0);
+    session.stats();
+    transport.stats();
+    state_buffer_free(&state);
+    return session.desyncs == 0 ? 0 : 1;
+}
@@ -502,3 +502,8 @@ Matrix4 Matrix4::translate(const Vector4& vec4) const
         .setElement(1, 3, vec4.getY())
         .setElement(2, 3, vec4.getZ());
 }
+
+const float *Matrix4::getData() const
+{
+    return &rows[0][0];
+}
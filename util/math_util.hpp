@@ -101,7 +101,7 @@ public:
 // Matrix4
 #define MAT4_ROWS 4
 #define MAT4_COLS 4
-#define PI 3.14593f
+#define PI 3.14159265f
 #define EPSILION 0.15f
 #define ROT_EPSILION 1e-5f
 
@@ -127,6 +127,7 @@ public:
     bool operator!=(const Matrix4& other) const;
     Vector4 transform(const Vector4& vec4) const;
     Matrix4 translate(const Vector4& vec4) const;
+    const float *getData() const; // NOTE: row-major, upload with transpose = GL_TRUE
 private:
     float rows[MAT4_ROWS][MAT4_COLS];
 };